@@ -57,6 +57,8 @@ build_native() {
     echo "Native build complete."
     echo "  Daemon: $BUILD_DIR/bin/capframex-daemon"
     echo "  Layer:  $BUILD_DIR/lib/libcapframex_layer.so"
+    echo "  GL:     $BUILD_DIR/lib/libcapframex_gl.so"
+    echo "  PIDs:   $BUILD_DIR/lib/libcapframex_pids.so"
     echo ""
 }
 
@@ -37,6 +37,19 @@ install -Dm755 "$BUILD_DIR/bin/capframex-daemon" "$BINDIR/capframex-daemon"
 echo "Installing Vulkan layer..."
 install -Dm755 "$BUILD_DIR/lib/libcapframex_layer.so" "$LIBDIR/libcapframex_layer.so"
 
+# Install OpenGL capture library (loaded with LD_PRELOAD)
+if [ -f "$BUILD_DIR/lib/libcapframex_gl.so" ]; then
+    echo "Installing OpenGL capture library..."
+    install -Dm755 "$BUILD_DIR/lib/libcapframex_gl.so" "$LIBDIR/libcapframex_gl.so"
+fi
+
+# Install shared PID list reader library for overlays and tools
+if [ -f "$BUILD_DIR/lib/libcapframex_pids.so" ]; then
+    echo "Installing PID list reader library..."
+    install -Dm755 "$BUILD_DIR/lib/libcapframex_pids.so" "$LIBDIR/libcapframex_pids.so"
+    install -Dm644 "$PROJECT_ROOT/src/pidlist/capframex_pids.h" "$PREFIX/include/capframex_pids.h"
+fi
+
 # Install layer manifest
 echo "Installing layer manifest..."
 mkdir -p "$DATADIR/vulkan/implicit_layer.d"
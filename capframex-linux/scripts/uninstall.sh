@@ -28,6 +28,9 @@ echo "Removing files..."
 rm -f "$BINDIR/capframex-daemon"
 rm -f "$BINDIR/capframex"
 rm -f "$LIBDIR/libcapframex_layer.so"
+rm -f "$LIBDIR/libcapframex_gl.so"
+rm -f "$LIBDIR/libcapframex_pids.so"
+rm -f "$PREFIX/include/capframex_pids.h"
 rm -f "$DATADIR/vulkan/implicit_layer.d/capframex_layer.json"
 rm -f /usr/lib/systemd/user/capframex-daemon.service
 rm -f "$DATADIR/applications/capframex.desktop"
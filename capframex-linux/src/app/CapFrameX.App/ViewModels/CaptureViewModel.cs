@@ -30,6 +30,8 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
     private readonly IDisposable _gameUpdatedSub;
     private readonly IDisposable _gameExitedSub;
     private readonly IDisposable _frameDataSub;
+    private readonly IDisposable _layerOverheadSub;
+    private readonly IDisposable _frameHistorySub;
     private readonly IDisposable _hotkeySub;
     private readonly IDisposable _settingsSub;
     private readonly System.Timers.Timer _statsTimer;
@@ -292,6 +294,7 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
                     if (!string.IsNullOrEmpty(update.Launcher))
                         game.Launcher = update.Launcher;
                     game.PresentTimingSupported = update.PresentTimingSupported;
+                    game.GraphicsApi = update.GraphicsApi;
 
                     // If this is the selected game, notify computed properties
                     if (SelectedGame?.Pid == update.Pid)
@@ -329,6 +332,16 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
             });
         });
 
+        _layerOverheadSub = _captureService.LayerOverhead.Subscribe(stats =>
+        {
+            _frametimeReceiver.SetLayerOverhead(stats);
+        });
+
+        _frameHistorySub = _captureService.FrameHistory.Subscribe(chunk =>
+        {
+            _frametimeReceiver.AddHistory(chunk);
+        });
+
         // Stats update timer
         _statsTimer = new System.Timers.Timer(500);
         _statsTimer.Elapsed += (_, _) => UpdateLiveStats();
@@ -558,16 +571,23 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
 
         Console.WriteLine($"[CaptureVM] Starting capture for {targetGame.Name} (PID {targetGame.Pid})");
 
-        // Start recording frames (don't clear chart - it runs independently)
-        _frametimeReceiver.StartCapture();
+        // Start recording frames (don't clear chart - it runs independently).
+        // A retroactive capture begins with the daemon's replay of the last seconds.
+        var settings = _settingsService.Settings;
+        var historyMs = (uint)Math.Max(0, settings.RetroactiveCaptureSeconds) * 1000;
+        _frametimeReceiver.StartCapture(awaitHistory: historyMs > 0);
 
         // If live view is already active for the same game, we're already subscribed
         // Otherwise, subscribe now
         if (!_isLiveViewActive || _captureService.CapturingPid != targetGame.Pid)
         {
-            await _captureService.StartCaptureAsync(targetGame.Pid);
+            await _captureService.StartCaptureAsync(targetGame.Pid, historyMs);
             _isLiveViewActive = true; // Mark as active since we just started
         }
+        else if (historyMs > 0)
+        {
+            await _captureService.RequestHistoryAsync(historyMs);
+        }
 
         IsCapturing = true;
         CaptureButtonText = "Stop Capture";
@@ -575,7 +595,6 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
 
         // Start capture timer display
         _captureStartTime = DateTime.Now;
-        var settings = _settingsService.Settings;
         _captureTargetSeconds = settings.AutoStopEnabled ? settings.CaptureDurationSeconds : 0;
         ShowCaptureTimer = true;
         UpdateCaptureTimeDisplay(); // Initial update
@@ -626,6 +645,7 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
                 TimingMode = SelectedGame?.TimingMode ?? "Layer Timing",
                 StartTime = DateTime.Now.AddMilliseconds(-frames.Sum(f => f.FrametimeMs)),
                 EndTime = DateTime.Now,
+                LayerOverhead = _frametimeReceiver.LayerOverhead,
                 Frames = frames.ToList()
             };
 
@@ -642,6 +662,8 @@ public partial class CaptureViewModel : ObservableObject, IDisposable
         _gameUpdatedSub.Dispose();
         _gameExitedSub.Dispose();
         _frameDataSub.Dispose();
+        _layerOverheadSub.Dispose();
+        _frameHistorySub.Dispose();
         _hotkeySub.Dispose();
         _settingsSub.Dispose();
         _statsTimer.Dispose();
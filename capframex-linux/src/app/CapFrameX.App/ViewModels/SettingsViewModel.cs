@@ -19,6 +19,9 @@ public partial class SettingsViewModel : ObservableObject
     [ObservableProperty]
     private bool _autoStopEnabled;
 
+    [ObservableProperty]
+    private decimal? _retroactiveCaptureSeconds;
+
     [ObservableProperty]
     private bool _isRecordingHotkey;
 
@@ -35,6 +38,7 @@ public partial class SettingsViewModel : ObservableObject
         _captureHotkey = settings.CaptureHotkey;
         _captureDurationSeconds = settings.CaptureDurationSeconds;
         _autoStopEnabled = settings.AutoStopEnabled;
+        _retroactiveCaptureSeconds = settings.RetroactiveCaptureSeconds;
 
         UpdateHotkeyStatus();
     }
@@ -56,6 +60,12 @@ public partial class SettingsViewModel : ObservableObject
         SaveSettings();
     }
 
+    partial void OnRetroactiveCaptureSecondsChanged(decimal? value)
+    {
+        if (value.HasValue)
+            SaveSettings();
+    }
+
     private void SaveSettings()
     {
         _settingsService.UpdateSettings(settings =>
@@ -63,6 +73,7 @@ public partial class SettingsViewModel : ObservableObject
             settings.CaptureHotkey = CaptureHotkey;
             settings.CaptureDurationSeconds = (int)(CaptureDurationSeconds ?? 0);
             settings.AutoStopEnabled = AutoStopEnabled;
+            settings.RetroactiveCaptureSeconds = (int)(RetroactiveCaptureSeconds ?? 0);
         });
     }
 
@@ -16,6 +16,8 @@ public class CaptureService : IDisposable
     private readonly Subject<GameInfo> _gameUpdated = new();
     private readonly Subject<int> _gameExited = new();
     private readonly Subject<FrameDataPoint> _frameData = new();
+    private readonly Subject<FrameHistoryChunk> _frameHistory = new();
+    private readonly Subject<LayerOverheadStats> _layerOverhead = new();
     private readonly Subject<bool> _connectionStatus = new();
     private readonly Subject<List<string>> _ignoreListReceived = new();
     private readonly Subject<bool> _ignoreListUpdated = new();
@@ -45,6 +47,7 @@ public class CaptureService : IDisposable
                 if (!string.IsNullOrEmpty(game.Launcher))
                     existing.Launcher = game.Launcher;
                 existing.PresentTimingSupported = game.PresentTimingSupported;
+                existing.GraphicsApi = game.GraphicsApi;
                 _gameUpdated.OnNext(existing);
             }
             else
@@ -66,6 +69,7 @@ public class CaptureService : IDisposable
                 if (!string.IsNullOrEmpty(update.Launcher))
                     existing.Launcher = update.Launcher;
                 existing.PresentTimingSupported = update.PresentTimingSupported;
+                existing.GraphicsApi = update.GraphicsApi;
             }
             _gameUpdated.OnNext(update);
         };
@@ -87,6 +91,9 @@ public class CaptureService : IDisposable
             _frameData.OnNext(frame);
         };
 
+        _client.FrameHistoryReceived += (_, chunk) => _frameHistory.OnNext(chunk);
+        _client.LayerOverheadReceived += (_, stats) => _layerOverhead.OnNext(stats);
+
         _client.Connected += (_, _) => _connectionStatus.OnNext(true);
         _client.Disconnected += (_, _) => _connectionStatus.OnNext(false);
 
@@ -98,6 +105,8 @@ public class CaptureService : IDisposable
     public IObservable<GameInfo> GameUpdated => _gameUpdated.AsObservable();
     public IObservable<int> GameExited => _gameExited.AsObservable();
     public IObservable<FrameDataPoint> FrameData => _frameData.AsObservable();
+    public IObservable<FrameHistoryChunk> FrameHistory => _frameHistory.AsObservable();
+    public IObservable<LayerOverheadStats> LayerOverhead => _layerOverhead.AsObservable();
     public IObservable<bool> ConnectionStatus => _connectionStatus.AsObservable();
     public IObservable<List<string>> IgnoreListReceived => _ignoreListReceived.AsObservable();
     public IObservable<bool> IgnoreListUpdated => _ignoreListUpdated.AsObservable();
@@ -270,12 +279,12 @@ public class CaptureService : IDisposable
         await _client.DisconnectAsync();
     }
 
-    public async Task StartCaptureAsync(int pid)
+    public async Task StartCaptureAsync(int pid, uint historyMs = 0)
     {
         if (_isCapturing)
             throw new InvalidOperationException("Already capturing");
 
-        await _client.SendStartCaptureAsync(pid);
+        await _client.SendStartCaptureAsync(pid, historyMs);
         _isCapturing = true;
         _capturingPid = pid;
 
@@ -304,6 +313,35 @@ public class CaptureService : IDisposable
         _capturingPid = 0;
     }
 
+    /// <summary>
+    /// Replay the last historyMs of the subscribed game's frames (FrameHistory)
+    /// without interrupting the live stream
+    /// </summary>
+    public async Task RequestHistoryAsync(uint historyMs)
+    {
+        if (!_isCapturing)
+            throw new InvalidOperationException("Not subscribed");
+
+        await _client.SendStartCaptureAsync(_capturingPid, historyMs);
+    }
+
+    /// <summary>
+    /// Change how much a running game's layer records. Layers loaded with
+    /// CAPFRAMEX_CAPTURE_TIER=off are not connected and can't be changed.
+    /// </summary>
+    public async Task SetCaptureTierAsync(int pid, CaptureTier tier)
+    {
+        await _client.SendCaptureTierAsync(pid, tier);
+    }
+
+    /// <summary>
+    /// Cap a running game's frame rate in the layer (0 = uncapped)
+    /// </summary>
+    public async Task SetFrameLimitAsync(int pid, float fpsLimit)
+    {
+        await _client.SendFrameLimitAsync(pid, fpsLimit);
+    }
+
     public async Task AddToIgnoreListAsync(string processName)
     {
         await _client.AddToIgnoreListAsync(processName);
@@ -344,6 +382,8 @@ public class CaptureService : IDisposable
         _gameUpdated.Dispose();
         _gameExited.Dispose();
         _frameData.Dispose();
+        _frameHistory.Dispose();
+        _layerOverhead.Dispose();
         _connectionStatus.Dispose();
         _ignoreListReceived.Dispose();
         _ignoreListUpdated.Dispose();
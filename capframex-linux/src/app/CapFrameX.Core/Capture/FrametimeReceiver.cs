@@ -13,10 +13,19 @@ public class FrametimeReceiver : IDisposable
     private readonly List<FrameData> _frameBuffer = new();
     private readonly object _bufferLock = new();
 
+    private LayerOverheadStats? _layerOverhead;
     private ulong _frameCount;
     private DateTime _captureStartTime;
     private bool _isCapturing;
 
+    // Retroactive capture: live frames are held back until the daemon's replay
+    // (which contains them) completes. Older daemons never replay, so the held
+    // frames are kept after HistoryTimeout.
+    private readonly List<FrameData> _pendingLiveFrames = new();
+    private bool _awaitingHistory;
+    private DateTime _historyRequestTime;
+    private static readonly TimeSpan HistoryTimeout = TimeSpan.FromSeconds(2);
+
     // Rolling statistics for live display
     private readonly Queue<float> _recentFrametimes = new();
     private const int RecentFrameCount = 300; // ~5 seconds at 60fps
@@ -24,37 +33,100 @@ public class FrametimeReceiver : IDisposable
     public IObservable<FrameData> Frames => _frameSubject.AsObservable();
     public bool IsCapturing => _isCapturing;
     public int BufferedFrameCount => _frameBuffer.Count;
+    public LayerOverheadStats? LayerOverhead => _layerOverhead;
     public TimeSpan CaptureDuration => _isCapturing ? DateTime.Now - _captureStartTime : TimeSpan.Zero;
 
-    public void StartCapture()
+    /// <summary>
+    /// Start buffering frames. With awaitHistory the capture begins with the
+    /// frames passed to AddHistory (the history must be requested right after).
+    /// </summary>
+    public void StartCapture(bool awaitHistory = false)
     {
         lock (_bufferLock)
         {
             _frameBuffer.Clear();
+            _pendingLiveFrames.Clear();
             _recentFrametimes.Clear();
+            _layerOverhead = null;
             _frameCount = 0;
             _captureStartTime = DateTime.Now;
+            _awaitingHistory = awaitHistory;
+            _historyRequestTime = DateTime.Now;
             _isCapturing = true;
         }
     }
 
     public void StopCapture()
     {
-        _isCapturing = false;
+        lock (_bufferLock)
+        {
+            if (_awaitingHistory)
+            {
+                FinishHistory(keepPendingFrames: true);
+            }
+            _isCapturing = false;
+        }
     }
 
-    public void AddFrame(FrameDataPoint point)
+    /// <summary>
+    /// Add replayed frames to a capture started with awaitHistory
+    /// </summary>
+    public void AddHistory(FrameHistoryChunk chunk)
+    {
+        lock (_bufferLock)
+        {
+            if (!_isCapturing || !_awaitingHistory)
+                return;
+
+            foreach (var point in chunk.Frames)
+            {
+                _frameBuffer.Add(ToFrameData(point));
+                _frameCount++;
+            }
+
+            if (chunk.Complete)
+            {
+                FinishHistory(keepPendingFrames: false);
+            }
+        }
+    }
+
+    // Caller holds _bufferLock
+    private void FinishHistory(bool keepPendingFrames)
+    {
+        if (keepPendingFrames)
+        {
+            _frameBuffer.AddRange(_pendingLiveFrames);
+            _frameCount += (ulong)_pendingLiveFrames.Count;
+        }
+        _pendingLiveFrames.Clear();
+        _awaitingHistory = false;
+    }
+
+    private static FrameData ToFrameData(FrameDataPoint point)
     {
         // Store both CPU sampled and actual frametime (actual is 0 if extension not available)
-        var frame = new FrameData
+        return new FrameData
         {
             FrameNumber = point.FrameNumber,
             TimestampNs = point.TimestampNs,
             FrametimeMs = point.FrametimeMs,
             MsUntilRenderComplete = point.MsUntilRenderComplete,
             MsUntilDisplayed = point.MsUntilDisplayed,
-            ActualFrametimeMs = point.ActualFrametimeMs
+            ActualFrametimeMs = point.ActualFrametimeMs,
+            SwapchainId = point.SwapchainId,
+            AcquireWaitMs = point.AcquireWaitMs,
+            AcquireToPresentMs = point.AcquireToPresentMs,
+            GpuActiveMs = point.GpuActiveMs,
+            LimiterErrorMs = point.LimiterErrorMs,
+            DisplayState = point.DisplayState,
+            MissedVblanks = point.MissedVblanks
         };
+    }
+
+    public void AddFrame(FrameDataPoint point)
+    {
+        var frame = ToFrameData(point);
 
         lock (_bufferLock)
         {
@@ -66,8 +138,18 @@ public class FrametimeReceiver : IDisposable
                 _recentFrametimes.Dequeue();
             }
 
+            if (_awaitingHistory && DateTime.Now - _historyRequestTime > HistoryTimeout)
+            {
+                Console.WriteLine("[FrametimeReceiver] No frame history received - capturing live only");
+                FinishHistory(keepPendingFrames: true);
+            }
+
             // Only buffer frames when capturing
-            if (_isCapturing)
+            if (_isCapturing && _awaitingHistory)
+            {
+                _pendingLiveFrames.Add(frame);
+            }
+            else if (_isCapturing)
             {
                 _frameBuffer.Add(frame);
                 _frameCount++;
@@ -77,6 +159,20 @@ public class FrametimeReceiver : IDisposable
         _frameSubject.OnNext(frame);
     }
 
+    /// <summary>
+    /// Keep the latest layer overhead report of the captured process
+    /// </summary>
+    public void SetLayerOverhead(LayerOverheadStats stats)
+    {
+        lock (_bufferLock)
+        {
+            if (_isCapturing)
+            {
+                _layerOverhead = stats;
+            }
+        }
+    }
+
     public IReadOnlyList<FrameData> GetCapturedFrames()
     {
         lock (_bufferLock)
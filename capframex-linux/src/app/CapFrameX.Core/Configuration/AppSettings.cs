@@ -19,4 +19,10 @@ public class AppSettings
     /// Whether auto-stop is enabled
     /// </summary>
     public bool AutoStopEnabled { get; set; } = false;
+
+    /// <summary>
+    /// Seconds before the hotkey press to include in a capture, taken from the
+    /// daemon's frame history. 0 = capture starts at the press
+    /// </summary>
+    public int RetroactiveCaptureSeconds { get; set; } = 0;
 }
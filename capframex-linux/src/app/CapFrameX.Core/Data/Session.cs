@@ -1,5 +1,6 @@
 using System.Globalization;
 using System.Text.Json;
+using System.Text.Json.Serialization;
 using CapFrameX.Shared.Models;
 
 namespace CapFrameX.Core.Data;
@@ -41,6 +42,7 @@ public static class SessionIO
                     session.TimingMode = metadata.TimingMode ?? string.Empty;
                     session.StartTime = DateTimeOffset.FromUnixTimeSeconds(metadata.StartTime).LocalDateTime;
                     session.EndTime = DateTimeOffset.FromUnixTimeSeconds(metadata.EndTime).LocalDateTime;
+                    session.LayerOverhead = metadata.LayerOverhead;
                 }
             }
             catch (Exception ex)
@@ -50,7 +52,7 @@ public static class SessionIO
         }
 
         // Load CSV frame data
-        // Format: MsBetweenPresents,MsUntilRenderComplete,MsUntilDisplayed,MsActualPresent
+        // Format: MsBetweenPresents,MsUntilRenderComplete,MsUntilDisplayed,MsActualPresent[,Dropped,MissedVblanks]
         var lines = await File.ReadAllLinesAsync(csvPath);
         ulong frameNumber = 0;
         ulong timestamp = 0;
@@ -65,6 +67,22 @@ public static class SessionIO
                 float.TryParse(parts[3], NumberStyles.Float, CultureInfo.InvariantCulture, out var actualFrametime))
             {
                 timestamp += (ulong)(frametime * 1_000_000); // Convert ms to ns
+
+                // Older captures have no display columns
+                var displayState = FrameDisplayState.Unknown;
+                uint missedVblanks = 0;
+                if (parts.Length >= 6 &&
+                    int.TryParse(parts[4], NumberStyles.Integer, CultureInfo.InvariantCulture, out var dropped) &&
+                    uint.TryParse(parts[5], NumberStyles.Integer, CultureInfo.InvariantCulture, out missedVblanks))
+                {
+                    if (dropped == 1)
+                        displayState = FrameDisplayState.Dropped;
+                    else if (missedVblanks > 0)
+                        displayState = FrameDisplayState.Repeated;
+                    else if (msUntilDisplayed > 0 || actualFrametime > 0)
+                        displayState = FrameDisplayState.Displayed;
+                }
+
                 session.Frames.Add(new FrameData
                 {
                     FrameNumber = frameNumber++,
@@ -72,7 +90,9 @@ public static class SessionIO
                     FrametimeMs = frametime,
                     MsUntilRenderComplete = msUntilRenderComplete,
                     MsUntilDisplayed = msUntilDisplayed,
-                    ActualFrametimeMs = actualFrametime
+                    ActualFrametimeMs = actualFrametime,
+                    DisplayState = displayState,
+                    MissedVblanks = missedVblanks
                 });
             }
         }
@@ -91,17 +111,20 @@ public static class SessionIO
         // Save CSV with both CPU sampled and actual present timing
         using (var writer = new StreamWriter(csvPath))
         {
-            // Header: CPU sampled frametime, render complete, displayed, actual present timing
-            await writer.WriteLineAsync("MsBetweenPresents,MsUntilRenderComplete,MsUntilDisplayed,MsActualPresent");
+            // Header: CPU sampled frametime, render complete, displayed, actual present timing,
+            // never displayed (PresentMon's Dropped), refreshes the previous frame was repeated
+            await writer.WriteLineAsync("MsBetweenPresents,MsUntilRenderComplete,MsUntilDisplayed,MsActualPresent,Dropped,MissedVblanks");
             foreach (var frame in session.Frames)
             {
                 await writer.WriteLineAsync(string.Format(
                     CultureInfo.InvariantCulture,
-                    "{0:F2},{1:F2},{2:F2},{3:F2}",
+                    "{0:F2},{1:F2},{2:F2},{3:F2},{4},{5}",
                     frame.FrametimeMs,
                     frame.MsUntilRenderComplete,
                     frame.MsUntilDisplayed,
-                    frame.ActualFrametimeMs));
+                    frame.ActualFrametimeMs,
+                    frame.DisplayState == FrameDisplayState.Dropped ? 1 : 0,
+                    frame.MissedVblanks));
             }
         }
 
@@ -115,7 +138,8 @@ public static class SessionIO
             StartTime = new DateTimeOffset(session.StartTime).ToUnixTimeSeconds(),
             EndTime = new DateTimeOffset(session.EndTime).ToUnixTimeSeconds(),
             DurationSeconds = (long)session.Duration.TotalSeconds,
-            FrameCount = session.FrameCount
+            FrameCount = session.FrameCount,
+            LayerOverhead = session.LayerOverhead
         };
 
         var jsonContent = JsonSerializer.Serialize(metadata, JsonOptions);
@@ -134,5 +158,7 @@ public static class SessionIO
         public long EndTime { get; set; }
         public long DurationSeconds { get; set; }
         public int FrameCount { get; set; }
+        [JsonIgnore(Condition = JsonIgnoreCondition.WhenWritingNull)]
+        public LayerOverheadStats? LayerOverhead { get; set; }  // Layer present overhead (omitted if never reported)
     }
 }
@@ -26,6 +26,44 @@ public enum MessageType : uint
     IgnoreListResponse = 17,
     IgnoreListUpdated = 18,
     GameUpdated = 19,
+    FrametimeBatch = 20,
+    HelloAck = 21,
+    LayerOverheadStats = 22,
+    FrameLimit = 23,
+    FrameHistory = 24,
+    DisplayTiming = 25,
+    DisplayVblanks = 26,
+}
+
+/// <summary>
+/// How much a layer records (must match CaptureTier in daemon/common.h)
+/// </summary>
+public enum CaptureTier : uint
+{
+    Off = 0,         // Pure passthrough
+    Timestamps = 1,  // CPU present/acquire timestamps only
+    Full = 2,        // Timestamps plus present timing and GPU queries
+}
+
+/// <summary>
+/// API a capture client hooks (must match GraphicsApi in daemon/common.h)
+/// </summary>
+public enum GraphicsApi : byte
+{
+    Unknown = 0,
+    Vulkan = 1,
+    OpenGlGlx = 2,
+    OpenGlEgl = 3,
+}
+
+/// <summary>
+/// Capability flags negotiated with the daemon (must match daemon/common.h)
+/// </summary>
+public static class IpcCapabilities
+{
+    public const uint FrameBatch = 1u << 0;  // Understands FrametimeBatch
+
+    public const int MaxFrameBatch = 64;
 }
 
 /// <summary>
@@ -53,7 +91,8 @@ public unsafe struct GameDetectedPayload
     public uint ResolutionWidth;
     public uint ResolutionHeight;
     public byte PresentTimingSupported;  // 1 if VK_EXT_present_timing available
-    public fixed byte Padding[3];        // Alignment padding
+    public byte GraphicsApi;             // GraphicsApi
+    public fixed byte Padding[2];        // Alignment padding
 }
 
 /// <summary>
@@ -71,7 +110,100 @@ public struct FrameDataPointIpc
     public float MsUntilRenderComplete;  // Time until render complete (0 if not available)
     public float MsUntilDisplayed;       // Time until displayed (0 if not available)
     public float ActualFrametimeMs;      // Frametime from actual present timing (0 if not available)
-    public uint Padding;                 // Alignment padding
+    public uint SwapchainId;             // Presenting swapchain, unique within Pid (0 if unknown)
+    public ulong AcquireTimeNs;          // When the presented image was acquired (0 if not available)
+    public float AcquireWaitMs;          // CPU time blocked in vkAcquireNextImageKHR
+    public float AcquireToPresentMs;     // CPU time from acquire returning to present
+    public float GpuActiveMs;            // GPU busy with the frame's submits (0 if not measured)
+    public float LimiterErrorMs;         // Layer frame limiter's release past its deadline (0 if uncapped)
+    public uint DisplayState;            // FrameDisplayState
+    public uint MissedVblanks;           // Refreshes the previous frame was repeated before this one
+}
+
+/// <summary>
+/// Frame batch header, followed by Count frames of FrameSize bytes (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct FrameBatchHeader
+{
+    public uint Count;
+    public uint FrameSize;
+}
+
+/// <summary>
+/// Layer present overhead percentiles, cumulative per process (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct LayerOverheadPayload
+{
+    public int Pid;
+    public uint Reserved;
+    public ulong SampleCount;
+    public uint P50Ns;
+    public uint P90Ns;
+    public uint P99Ns;
+    public uint P999Ns;
+    public uint MaxNs;
+    public uint MeanNs;
+}
+
+/// <summary>
+/// Reply to a DisplayTiming request: header followed by CrtcCount DisplayTimingStatsIpc
+/// (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct DisplayTimingHeader
+{
+    public uint CrtcCount;
+    public uint Reserved;
+}
+
+/// <summary>
+/// Vblank cadence of one display (CRTC) measured by the daemon (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct DisplayTimingStatsIpc
+{
+    public uint CrtcId;
+    public uint SampleCount;
+    public uint MissedVblanks;
+    public float AvgMsBetweenVblanks;
+    public float MinMsBetweenVblanks;
+    public float MaxMsBetweenVblanks;
+    public ulong LatestVblankNs;
+    public uint LatestSequence;
+    public uint Reserved;
+}
+
+/// <summary>
+/// Capture tier update, Pid 0 addresses every layer (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct CaptureConfigPayload
+{
+    public int Pid;
+    public uint CaptureTier;
+}
+
+/// <summary>
+/// Frame cap, Pid 0 addresses every layer (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct FrameLimitPayload
+{
+    public int Pid;
+    public float FpsLimit;  // 0 = uncapped
+}
+
+/// <summary>
+/// Start capture payload (must match daemon/common.h)
+/// </summary>
+[StructLayout(LayoutKind.Sequential, Pack = 1)]
+public struct StartCapturePayload
+{
+    public int Pid;
+    public uint Capabilities;
+    public uint HistoryMs;  // Replay this much of the past first (0 = live only)
 }
 
 /// <summary>
@@ -19,6 +19,9 @@ public class DaemonClient : IDisposable
     public event EventHandler<GameInfo>? GameUpdated;
     public event EventHandler<int>? GameExited;
     public event EventHandler<FrameDataPoint>? FrameDataReceived;
+    public event EventHandler<FrameHistoryChunk>? FrameHistoryReceived;
+    public event EventHandler<LayerOverheadStats>? LayerOverheadReceived;
+    public event EventHandler<IReadOnlyList<DisplayTimingStats>>? DisplayTimingReceived;
     public event EventHandler? Connected;
     public event EventHandler? Disconnected;
     public event EventHandler<List<string>>? IgnoreListReceived;
@@ -99,9 +102,18 @@ public class DaemonClient : IDisposable
         Disconnected?.Invoke(this, EventArgs.Empty);
     }
 
-    public async Task SendStartCaptureAsync(int pid)
+    /// <summary>
+    /// Subscribe to a layer's frames. With historyMs set the daemon first
+    /// replays that much of the past (FrameHistoryReceived), also when
+    /// already subscribed to the pid.
+    /// </summary>
+    public async Task SendStartCaptureAsync(int pid, uint historyMs = 0)
     {
-        await SendMessageAsync(MessageType.StartCapture, BitConverter.GetBytes(pid));
+        var payload = new byte[Marshal.SizeOf<StartCapturePayload>()];
+        BitConverter.TryWriteBytes(payload.AsSpan(0, sizeof(int)), pid);
+        BitConverter.TryWriteBytes(payload.AsSpan(sizeof(int), sizeof(uint)), IpcCapabilities.FrameBatch);
+        BitConverter.TryWriteBytes(payload.AsSpan(2 * sizeof(uint), sizeof(uint)), historyMs);
+        await SendMessageAsync(MessageType.StartCapture, payload);
     }
 
     public async Task SendStopCaptureAsync()
@@ -109,6 +121,22 @@ public class DaemonClient : IDisposable
         await SendMessageAsync(MessageType.StopCapture, Array.Empty<byte>());
     }
 
+    public async Task SendCaptureTierAsync(int pid, CaptureTier tier)
+    {
+        var payload = new byte[Marshal.SizeOf<CaptureConfigPayload>()];
+        BitConverter.TryWriteBytes(payload.AsSpan(0, sizeof(int)), pid);
+        BitConverter.TryWriteBytes(payload.AsSpan(sizeof(int), sizeof(uint)), (uint)tier);
+        await SendMessageAsync(MessageType.ConfigUpdate, payload);
+    }
+
+    public async Task SendFrameLimitAsync(int pid, float fpsLimit)
+    {
+        var payload = new byte[Marshal.SizeOf<FrameLimitPayload>()];
+        BitConverter.TryWriteBytes(payload.AsSpan(0, sizeof(int)), pid);
+        BitConverter.TryWriteBytes(payload.AsSpan(sizeof(int), sizeof(float)), fpsLimit);
+        await SendMessageAsync(MessageType.FrameLimit, payload);
+    }
+
     public async Task SendPingAsync()
     {
         await SendMessageAsync(MessageType.Ping, Array.Empty<byte>());
@@ -119,6 +147,15 @@ public class DaemonClient : IDisposable
         await SendMessageAsync(MessageType.StatusRequest, Array.Empty<byte>());
     }
 
+    /// <summary>
+    /// Ask for the daemon's display vblank stats (DisplayTimingReceived, empty
+    /// when the daemon tracks no display)
+    /// </summary>
+    public async Task RequestDisplayTimingAsync()
+    {
+        await SendMessageAsync(MessageType.DisplayTiming, Array.Empty<byte>());
+    }
+
     public async Task AddToIgnoreListAsync(string processName)
     {
         var payload = CreateIgnoreListEntryPayload(processName);
@@ -177,31 +214,45 @@ public class DaemonClient : IDisposable
 
     private async Task ReceiveLoopAsync(CancellationToken cancellationToken)
     {
-        var buffer = new byte[8192];
+        // The daemon streams messages back to back, so a single receive may
+        // contain several messages or only part of one
+        var buffer = new byte[65536];
+        var buffered = 0;
         var headerSize = Marshal.SizeOf<MessageHeader>();
 
         while (!cancellationToken.IsCancellationRequested && _socket != null)
         {
             try
             {
-                var received = await _socket.ReceiveAsync(buffer, SocketFlags.None, cancellationToken);
+                if (buffered == buffer.Length)
+                    Array.Resize(ref buffer, buffer.Length * 2);
+
+                var received = await _socket.ReceiveAsync(buffer.AsMemory(buffered), SocketFlags.None, cancellationToken);
                 if (received == 0)
                 {
                     Disconnected?.Invoke(this, EventArgs.Empty);
                     break;
                 }
+                buffered += received;
 
-                if (received >= headerSize)
+                var offset = 0;
+                while (buffered - offset >= headerSize)
                 {
-                    var header = BytesToStruct<MessageHeader>(buffer);
-                    var payload = new byte[header.PayloadSize];
-                    if (header.PayloadSize > 0 && received > headerSize)
-                    {
-                        Buffer.BlockCopy(buffer, headerSize, payload, 0,
-                            Math.Min((int)header.PayloadSize, received - headerSize));
-                    }
+                    var header = MemoryMarshal.Read<MessageHeader>(buffer.AsSpan(offset));
+                    var messageSize = headerSize + (int)header.PayloadSize;
+                    if (buffered - offset < messageSize)
+                        break;
 
+                    var payload = buffer.AsSpan(offset + headerSize, (int)header.PayloadSize).ToArray();
                     ProcessMessage((MessageType)header.Type, payload);
+                    offset += messageSize;
+                }
+
+                // Keep the incomplete tail for the next receive
+                if (offset > 0)
+                {
+                    Buffer.BlockCopy(buffer, offset, buffer, 0, buffered - offset);
+                    buffered -= offset;
                 }
             }
             catch (OperationCanceledException)
@@ -234,9 +285,10 @@ public class DaemonClient : IDisposable
                         ResolutionWidth = (int)gamePayload.ResolutionWidth,
                         ResolutionHeight = (int)gamePayload.ResolutionHeight,
                         PresentTimingSupported = gamePayload.PresentTimingSupported != 0,
+                        GraphicsApi = (GraphicsApi)gamePayload.GraphicsApi,
                         DetectedTime = DateTime.Now
                     };
-                    Console.WriteLine($"[DaemonClient] DEBUG: GameStarted - PID={gameInfo.Pid}, Name={gameInfo.Name}, GPU='{gameInfo.GpuName}', Res={gameInfo.ResolutionWidth}x{gameInfo.ResolutionHeight}, PresentTiming={gameInfo.PresentTimingSupported}");
+                    Console.WriteLine($"[DaemonClient] DEBUG: GameStarted - PID={gameInfo.Pid}, Name={gameInfo.Name}, GPU='{gameInfo.GpuName}', Res={gameInfo.ResolutionWidth}x{gameInfo.ResolutionHeight}, PresentTiming={gameInfo.PresentTimingSupported}, API={gameInfo.GraphicsApi}");
                     GameDetected?.Invoke(this, gameInfo);
                 }
                 break;
@@ -255,9 +307,10 @@ public class DaemonClient : IDisposable
                         ResolutionWidth = (int)gamePayload.ResolutionWidth,
                         ResolutionHeight = (int)gamePayload.ResolutionHeight,
                         PresentTimingSupported = gamePayload.PresentTimingSupported != 0,
+                        GraphicsApi = (GraphicsApi)gamePayload.GraphicsApi,
                         DetectedTime = DateTime.Now
                     };
-                    Console.WriteLine($"[DaemonClient] DEBUG: GameUpdated - PID={gameInfo.Pid}, Name={gameInfo.Name}, GPU='{gameInfo.GpuName}', Res={gameInfo.ResolutionWidth}x{gameInfo.ResolutionHeight}, PresentTiming={gameInfo.PresentTimingSupported}");
+                    Console.WriteLine($"[DaemonClient] DEBUG: GameUpdated - PID={gameInfo.Pid}, Name={gameInfo.Name}, GPU='{gameInfo.GpuName}', Res={gameInfo.ResolutionWidth}x{gameInfo.ResolutionHeight}, PresentTiming={gameInfo.PresentTimingSupported}, API={gameInfo.GraphicsApi}");
                     GameUpdated?.Invoke(this, gameInfo);
                 }
                 break;
@@ -274,22 +327,40 @@ public class DaemonClient : IDisposable
                 if (payload.Length >= Marshal.SizeOf<FrameDataPointIpc>())
                 {
                     var frameData = BytesToStruct<FrameDataPointIpc>(payload);
-                    var point = new FrameDataPoint
+                    FrameDataReceived?.Invoke(this, ToFrameDataPoint(frameData));
+                }
+                break;
+
+            case MessageType.FrametimeBatch:
+                ProcessFrameBatch(payload);
+                break;
+
+            case MessageType.FrameHistory:
+                ProcessFrameHistory(payload);
+                break;
+
+            case MessageType.LayerOverheadStats:
+                if (payload.Length >= Marshal.SizeOf<LayerOverheadPayload>())
+                {
+                    var stats = BytesToStruct<LayerOverheadPayload>(payload);
+                    LayerOverheadReceived?.Invoke(this, new LayerOverheadStats
                     {
-                        FrameNumber = frameData.FrameNumber,
-                        TimestampNs = frameData.TimestampNs,
-                        FrametimeMs = frameData.FrametimeMs,
-                        Fps = frameData.Fps,
-                        Pid = frameData.Pid,
-                        ActualPresentTimeNs = frameData.ActualPresentTimeNs,
-                        MsUntilRenderComplete = frameData.MsUntilRenderComplete,
-                        MsUntilDisplayed = frameData.MsUntilDisplayed,
-                        ActualFrametimeMs = frameData.ActualFrametimeMs
-                    };
-                    FrameDataReceived?.Invoke(this, point);
+                        Pid = stats.Pid,
+                        SampleCount = stats.SampleCount,
+                        P50Us = stats.P50Ns / 1000f,
+                        P90Us = stats.P90Ns / 1000f,
+                        P99Us = stats.P99Ns / 1000f,
+                        P999Us = stats.P999Ns / 1000f,
+                        MaxUs = stats.MaxNs / 1000f,
+                        MeanUs = stats.MeanNs / 1000f
+                    });
                 }
                 break;
 
+            case MessageType.DisplayTiming:
+                ProcessDisplayTiming(payload);
+                break;
+
             case MessageType.Pong:
                 // Keepalive response - could update connection status
                 break;
@@ -308,6 +379,107 @@ public class DaemonClient : IDisposable
         }
     }
 
+    private void ProcessFrameBatch(byte[] payload)
+    {
+        if (!TryReadFrameBatch(payload, out var batch))
+            return;
+
+        for (var i = 0; i < batch.Count; i++)
+        {
+            FrameDataReceived?.Invoke(this, ToFrameDataPoint(ReadBatchFrame(payload, batch, i)));
+        }
+    }
+
+    // Same layout as a frame batch; an empty batch ends the replay
+    private void ProcessFrameHistory(byte[] payload)
+    {
+        if (!TryReadFrameBatch(payload, out var batch))
+            return;
+
+        var frames = new FrameDataPoint[batch.Count];
+        for (var i = 0; i < batch.Count; i++)
+        {
+            frames[i] = ToFrameDataPoint(ReadBatchFrame(payload, batch, i));
+        }
+        FrameHistoryReceived?.Invoke(this, new FrameHistoryChunk { Frames = frames, Complete = batch.Count == 0 });
+    }
+
+    private void ProcessDisplayTiming(byte[] payload)
+    {
+        var headerSize = Marshal.SizeOf<DisplayTimingHeader>();
+        var statsSize = Marshal.SizeOf<DisplayTimingStatsIpc>();
+        if (payload.Length < headerSize)
+            return;
+
+        var header = MemoryMarshal.Read<DisplayTimingHeader>(payload);
+        var count = (int)Math.Min(header.CrtcCount, (uint)((payload.Length - headerSize) / statsSize));
+        var displays = new DisplayTimingStats[count];
+        for (var i = 0; i < count; i++)
+        {
+            var stats = MemoryMarshal.Read<DisplayTimingStatsIpc>(payload.AsSpan(headerSize + i * statsSize));
+            displays[i] = new DisplayTimingStats
+            {
+                CrtcId = stats.CrtcId,
+                SampleCount = stats.SampleCount,
+                MissedVblanks = stats.MissedVblanks,
+                AvgMsBetweenVblanks = stats.AvgMsBetweenVblanks,
+                MinMsBetweenVblanks = stats.MinMsBetweenVblanks,
+                MaxMsBetweenVblanks = stats.MaxMsBetweenVblanks,
+                LatestVblankNs = stats.LatestVblankNs
+            };
+        }
+        DisplayTimingReceived?.Invoke(this, displays);
+    }
+
+    private static bool TryReadFrameBatch(byte[] payload, out FrameBatchHeader batch)
+    {
+        var headerSize = Marshal.SizeOf<FrameBatchHeader>();
+        var frameSize = Marshal.SizeOf<FrameDataPointIpc>();
+        batch = default;
+        if (payload.Length < headerSize)
+            return false;
+
+        batch = MemoryMarshal.Read<FrameBatchHeader>(payload);
+        // Frames may carry fields appended by a newer daemon - step by the sender's stride
+        if (batch.FrameSize < frameSize || batch.Count > IpcCapabilities.MaxFrameBatch ||
+            headerSize + (long)batch.Count * batch.FrameSize > payload.Length)
+        {
+            Console.WriteLine($"[DaemonClient] Malformed frame batch (count={batch.Count}, frameSize={batch.FrameSize}, payload={payload.Length})");
+            return false;
+        }
+        return true;
+    }
+
+    private static FrameDataPointIpc ReadBatchFrame(byte[] payload, in FrameBatchHeader batch, int index)
+    {
+        var offset = Marshal.SizeOf<FrameBatchHeader>() + index * (int)batch.FrameSize;
+        return MemoryMarshal.Read<FrameDataPointIpc>(payload.AsSpan(offset));
+    }
+
+    private static FrameDataPoint ToFrameDataPoint(in FrameDataPointIpc frameData)
+    {
+        return new FrameDataPoint
+        {
+            FrameNumber = frameData.FrameNumber,
+            TimestampNs = frameData.TimestampNs,
+            FrametimeMs = frameData.FrametimeMs,
+            Fps = frameData.Fps,
+            Pid = frameData.Pid,
+            ActualPresentTimeNs = frameData.ActualPresentTimeNs,
+            MsUntilRenderComplete = frameData.MsUntilRenderComplete,
+            MsUntilDisplayed = frameData.MsUntilDisplayed,
+            ActualFrametimeMs = frameData.ActualFrametimeMs,
+            SwapchainId = frameData.SwapchainId,
+            AcquireTimeNs = frameData.AcquireTimeNs,
+            AcquireWaitMs = frameData.AcquireWaitMs,
+            AcquireToPresentMs = frameData.AcquireToPresentMs,
+            GpuActiveMs = frameData.GpuActiveMs,
+            LimiterErrorMs = frameData.LimiterErrorMs,
+            DisplayState = (FrameDisplayState)frameData.DisplayState,
+            MissedVblanks = frameData.MissedVblanks
+        };
+    }
+
     private static List<string> ParseIgnoreListResponse(byte[] payload)
     {
         var result = new List<string>();
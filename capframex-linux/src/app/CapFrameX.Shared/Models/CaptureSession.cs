@@ -16,6 +16,7 @@ public class CaptureSession
     public TimeSpan Duration => EndTime - StartTime;
     public string FilePath { get; set; } = string.Empty;
     public string Comment { get; set; } = string.Empty;
+    public LayerOverheadStats? LayerOverhead { get; set; }  // Last report from the layer (null if none)
 
     public List<FrameData> Frames { get; set; } = new();
 
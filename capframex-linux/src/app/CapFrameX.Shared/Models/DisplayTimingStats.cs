@@ -0,0 +1,16 @@
+namespace CapFrameX.Shared.Models;
+
+/// <summary>
+/// Vblank cadence of one display, measured by the daemon from DRM events over
+/// its last few hundred refresh cycles
+/// </summary>
+public record DisplayTimingStats
+{
+    public uint CrtcId { get; init; }
+    public uint SampleCount { get; init; }       // Refresh intervals measured
+    public uint MissedVblanks { get; init; }     // Vblanks that produced no event
+    public float AvgMsBetweenVblanks { get; init; }
+    public float MinMsBetweenVblanks { get; init; }
+    public float MaxMsBetweenVblanks { get; init; }
+    public ulong LatestVblankNs { get; init; }   // CLOCK_MONOTONIC, comparable to FrameDataPoint.TimestampNs
+}
@@ -1,5 +1,16 @@
 namespace CapFrameX.Shared.Models;
 
+/// <summary>
+/// What the display did with a frame (must match FrameDisplayState in daemon/common.h)
+/// </summary>
+public enum FrameDisplayState : uint
+{
+    Unknown = 0,    // No display timing for this frame
+    Displayed = 1,  // Shown at the first refresh after the previous frame
+    Repeated = 2,   // Shown late: the previous frame was repeated for MissedVblanks refreshes
+    Dropped = 3,    // Never shown: a later present reached the display first
+}
+
 /// <summary>
 /// Represents a single frame timing measurement
 /// </summary>
@@ -11,6 +22,13 @@ public record FrameData
     public float MsUntilRenderComplete { get; init; }    // Time until render complete (0 if not available)
     public float MsUntilDisplayed { get; init; }         // Time until displayed (0 if not available)
     public float ActualFrametimeMs { get; init; }        // From VK_EXT_present_timing (0 if not available)
+    public uint SwapchainId { get; init; }               // Presenting swapchain (0 if unknown)
+    public float AcquireWaitMs { get; init; }            // CPU blocked in vkAcquireNextImageKHR (swapchain throttling)
+    public float AcquireToPresentMs { get; init; }       // CPU busy from acquire to present
+    public float GpuActiveMs { get; init; }              // GPU busy with this frame (0 if not measured)
+    public float LimiterErrorMs { get; init; }           // Layer frame limiter's release past its deadline (0 if uncapped)
+    public FrameDisplayState DisplayState { get; init; } // From present timing (Unknown without it)
+    public uint MissedVblanks { get; init; }             // Refreshes the previous frame was repeated before this one
 
     /// <summary>
     /// Whether actual present timing data is available for this frame
@@ -36,6 +54,14 @@ public record FrameDataPoint
     public float MsUntilRenderComplete { get; init; } // Time until render complete (0 if not available)
     public float MsUntilDisplayed { get; init; }      // Time until displayed (0 if not available)
     public float ActualFrametimeMs { get; init; }      // Frametime from actual present timing (0 if not available)
+    public uint SwapchainId { get; init; }             // Presenting swapchain, unique within Pid (0 if unknown)
+    public ulong AcquireTimeNs { get; init; }          // When the presented image was acquired (0 if not available)
+    public float AcquireWaitMs { get; init; }          // CPU time blocked in vkAcquireNextImageKHR
+    public float AcquireToPresentMs { get; init; }     // CPU time from acquire returning to present
+    public float GpuActiveMs { get; init; }            // GPU busy with the frame's submits (0 if not measured)
+    public float LimiterErrorMs { get; init; }         // Layer frame limiter's release past its deadline (0 if uncapped)
+    public FrameDisplayState DisplayState { get; init; } // From present timing (Unknown without it)
+    public uint MissedVblanks { get; init; }           // Refreshes the previous frame was repeated before this one
 
     /// <summary>
     /// Whether actual present timing data is available for this frame
@@ -0,0 +1,12 @@
+namespace CapFrameX.Shared.Models;
+
+/// <summary>
+/// Part of the recent frames the daemon replays for a retroactive capture.
+/// The replay ends with an empty chunk marked Complete; live frames received
+/// before that are contained in the replay.
+/// </summary>
+public record FrameHistoryChunk
+{
+    public IReadOnlyList<FrameDataPoint> Frames { get; init; } = Array.Empty<FrameDataPoint>();
+    public bool Complete { get; init; }
+}
@@ -1,5 +1,6 @@
 using System.ComponentModel;
 using System.Runtime.CompilerServices;
+using CapFrameX.Shared.IPC;
 
 namespace CapFrameX.Shared.Models;
 
@@ -18,6 +19,7 @@ public class GameInfo : INotifyPropertyChanged
     private DateTime _detectedTime;
     private bool _isCapturing;
     private bool _presentTimingSupported;
+    private GraphicsApi _graphicsApi;
 
     public event PropertyChangedEventHandler? PropertyChanged;
 
@@ -89,10 +91,25 @@ public class GameInfo : INotifyPropertyChanged
         set => SetField(ref _presentTimingSupported, value);
     }
 
+    /// <summary>
+    /// API the capture hooks into (OpenGL titles are captured by the LD_PRELOAD library)
+    /// </summary>
+    public GraphicsApi GraphicsApi
+    {
+        get => _graphicsApi;
+        set
+        {
+            if (SetField(ref _graphicsApi, value))
+                OnPropertyChanged(nameof(TimingMode));
+        }
+    }
+
     /// <summary>
     /// Display name for timing mode
     /// </summary>
-    public string TimingMode => _presentTimingSupported ? "Present Timing" : "Layer Timing";
+    public string TimingMode => _presentTimingSupported ? "Present Timing"
+        : _graphicsApi is GraphicsApi.OpenGlGlx or GraphicsApi.OpenGlEgl ? "OpenGL Swap Timing"
+        : "Layer Timing";
 
     public string Resolution => ResolutionWidth > 0 && ResolutionHeight > 0
         ? $"{ResolutionWidth}x{ResolutionHeight}"
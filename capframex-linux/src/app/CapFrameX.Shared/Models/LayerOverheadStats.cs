@@ -0,0 +1,17 @@
+namespace CapFrameX.Shared.Models;
+
+/// <summary>
+/// Time the capture layer adds to each present (excluding the driver call),
+/// cumulative since the layer was loaded into the game
+/// </summary>
+public record LayerOverheadStats
+{
+    public int Pid { get; init; }
+    public ulong SampleCount { get; init; }   // Presents measured
+    public float P50Us { get; init; }
+    public float P90Us { get; init; }
+    public float P99Us { get; init; }
+    public float P999Us { get; init; }
+    public float MaxUs { get; init; }
+    public float MeanUs { get; init; }
+}
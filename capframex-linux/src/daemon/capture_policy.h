@@ -0,0 +1,112 @@
+#ifndef CAPFRAMEX_CAPTURE_POLICY_H
+#define CAPFRAMEX_CAPTURE_POLICY_H
+
+#include "common.h"
+#include <string.h>
+#include <strings.h>
+
+// Capture policy the daemon publishes in shared memory, so a layer can decide
+// at load time - before starting its IPC thread or touching the socket -
+// whether its process should be captured at all, and at which tier.
+//
+// The daemon is the only writer. sequence is a seqlock: odd while the daemon
+// rewrites the table, bumped to the next even value when done. Readers look
+// things up in place and retry if the sequence was odd or changed meanwhile.
+// Accessed with __atomic builtins since the table lives in memory shared
+// between processes (see frame_ring.h).
+#define CAPFRAMEX_SHM_POLICY_NAME "/capframex_policy"
+#define CAPFRAMEX_CAPTURE_POLICY_MAGIC 0x50584643u  // "CFXP"
+#define CAPFRAMEX_CAPTURE_POLICY_VERSION 1
+
+// Layers compare against /proc/self/comm, which the kernel truncates to 15
+// characters, so longer names could never match and are not published
+#define CAPTURE_POLICY_NAME_LENGTH 16
+#define CAPTURE_POLICY_MAX_NAMES 1024
+#define CAPTURE_POLICY_MAX_PIDS MAX_TRACKED_PROCESSES
+
+typedef struct {
+    pid_t pid;
+    uint32_t capture_tier;  // CaptureTier
+} CapturePolicyPid;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sequence;      // Seqlock, odd while being written
+    uint32_t default_tier;  // Tier set for every layer by the last MSG_CONFIG_UPDATE with pid 0
+    uint32_t pid_count;
+    uint32_t name_count;
+    CapturePolicyPid pids[CAPTURE_POLICY_MAX_PIDS];  // Tiers set for one process
+    char ignored_names[CAPTURE_POLICY_MAX_NAMES][CAPTURE_POLICY_NAME_LENGTH];
+} SharedCapturePolicy;
+
+typedef enum {
+    CAPTURE_POLICY_UNAVAILABLE = 0,  // No consistent snapshot (no daemon or always mid-write)
+    CAPTURE_POLICY_CAPTURE = 1,      // Capture, starting at the returned tier
+    CAPTURE_POLICY_IGNORED = 2,      // Blacklisted or on the user's ignore list
+} CapturePolicyDecision;
+
+// Writer: bracket every change of the table
+static inline void capture_policy_begin_write(SharedCapturePolicy* policy) {
+    uint32_t seq = __atomic_load_n(&policy->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&policy->sequence, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void capture_policy_end_write(SharedCapturePolicy* policy) {
+    uint32_t seq = __atomic_load_n(&policy->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&policy->sequence, seq + 1, __ATOMIC_RELEASE);
+}
+
+// Reader: decide for one process. A PID entry wins over the name list, so a
+// process the app explicitly configured is captured even if its name matches.
+static inline CapturePolicyDecision capture_policy_lookup(const SharedCapturePolicy* policy,
+                                                          pid_t pid, const char* process_name,
+                                                          CaptureTier* out_tier) {
+    if (policy->magic != CAPFRAMEX_CAPTURE_POLICY_MAGIC ||
+        policy->version != CAPFRAMEX_CAPTURE_POLICY_VERSION) {
+        return CAPTURE_POLICY_UNAVAILABLE;
+    }
+
+    for (int attempt = 0; attempt < 64; attempt++) {
+        uint32_t seq = __atomic_load_n(&policy->sequence, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+
+        CapturePolicyDecision decision = CAPTURE_POLICY_CAPTURE;
+        uint32_t tier = policy->default_tier;
+        bool pid_listed = false;
+
+        uint32_t pid_count = policy->pid_count;
+        if (pid_count > CAPTURE_POLICY_MAX_PIDS) pid_count = CAPTURE_POLICY_MAX_PIDS;
+        for (uint32_t i = 0; i < pid_count; i++) {
+            if (policy->pids[i].pid == pid) {
+                tier = policy->pids[i].capture_tier;
+                pid_listed = true;
+                break;
+            }
+        }
+
+        if (!pid_listed && process_name && process_name[0] != '\0') {
+            uint32_t name_count = policy->name_count;
+            if (name_count > CAPTURE_POLICY_MAX_NAMES) name_count = CAPTURE_POLICY_MAX_NAMES;
+            for (uint32_t i = 0; i < name_count; i++) {
+                if (strncasecmp(policy->ignored_names[i], process_name,
+                                CAPTURE_POLICY_NAME_LENGTH) == 0) {
+                    decision = CAPTURE_POLICY_IGNORED;
+                    break;
+                }
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&policy->sequence, __ATOMIC_RELAXED) == seq) {
+            *out_tier = tier > CAPTURE_TIER_FULL ? CAPTURE_TIER_FULL : (CaptureTier)tier;
+            return decision;
+        }
+    }
+    return CAPTURE_POLICY_UNAVAILABLE;
+}
+
+#endif // CAPFRAMEX_CAPTURE_POLICY_H
@@ -26,7 +26,7 @@ typedef enum {
     MSG_FRAMETIME_DATA = 5,    // Layer -> Daemon -> App: continuous frame data
     MSG_PING = 6,              // Keepalive
     MSG_PONG = 7,              // Keepalive response
-    MSG_CONFIG_UPDATE = 8,     // App -> Daemon/Layer
+    MSG_CONFIG_UPDATE = 8,     // App -> Daemon -> Layer: change the capture tier
     MSG_STATUS_REQUEST = 9,    // App -> Daemon
     MSG_STATUS_RESPONSE = 10,  // Daemon -> App
     MSG_LAYER_HELLO = 11,      // Layer -> Daemon: layer announces itself with PID/process info
@@ -38,8 +38,52 @@ typedef enum {
     MSG_IGNORE_LIST_RESPONSE = 17,// Daemon -> App: ignore list contents
     MSG_IGNORE_LIST_UPDATED = 18, // Daemon -> App: broadcast ignore list changed
     MSG_GAME_UPDATED = 19,        // Daemon -> App: game info updated (resolution, etc.)
+    MSG_FRAMETIME_BATCH = 20,     // Layer -> Daemon -> App: several frames in one message
+    MSG_HELLO_ACK = 21,           // Daemon -> Layer: daemon capabilities (reply to MSG_LAYER_HELLO)
+    MSG_LAYER_OVERHEAD_STATS = 22,// Layer -> Daemon -> App: layer present overhead percentiles
+    MSG_FRAME_LIMIT = 23,         // App -> Daemon -> Layer: set the layer's frame cap
+    MSG_FRAME_HISTORY = 24,       // Daemon -> App: recent frames replayed for a retroactive capture
+    MSG_DISPLAY_TIMING = 25,      // App -> Daemon: request, Daemon -> App: DRM vblank cadence per display
+    MSG_DISPLAY_VBLANKS = 26,     // App -> Daemon: present timestamps, Daemon -> App: the vblank each one reached
 } MessageType;
 
+// Capability flags, negotiated at hello/subscribe time so older peers keep
+// receiving one MSG_FRAMETIME_DATA per frame
+#define CAPFRAMEX_CAP_FRAME_BATCH (1u << 0)  // Understands MSG_FRAMETIME_BATCH
+#define CAPFRAMEX_CAP_SHM_RING    (1u << 1)  // Daemon mapped the layer's frame ring (see frame_ring.h)
+
+// Maximum number of frames carried by one MSG_FRAMETIME_BATCH
+#define CAPFRAMEX_MAX_FRAME_BATCH 64
+
+// How much a layer records, from CAPFRAMEX_CAPTURE_TIER at load time and
+// changed at runtime with MSG_CONFIG_UPDATE
+typedef enum {
+    CAPTURE_TIER_OFF = 0,         // Pure passthrough, nothing recorded or streamed
+    CAPTURE_TIER_TIMESTAMPS = 1,  // CPU present/acquire timestamps only
+    CAPTURE_TIER_FULL = 2,        // Timestamps plus present timing and GPU queries
+} CaptureTier;
+
+// What the display did with a frame, from present timing
+// (VK_GOOGLE_display_timing / VK_EXT_present_timing). Repeats are only
+// classified at a fixed refresh rate: VK_EXT_present_timing reports it,
+// VK_GOOGLE_display_timing swapchains assume it for FIFO presents until a
+// late frame lands between refresh cycles. With VRR a late frame is
+// DISPLAYED with missed_vblanks 0.
+typedef enum {
+    FRAME_DISPLAY_UNKNOWN = 0,    // No display timing for this frame
+    FRAME_DISPLAY_DISPLAYED = 1,  // Shown (at the first refresh after the previous frame if the refresh is fixed)
+    FRAME_DISPLAY_REPEATED = 2,   // Shown late: the previous frame was repeated for missed_vblanks refreshes
+    FRAME_DISPLAY_DROPPED = 3,    // Never shown: a later present reached the display first
+} FrameDisplayState;
+
+// Graphics API a capture library hooks (LayerHelloPayload / GameDetectedPayload)
+typedef enum {
+    GRAPHICS_API_UNKNOWN = 0,     // Sent by layers predating the tag
+    GRAPHICS_API_VULKAN = 1,      // capframex_layer
+    GRAPHICS_API_OPENGL_GLX = 2,  // capframex_gl, glXSwapBuffers
+    GRAPHICS_API_OPENGL_EGL = 3,  // capframex_gl, eglSwapBuffers*
+} GraphicsApi;
+
 // Process information structure
 typedef struct {
     pid_t pid;
@@ -69,7 +113,8 @@ typedef struct {
     uint32_t resolution_width;
     uint32_t resolution_height;
     uint8_t present_timing_supported;  // 1 if VK_EXT_present_timing available
-    uint8_t padding[3];                // Alignment padding
+    uint8_t graphics_api;              // GraphicsApi
+    uint8_t padding[2];                // Alignment padding
 } GameDetectedPayload;
 
 // Frame data for IPC
@@ -83,18 +128,128 @@ typedef struct __attribute__((packed)) {
     float ms_until_render_complete;   // Time until render complete (0 if not available)
     float ms_until_displayed;         // Time until displayed (0 if not available)
     float actual_frametime_ms;    // Frametime from actual present timing (0 if not available)
-    uint32_t padding;             // Alignment padding
+    uint32_t swapchain_id;        // Presenting swapchain, unique within pid (0 if unknown)
+    uint64_t acquire_time_ns;     // When the presented image was acquired (0 if not available)
+    float acquire_wait_ms;        // CPU time blocked in vkAcquireNextImageKHR
+    float acquire_to_present_ms;  // CPU time from acquire returning to present
+    float gpu_active_ms;          // GPU busy with the frame's submits (0 if not measured)
+    float limiter_error_ms;       // Layer frame limiter's release past its deadline (0 if uncapped)
+    uint32_t display_state;       // FrameDisplayState
+    uint32_t missed_vblanks;      // Refreshes the previous frame was repeated before this one (0 if unknown or VRR)
 } FrameDataPoint;
 
+// Frame batch message: header followed by count frames of frame_size bytes.
+// frame_size lets readers skip fields appended by newer senders.
+typedef struct {
+    uint32_t count;
+    uint32_t frame_size;
+} FrameBatchHeader;
+
 // Layer hello message - layer announces itself to daemon
 typedef struct {
     pid_t pid;
     char process_name[MAX_GAME_NAME_LENGTH];
     char gpu_name[MAX_GAME_NAME_LENGTH];
     uint8_t present_timing_supported;  // 1 if VK_EXT_present_timing available
-    uint8_t padding[3];                // Alignment padding
+    uint8_t graphics_api;              // GraphicsApi
+    uint8_t padding[2];                // Alignment padding
 } LayerHelloPayload;
 
+// Daemon reply to a layer hello
+typedef struct {
+    uint32_t capabilities;  // CAPFRAMEX_CAP_* flags supported by the daemon
+} HelloAckPayload;
+
+// Time the layer adds to vkQueuePresentKHR (excluding the driver call),
+// cumulative since the layer was loaded. Sent about once per second.
+typedef struct __attribute__((packed)) {
+    int32_t pid;
+    uint32_t reserved;
+    uint64_t sample_count;  // Presents measured
+    uint32_t p50_ns;
+    uint32_t p90_ns;
+    uint32_t p99_ns;
+    uint32_t p999_ns;
+    uint32_t max_ns;
+    uint32_t mean_ns;
+} LayerOverheadPayload;
+
+// Capture tier update for one layer (pid 0 = every connected layer)
+typedef struct {
+    pid_t pid;
+    uint32_t capture_tier;  // CaptureTier
+} CaptureConfigPayload;
+
+// Frame cap for one layer (pid 0 = every connected layer)
+typedef struct {
+    pid_t pid;
+    float fps_limit;  // 0 = uncapped
+} FrameLimitPayload;
+
+// Start capture message - app subscribes to a layer's frame stream.
+// Older apps send only the pid, or pid and capabilities.
+//
+// With history_ms set the daemon first replays the frames the layer sent in
+// the last history_ms as MSG_FRAME_HISTORY batches (FrameBatchHeader +
+// frames), ends the replay with an empty batch and then continues live, so
+// every frame is delivered exactly once. Sent again while subscribed, it
+// replays without interrupting the live stream.
+typedef struct {
+    pid_t pid;
+    uint32_t capabilities;  // CAPFRAMEX_CAP_* flags supported by the app
+    uint32_t history_ms;    // Replay this much of the past first (0 = live only)
+} StartCapturePayload;
+
+// Vblank cadence of one display (CRTC), over the daemon's recent samples
+#define DISPLAY_TIMING_MAX_CRTCS 4
+
+typedef struct __attribute__((packed)) {
+    uint32_t crtc_id;
+    uint32_t sample_count;        // Intervals the stats cover
+    uint32_t missed_vblanks;      // Vblanks within those intervals that produced no event
+    float avg_ms_between_vblanks;
+    float min_ms_between_vblanks;
+    float max_ms_between_vblanks;
+    uint64_t latest_vblank_ns;    // CLOCK_MONOTONIC, the clock of FrameDataPoint.timestamp_ns
+    uint32_t latest_sequence;     // Vblank counter of the CRTC
+    uint32_t reserved;
+} DisplayTimingStats;
+
+// Reply to an (empty) MSG_DISPLAY_TIMING request. crtc_count is 0 when the
+// daemon tracks no DRM device.
+typedef struct __attribute__((packed)) {
+    uint32_t crtc_count;
+    uint32_t reserved;
+    DisplayTimingStats crtcs[DISPLAY_TIMING_MAX_CRTCS];
+} DisplayTimingPayload;
+
+// Present-to-vblank lookup on one display (MSG_DISPLAY_VBLANKS). The request
+// carries count present timestamps, the reply the first vblank at or after
+// each of them. The daemon keeps a few seconds of vblanks, so ask shortly
+// after the presents, e.g. once per received frame batch.
+#define DISPLAY_VBLANKS_MAX 64
+
+typedef struct __attribute__((packed)) {
+    uint32_t crtc_id;                          // DisplayTimingStats.crtc_id
+    uint32_t count;                            // Up to DISPLAY_VBLANKS_MAX
+    uint64_t present_ns[DISPLAY_VBLANKS_MAX];  // CLOCK_MONOTONIC, e.g. FrameDataPoint.timestamp_ns
+} DisplayVblankRequest;
+
+typedef struct __attribute__((packed)) {
+    uint64_t present_ns;
+    uint64_t vblank_ns;  // 0 if no vblank was recorded for the present (too old, too new, tracking paused)
+    uint32_t sequence;   // Vblank counter of the CRTC
+    uint32_t reserved;
+} DisplayVblankMatch;
+
+// Only the first count matches are sent. count is 0 when the daemon does
+// not track crtc_id.
+typedef struct __attribute__((packed)) {
+    uint32_t crtc_id;
+    uint32_t count;
+    DisplayVblankMatch matches[DISPLAY_VBLANKS_MAX];
+} DisplayVblankReply;
+
 // Swapchain info message
 typedef struct {
     pid_t pid;
@@ -104,11 +259,26 @@ typedef struct {
     uint32_t image_count;
 } SwapchainInfoPayload;
 
-// Shared memory structure for active PIDs
+// Shared memory list of the PIDs the daemon knows about (CAPFRAMEX_SHM_NAME),
+// so overlays and tools can tell what is being captured without IPC.
+// version is a seqlock, odd while the daemon rewrites the list; use the
+// helpers in pid_list.h or the reader library in src/pidlist.
+#define SHARED_PID_LIST_MAGIC 0x4c584643u  // "CFXL"
+
+#define SHARED_PID_DETECTED (1u << 0)  // Found by the daemon's game detection
+#define SHARED_PID_LAYER    (1u << 1)  // A capture layer is connected from this process
+
+typedef struct {
+    pid_t pid;
+    uint32_t flags;  // SHARED_PID_* flags
+} SharedPidEntry;
+
 typedef struct {
+    uint32_t magic;
+    uint32_t version;  // Seqlock, odd while being written
     uint32_t count;
-    uint32_t version;
-    pid_t pids[MAX_TRACKED_PROCESSES];
+    uint32_t reserved;
+    SharedPidEntry pids[MAX_TRACKED_PROCESSES];
 } SharedPidList;
 
 // Ignore list entry (for add/remove messages)
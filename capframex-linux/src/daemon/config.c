@@ -113,6 +113,8 @@ int config_load(const char* path) {
                 config.log_level = atoi(v);
             } else if (strcmp(k, "log_file") == 0) {
                 strncpy(config.log_file, v, sizeof(config.log_file) - 1);
+            } else if (strcmp(k, "display_timing_device") == 0) {
+                strncpy(config.display_timing_device, v, sizeof(config.display_timing_device) - 1);
             }
         }
     }
@@ -144,6 +146,7 @@ int config_save(const char* path) {
     fprintf(f, "scan_interval_ms=%d\n", config.scan_interval_ms);
     fprintf(f, "log_level=%d\n", config.log_level);
     fprintf(f, "log_file=%s\n", config.log_file);
+    fprintf(f, "display_timing_device=%s\n", config.display_timing_device);
 
     fclose(f);
     LOG_INFO("Configuration saved to %s", config_path);
@@ -13,6 +13,10 @@ typedef struct {
     int log_level;  // 0=error, 1=warn, 2=info, 3=debug
     char log_file[MAX_PATH_LENGTH];
 
+    // Display timing: DRM card node to track vblanks on ("" = first card
+    // driving a display, "off" = disabled)
+    char display_timing_device[MAX_PATH_LENGTH];
+
     // Paths
     char config_dir[MAX_PATH_LENGTH];
     char data_dir[MAX_PATH_LENGTH];
@@ -0,0 +1,377 @@
+#include "display_timing.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define DISPLAY_TIMING_MAX_HOLDERS 64
+
+// Samples of one CRTC. The tracker thread is the only writer; readers copy
+// the ring and then drop the slots the writer may have reused meanwhile, so
+// neither side ever waits for the other.
+typedef struct {
+    uint64_t write_pos;     // Samples ever recorded (__atomic)
+    uint32_t last_sequence; // Tracker thread only
+    uint64_t last_ns;       // Tracker thread only, 0 = no sample yet
+    DisplayTimingSample samples[DISPLAY_TIMING_RING_SIZE];
+} CrtcTimeline;
+
+static CrtcTimeline timelines[DISPLAY_TIMING_MAX_CRTCS];
+static DisplayTimingSource* source = NULL;
+static uint32_t crtc_count = 0;
+static pthread_t tracker_thread;
+static volatile bool running = false;
+
+// Clients that need vblank samples
+static int holders[DISPLAY_TIMING_MAX_HOLDERS];
+static uint32_t holder_count = 0;
+static pthread_mutex_t holders_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool wanted = false;  // holder_count > 0 (__atomic)
+static int wake_fd = -1;     // Wakes the tracker thread when wanted changes
+
+// Called with holders_mutex held
+static void set_wanted(bool value) {
+    if (__atomic_load_n(&wanted, __ATOMIC_RELAXED) == value) return;
+    __atomic_store_n(&wanted, value, __ATOMIC_RELEASE);
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            LOG_WARN("Failed to wake display timing thread: %s", strerror(errno));
+        }
+    }
+}
+
+void display_timing_hold(int client_fd) {
+    pthread_mutex_lock(&holders_mutex);
+    uint32_t i = 0;
+    while (i < holder_count && holders[i] != client_fd) i++;
+    if (i == holder_count) {
+        if (holder_count == DISPLAY_TIMING_MAX_HOLDERS) {
+            pthread_mutex_unlock(&holders_mutex);
+            LOG_WARN("Too many display timing clients, ignoring client %d", client_fd);
+            return;
+        }
+        holders[holder_count++] = client_fd;
+    }
+    set_wanted(true);
+    pthread_mutex_unlock(&holders_mutex);
+}
+
+void display_timing_release(int client_fd) {
+    pthread_mutex_lock(&holders_mutex);
+    for (uint32_t i = 0; i < holder_count; i++) {
+        if (holders[i] == client_fd) {
+            holders[i] = holders[--holder_count];
+            break;
+        }
+    }
+    set_wanted(holder_count > 0);
+    pthread_mutex_unlock(&holders_mutex);
+}
+
+bool display_timing_wanted(void) {
+    return __atomic_load_n(&wanted, __ATOMIC_ACQUIRE);
+}
+
+void display_timing_record(uint32_t crtc_index, uint32_t sequence, uint64_t timestamp_ns) {
+    if (crtc_index >= crtc_count) return;
+    CrtcTimeline* timeline = &timelines[crtc_index];
+
+    DisplayTimingSample sample = {0};
+    sample.timestamp_ns = timestamp_ns;
+    sample.sequence = sequence;
+    if (timeline->last_ns != 0) {
+        uint32_t vblanks = sequence - timeline->last_sequence;  // Counter may wrap
+        if (vblanks == 0 || timestamp_ns <= timeline->last_ns) {
+            return;  // Duplicate or stale event
+        }
+        sample.missed = vblanks - 1;
+        sample.ms_between_vblanks = (float)(timestamp_ns - timeline->last_ns) / 1000000.0f;
+    }
+    timeline->last_sequence = sequence;
+    timeline->last_ns = timestamp_ns;
+
+    uint64_t pos = __atomic_load_n(&timeline->write_pos, __ATOMIC_RELAXED);
+    // Order the previous write_pos store before overwriting a slot readers may be copying
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    timeline->samples[pos & (DISPLAY_TIMING_RING_SIZE - 1)] = sample;
+    __atomic_store_n(&timeline->write_pos, pos + 1, __ATOMIC_RELEASE);
+}
+
+// Copy the samples of a CRTC into out (DISPLAY_TIMING_RING_SIZE entries),
+// oldest first. Returns how many were copied intact.
+static uint32_t snapshot(uint32_t crtc_index, DisplayTimingSample* out) {
+    if (crtc_index >= crtc_count) return 0;
+    const CrtcTimeline* timeline = &timelines[crtc_index];
+
+    uint64_t end = __atomic_load_n(&timeline->write_pos, __ATOMIC_ACQUIRE);
+    uint64_t begin = end > DISPLAY_TIMING_RING_SIZE ? end - DISPLAY_TIMING_RING_SIZE : 0;
+    for (uint64_t i = begin; i < end; i++) {
+        out[i - begin] = timeline->samples[i & (DISPLAY_TIMING_RING_SIZE - 1)];
+    }
+
+    // The writer may have reused slots meanwhile, including the one it is
+    // writing right now (the slot of position now - RING_SIZE)
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t now = __atomic_load_n(&timeline->write_pos, __ATOMIC_RELAXED);
+    uint64_t valid = now >= DISPLAY_TIMING_RING_SIZE ? now - DISPLAY_TIMING_RING_SIZE + 1 : 0;
+    if (valid <= begin) {
+        return (uint32_t)(end - begin);
+    }
+    if (valid >= end) {
+        return 0;
+    }
+    memmove(out, out + (valid - begin), (size_t)(end - valid) * sizeof(*out));
+    return (uint32_t)(end - valid);
+}
+
+bool display_timing_get_latest(uint32_t crtc_index, DisplayTimingSample* out) {
+    DisplayTimingSample samples[DISPLAY_TIMING_RING_SIZE];
+    uint32_t count = snapshot(crtc_index, samples);
+    if (count == 0) return false;
+    *out = samples[count - 1];
+    return true;
+}
+
+uint32_t display_timing_get_stats(DisplayTimingStats* out, uint32_t max) {
+    DisplayTimingSample samples[DISPLAY_TIMING_RING_SIZE];
+    uint32_t written = 0;
+
+    for (uint32_t c = 0; c < crtc_count && written < max; c++) {
+        DisplayTimingStats* stats = &out[written++];
+        memset(stats, 0, sizeof(*stats));
+        stats->crtc_id = source ? source->crtc_ids[c] : 0;
+
+        uint32_t count = snapshot(c, samples);
+        if (count == 0) continue;
+
+        stats->latest_vblank_ns = samples[count - 1].timestamp_ns;
+        stats->latest_sequence = samples[count - 1].sequence;
+
+        // Only the samples since tracking last resumed. The first one's
+        // interval reaches back before the window.
+        uint32_t first = count - 1;
+        while (first > 0 && samples[first].ms_between_vblanks != 0.0f) first--;
+
+        uint64_t span_ns = samples[count - 1].timestamp_ns - samples[first].timestamp_ns;
+        uint64_t vblanks = 0;
+        float min_ms = 0.0f, max_ms = 0.0f;
+        for (uint32_t i = first + 1; i < count; i++) {
+            vblanks += (uint64_t)samples[i].missed + 1;
+            stats->missed_vblanks += samples[i].missed;
+            // Min/max only over intervals of a single refresh cycle
+            if (samples[i].missed == 0) {
+                float ms = samples[i].ms_between_vblanks;
+                if (min_ms == 0.0f || ms < min_ms) min_ms = ms;
+                if (ms > max_ms) max_ms = ms;
+            }
+        }
+
+        stats->sample_count = count - 1 - first;
+        if (vblanks > 0) {
+            stats->avg_ms_between_vblanks = (float)((double)span_ns / 1000000.0 / (double)vblanks);
+        }
+        stats->min_ms_between_vblanks = min_ms;
+        stats->max_ms_between_vblanks = max_ms;
+    }
+
+    return written;
+}
+
+// display_timing_next_vblank over a snapshot
+static bool find_next_vblank(const DisplayTimingSample* samples, uint32_t count,
+                             uint64_t present_ns, DisplayTimingSample* out) {
+    if (count < 2 || present_ns <= samples[0].timestamp_ns ||
+        present_ns > samples[count - 1].timestamp_ns) {
+        return false;
+    }
+
+    // First sample at or after the present (timestamps ascend)
+    uint32_t lo = 1, hi = count - 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (samples[mid].timestamp_ns >= present_ns) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    if (samples[lo].ms_between_vblanks == 0.0f) {
+        return false;  // Presented while tracking was paused
+    }
+
+    const DisplayTimingSample* prev = &samples[lo - 1];
+    *out = samples[lo];
+    if (out->missed > 0) {
+        // Vblanks without an event fall evenly between the two samples
+        uint32_t vblanks = out->missed + 1;
+        uint64_t step_ns = (out->timestamp_ns - prev->timestamp_ns) / vblanks;
+        uint64_t k = step_ns > 0 ? (present_ns - prev->timestamp_ns + step_ns - 1) / step_ns : vblanks;
+        if (k < vblanks) {
+            out->timestamp_ns = prev->timestamp_ns + k * step_ns;
+            out->sequence = prev->sequence + (uint32_t)k;
+            out->missed = 0;
+            out->ms_between_vblanks = (float)step_ns / 1000000.0f;
+        }
+    }
+    return true;
+}
+
+bool display_timing_next_vblank(uint32_t crtc_index, uint64_t present_ns,
+                                DisplayTimingSample* out) {
+    DisplayTimingSample samples[DISPLAY_TIMING_RING_SIZE];
+    uint32_t count = snapshot(crtc_index, samples);
+    return find_next_vblank(samples, count, present_ns, out);
+}
+
+uint32_t display_timing_match_vblanks(const DisplayVblankRequest* request,
+                                      DisplayVblankReply* reply) {
+    memset(reply, 0, sizeof(*reply));
+    reply->crtc_id = request->crtc_id;
+
+    uint32_t index = 0;
+    while (index < crtc_count && source->crtc_ids[index] != request->crtc_id) index++;
+    if (index < crtc_count) {
+        reply->count = request->count < DISPLAY_VBLANKS_MAX ? request->count : DISPLAY_VBLANKS_MAX;
+    }
+
+    // One snapshot for every present of the request
+    DisplayTimingSample samples[DISPLAY_TIMING_RING_SIZE];
+    uint32_t sample_count = reply->count > 0 ? snapshot(index, samples) : 0;
+
+    for (uint32_t i = 0; i < reply->count; i++) {
+        DisplayVblankMatch* match = &reply->matches[i];
+        DisplayTimingSample vblank;
+        match->present_ns = request->present_ns[i];
+        if (find_next_vblank(samples, sample_count, match->present_ns, &vblank)) {
+            match->vblank_ns = vblank.timestamp_ns;
+            match->sequence = vblank.sequence;
+        }
+    }
+
+    return (uint32_t)(offsetof(DisplayVblankReply, matches) +
+                      reply->count * sizeof(DisplayVblankMatch));
+}
+
+static void* tracker_thread_func(void* arg) {
+    (void)arg;
+    struct pollfd fds[2] = {
+        { .fd = source->fd, .events = POLLIN },
+        { .fd = wake_fd, .events = POLLIN },
+    };
+    bool tracking = false;
+
+    while (running) {
+        bool want = display_timing_wanted();
+        if (want != tracking) {
+            tracking = want;
+            if (tracking) {
+                // Samples after a pause don't continue the old intervals
+                for (uint32_t c = 0; c < crtc_count; c++) {
+                    timelines[c].last_ns = 0;
+                }
+                if (source->idle) source->idle(source);
+            }
+            LOG_INFO("Display timing %s", tracking ? "resumed" : "paused, no client needs it");
+        }
+
+        // 1 second timeout while tracking, none while paused
+        int ret = poll(fds, 2, tracking ? 1000 : -1);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("Display timing poll error: %s", strerror(errno));
+            break;
+        }
+
+        if (ret == 0) {
+            if (source->idle) source->idle(source);
+            continue;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            if (read(wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                LOG_WARN("Failed to read display timing eventfd: %s", strerror(errno));
+            }
+        }
+
+        // Events armed before a pause still arrive and are recorded
+        if (fds[0].revents && source->dispatch(source) < 0) {
+            LOG_WARN("Display timing source closed, no more vblank samples");
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void close_wake_fd(void) {
+    pthread_mutex_lock(&holders_mutex);
+    close(wake_fd);
+    wake_fd = -1;
+    pthread_mutex_unlock(&holders_mutex);
+}
+
+int display_timing_start(DisplayTimingSource* new_source) {
+    if (!new_source) return -1;
+    if (source) {
+        LOG_WARN("Display timing already running");
+        new_source->destroy(new_source);
+        return -1;
+    }
+
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create display timing eventfd: %s", strerror(errno));
+        new_source->destroy(new_source);
+        return -1;
+    }
+    pthread_mutex_lock(&holders_mutex);
+    wake_fd = fd;
+    pthread_mutex_unlock(&holders_mutex);
+
+    memset(timelines, 0, sizeof(timelines));
+    source = new_source;
+    crtc_count = source->crtc_count < DISPLAY_TIMING_MAX_CRTCS ?
+                 source->crtc_count : DISPLAY_TIMING_MAX_CRTCS;
+    running = true;
+
+    if (pthread_create(&tracker_thread, NULL, tracker_thread_func, NULL) != 0) {
+        LOG_ERROR("Failed to create display timing thread: %s", strerror(errno));
+        running = false;
+        crtc_count = 0;
+        source->destroy(source);
+        source = NULL;
+        close_wake_fd();
+        return -1;
+    }
+
+    LOG_INFO("Display timing started (%u CRTC(s))", crtc_count);
+    return 0;
+}
+
+void display_timing_stop(void) {
+    if (!source) return;
+
+    running = false;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARN("Failed to wake display timing thread: %s", strerror(errno));
+    }
+    pthread_join(tracker_thread, NULL);
+    close_wake_fd();
+
+    crtc_count = 0;
+    source->destroy(source);
+    source = NULL;
+}
+
+bool display_timing_active(void) {
+    return source != NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef CAPFRAMEX_DISPLAY_TIMING_H
+#define CAPFRAMEX_DISPLAY_TIMING_H
+
+#include "common.h"
+
+// Display cadence measured from DRM vblank events, for titles and drivers
+// that expose no present timing extension. Page-flip events only reach the
+// DRM master (the compositor), so the tracker asks the kernel for an event at
+// every vblank of each active CRTC instead: with VRR the intervals follow the
+// flips, at a fixed refresh rate they are the grid presents land on. Vblank
+// timestamps are CLOCK_MONOTONIC, the clock of the layer's present timestamps.
+//
+// Vblank events keep the display's interrupt enabled and wake the daemon at
+// every refresh, so sources only request them while a client holds the
+// tracker (display_timing_hold) and stop once the last one lets go.
+
+#define DISPLAY_TIMING_RING_SIZE 256  // Samples kept per CRTC, power of two
+
+typedef struct {
+    uint64_t timestamp_ns;     // CLOCK_MONOTONIC
+    uint32_t sequence;         // Vblank counter of the CRTC
+    uint32_t missed;           // Vblanks since the previous sample that produced no event
+    float ms_between_vblanks;  // 0 for the first sample of a CRTC and after a pause
+} DisplayTimingSample;
+
+// Where vblank events come from: the DRM device (drm_events.h) or a fake
+// source in tests
+typedef struct DisplayTimingSource DisplayTimingSource;
+struct DisplayTimingSource {
+    int fd;                                       // Polled for POLLIN by the tracker thread
+    uint32_t crtc_count;
+    uint32_t crtc_ids[DISPLAY_TIMING_MAX_CRTCS];  // Reported as DisplayTimingStats.crtc_id
+
+    // Read the pending events, reporting each one with display_timing_record().
+    // Returns -1 once the source is unusable.
+    int (*dispatch)(DisplayTimingSource* source);
+    // Called when tracking is requested and when no event arrived for a
+    // second while it is (optional), e.g. to re-arm a CRTC that was switched
+    // off. Sources stop requesting events once display_timing_wanted() is false.
+    void (*idle)(DisplayTimingSource* source);
+    void (*destroy)(DisplayTimingSource* source);
+    void* ctx;
+};
+
+// Start the tracker thread on a source (takes ownership, also on failure)
+int display_timing_start(DisplayTimingSource* source);
+
+// Stop the thread and destroy the source
+void display_timing_stop(void);
+
+bool display_timing_active(void);
+
+// Track vblanks while any client holds the tracker. A client takes it with
+// its first MSG_DISPLAY_TIMING or MSG_DISPLAY_VBLANKS request and lets go
+// when it disconnects; holding twice is a no-op.
+void display_timing_hold(int client_fd);
+void display_timing_release(int client_fd);
+
+// Whether sources should keep requesting vblank events
+bool display_timing_wanted(void);
+
+// Report a vblank of CRTC crtc_index (0..crtc_count-1). Called by sources on
+// the tracker thread only.
+void display_timing_record(uint32_t crtc_index, uint32_t sequence, uint64_t timestamp_ns);
+
+// Lock-free readers, safe from any thread
+
+// Latest sample of a CRTC, false if it has none yet
+bool display_timing_get_latest(uint32_t crtc_index, DisplayTimingSample* out);
+
+// Stats over the recent samples of every CRTC, returns how many were written
+uint32_t display_timing_get_stats(DisplayTimingStats* out, uint32_t max);
+
+// First vblank of a CRTC at or after a CLOCK_MONOTONIC present timestamp.
+// False if present_ns is older than the samples kept or newer than the latest.
+bool display_timing_next_vblank(uint32_t crtc_index, uint64_t present_ns,
+                                DisplayTimingSample* out);
+
+// Answer a MSG_DISPLAY_VBLANKS request (count already clamped to
+// DISPLAY_VBLANKS_MAX). Returns the reply's size in bytes.
+uint32_t display_timing_match_vblanks(const DisplayVblankRequest* request,
+                                      DisplayVblankReply* reply);
+
+#endif // CAPFRAMEX_DISPLAY_TIMING_H
@@ -0,0 +1,190 @@
+#include "drm_events.h"
+
+#include <stdio.h>
+
+#ifdef HAVE_LIBDRM
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+#define DRM_MAX_CARDS 8
+
+typedef struct {
+    DisplayTimingSource source;
+    uint32_t pipes[DISPLAY_TIMING_MAX_CRTCS];  // Index of each tracked CRTC within the device
+    bool armed[DISPLAY_TIMING_MAX_CRTCS];      // Vblank event requested
+} DrmSource;
+
+// Source inside drmHandleEvent (tracker thread only)
+static DrmSource* dispatching = NULL;
+
+// Vblank request flags selecting a CRTC by its index
+static uint32_t pipe_flags(uint32_t pipe) {
+    if (pipe == 0) return 0;
+    if (pipe == 1) return DRM_VBLANK_SECONDARY;
+    return (pipe << DRM_VBLANK_HIGH_CRTC_SHIFT) & DRM_VBLANK_HIGH_CRTC_MASK;
+}
+
+// Ask for an event at the next vblank of a tracked CRTC
+static void arm_vblank(DrmSource* drm, uint32_t index) {
+    drmVBlank vbl;
+    memset(&vbl, 0, sizeof(vbl));
+    vbl.request.type = DRM_VBLANK_RELATIVE | DRM_VBLANK_EVENT | pipe_flags(drm->pipes[index]);
+    vbl.request.sequence = 1;
+    vbl.request.signal = index;
+
+    bool armed = drmWaitVBlank(drm->source.fd, &vbl) == 0;
+    if (!armed && drm->armed[index]) {
+        // Display switched off or reconfigured, retried from drm_idle
+        LOG_INFO("CRTC %u stopped delivering vblanks: %s",
+                 drm->source.crtc_ids[index], strerror(errno));
+    }
+    drm->armed[index] = armed;
+}
+
+static void vblank_handler(int fd, unsigned int sequence, unsigned int tv_sec,
+                           unsigned int tv_usec, void* user_data) {
+    (void)fd;
+    uint32_t index = (uint32_t)(uintptr_t)user_data;
+    display_timing_record(index, sequence,
+                          (uint64_t)tv_sec * 1000000000ULL + (uint64_t)tv_usec * 1000ULL);
+
+    if (dispatching && index < dispatching->source.crtc_count) {
+        // The next event is requested only while a client needs samples
+        if (display_timing_wanted()) {
+            arm_vblank(dispatching, index);
+        } else {
+            dispatching->armed[index] = false;
+        }
+    }
+}
+
+static int drm_dispatch(DisplayTimingSource* source) {
+    drmEventContext context;
+    memset(&context, 0, sizeof(context));
+    context.version = 2;
+    context.vblank_handler = vblank_handler;
+
+    dispatching = (DrmSource*)source;
+    int ret = drmHandleEvent(source->fd, &context);
+    dispatching = NULL;
+
+    if (ret != 0 && errno != EAGAIN && errno != EINTR) {
+        LOG_WARN("DRM event read failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void drm_idle(DisplayTimingSource* source) {
+    DrmSource* drm = (DrmSource*)source;
+    if (!display_timing_wanted()) return;
+
+    for (uint32_t i = 0; i < source->crtc_count; i++) {
+        if (!drm->armed[i]) {
+            arm_vblank(drm, i);
+        }
+    }
+}
+
+static void drm_destroy(DisplayTimingSource* source) {
+    close(source->fd);
+    free(source);
+}
+
+static DisplayTimingSource* open_card(const char* path, bool quiet) {
+    int fd = open(path, O_RDWR | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0) {
+        if (!quiet) LOG_WARN("Failed to open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    // Vblank timestamps must share the layer's clock
+    uint64_t monotonic = 0;
+    if (drmGetCap(fd, DRM_CAP_TIMESTAMP_MONOTONIC, &monotonic) != 0 || monotonic != 1) {
+        LOG_WARN("%s: vblank timestamps are not CLOCK_MONOTONIC", path);
+        close(fd);
+        return NULL;
+    }
+
+    // Render-only devices have no KMS resources
+    drmModeRes* resources = drmModeGetResources(fd);
+    if (!resources) {
+        if (!quiet) LOG_WARN("%s has no display resources", path);
+        close(fd);
+        return NULL;
+    }
+
+    DrmSource* drm = calloc(1, sizeof(DrmSource));
+    if (!drm) {
+        drmModeFreeResources(resources);
+        close(fd);
+        return NULL;
+    }
+
+    // Track the CRTCs that currently drive a display
+    for (int i = 0; i < resources->count_crtcs &&
+                    drm->source.crtc_count < DISPLAY_TIMING_MAX_CRTCS; i++) {
+        drmModeCrtc* crtc = drmModeGetCrtc(fd, resources->crtcs[i]);
+        if (!crtc) continue;
+        if (crtc->mode_valid) {
+            uint32_t index = drm->source.crtc_count++;
+            drm->source.crtc_ids[index] = crtc->crtc_id;
+            drm->pipes[index] = (uint32_t)i;
+        }
+        drmModeFreeCrtc(crtc);
+    }
+    drmModeFreeResources(resources);
+
+    drm->source.fd = fd;
+    drm->source.dispatch = drm_dispatch;
+    drm->source.idle = drm_idle;
+    drm->source.destroy = drm_destroy;
+
+    // Probe with one event per CRTC, later ones are requested on demand
+    uint32_t armed = 0;
+    for (uint32_t i = 0; i < drm->source.crtc_count; i++) {
+        arm_vblank(drm, i);
+        if (drm->armed[i]) armed++;
+    }
+
+    if (armed == 0) {
+        if (!quiet) LOG_WARN("%s: no active CRTC delivers vblank events", path);
+        drm_destroy(&drm->source);
+        return NULL;
+    }
+
+    LOG_INFO("Display timing on %s: %u of %u active CRTC(s)", path, armed, drm->source.crtc_count);
+    return &drm->source;
+}
+
+DisplayTimingSource* drm_events_open(const char* device) {
+    if (device && device[0] != '\0') {
+        return open_card(device, false);
+    }
+
+    for (int i = 0; i < DRM_MAX_CARDS; i++) {
+        char path[32];
+        snprintf(path, sizeof(path), "/dev/dri/card%d", i);
+        DisplayTimingSource* source = open_card(path, true);
+        if (source) return source;
+    }
+
+    LOG_INFO("No DRM device driving a display, display timing unavailable");
+    return NULL;
+}
+
+#else
+
+DisplayTimingSource* drm_events_open(const char* device) {
+    (void)device;
+    LOG_INFO("Built without libdrm, display timing unavailable");
+    return NULL;
+}
+
+#endif // HAVE_LIBDRM
@@ -0,0 +1,12 @@
+#ifndef CAPFRAMEX_DRM_EVENTS_H
+#define CAPFRAMEX_DRM_EVENTS_H
+
+#include "display_timing.h"
+
+// Vblank events of a DRM device as a display timing source. device is a
+// card node such as /dev/dri/card0, NULL picks the first card driving a
+// display. Returns NULL if no usable device is found or the daemon was
+// built without libdrm.
+DisplayTimingSource* drm_events_open(const char* device);
+
+#endif // CAPFRAMEX_DRM_EVENTS_H
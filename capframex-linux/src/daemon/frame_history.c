@@ -0,0 +1,135 @@
+#include "frame_history.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct {
+    pid_t pid;               // 0 = slot unused
+    uint64_t head;           // Frames ever appended
+    uint64_t last_active;    // append_tick of the latest append, for eviction
+    FrameDataPoint* frames;  // FRAME_HISTORY_CAPACITY entries
+} ProcessHistory;
+
+static ProcessHistory histories[FRAME_HISTORY_MAX_PROCESSES];
+static uint64_t append_tick = 0;
+static pthread_mutex_t history_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static ProcessHistory* find_history(pid_t pid) {
+    for (int i = 0; i < FRAME_HISTORY_MAX_PROCESSES; i++) {
+        if (histories[i].pid == pid) {
+            return &histories[i];
+        }
+    }
+    return NULL;
+}
+
+// Take a free slot, or the one of the least recently active process
+static ProcessHistory* claim_history(pid_t pid) {
+    ProcessHistory* slot = &histories[0];
+    for (int i = 0; i < FRAME_HISTORY_MAX_PROCESSES; i++) {
+        if (histories[i].pid == 0) {
+            slot = &histories[i];
+            break;
+        }
+        if (histories[i].last_active < slot->last_active) {
+            slot = &histories[i];
+        }
+    }
+
+    if (slot->pid != 0) {
+        LOG_INFO("Frame history of PID %d evicted for PID %d", slot->pid, pid);
+    }
+    if (!slot->frames) {
+        slot->frames = malloc(FRAME_HISTORY_CAPACITY * sizeof(FrameDataPoint));
+        if (!slot->frames) {
+            LOG_ERROR("Failed to allocate frame history");
+            slot->pid = 0;
+            return NULL;
+        }
+    }
+    slot->pid = pid;
+    slot->head = 0;
+    return slot;
+}
+
+void frame_history_append(const FrameDataPoint* frames, uint32_t count) {
+    if (count == 0 || frames[0].pid == 0) return;
+
+    pthread_mutex_lock(&history_mutex);
+
+    ProcessHistory* history = find_history(frames[0].pid);
+    if (!history) {
+        history = claim_history(frames[0].pid);
+    }
+    if (history) {
+        for (uint32_t i = 0; i < count; i++) {
+            history->frames[(history->head + i) % FRAME_HISTORY_CAPACITY] = frames[i];
+        }
+        history->head += count;
+        history->last_active = ++append_tick;
+    }
+
+    pthread_mutex_unlock(&history_mutex);
+}
+
+uint32_t frame_history_replay(pid_t pid, uint32_t duration_ms,
+                              frame_history_visitor visitor, void* ctx) {
+    pthread_mutex_lock(&history_mutex);
+
+    ProcessHistory* history = find_history(pid);
+    if (!history || history->head == 0) {
+        pthread_mutex_unlock(&history_mutex);
+        return 0;
+    }
+
+    uint64_t oldest = history->head > FRAME_HISTORY_CAPACITY ?
+                      history->head - FRAME_HISTORY_CAPACITY : 0;
+    uint64_t newest_ns = history->frames[(history->head - 1) % FRAME_HISTORY_CAPACITY].timestamp_ns;
+    uint64_t window_ns = (uint64_t)duration_ms * 1000000ULL;
+    uint64_t cutoff_ns = newest_ns > window_ns ? newest_ns - window_ns : 0;
+
+    // Walk back to the first frame inside the window
+    uint64_t first = history->head - 1;
+    while (first > oldest &&
+           history->frames[(first - 1) % FRAME_HISTORY_CAPACITY].timestamp_ns >= cutoff_ns) {
+        first--;
+    }
+
+    // Hand out runs that neither wrap nor exceed a batch
+    uint64_t index = first;
+    while (index < history->head) {
+        uint32_t offset = (uint32_t)(index % FRAME_HISTORY_CAPACITY);
+        uint64_t run = history->head - index;
+        if (run > FRAME_HISTORY_CAPACITY - offset) run = FRAME_HISTORY_CAPACITY - offset;
+        if (run > CAPFRAMEX_MAX_FRAME_BATCH) run = CAPFRAMEX_MAX_FRAME_BATCH;
+
+        visitor(&history->frames[offset], (uint32_t)run, ctx);
+        index += run;
+    }
+
+    pthread_mutex_unlock(&history_mutex);
+    return (uint32_t)(history->head - first);
+}
+
+void frame_history_forget(pid_t pid) {
+    pthread_mutex_lock(&history_mutex);
+    ProcessHistory* history = find_history(pid);
+    if (history) {
+        history->pid = 0;
+        history->head = 0;
+        history->last_active = 0;
+    }
+    pthread_mutex_unlock(&history_mutex);
+}
+
+void frame_history_cleanup(void) {
+    pthread_mutex_lock(&history_mutex);
+    for (int i = 0; i < FRAME_HISTORY_MAX_PROCESSES; i++) {
+        free(histories[i].frames);
+        histories[i].frames = NULL;
+        histories[i].pid = 0;
+        histories[i].head = 0;
+    }
+    pthread_mutex_unlock(&history_mutex);
+}
@@ -0,0 +1,30 @@
+#ifndef CAPFRAMEX_FRAME_HISTORY_H
+#define CAPFRAMEX_FRAME_HISTORY_H
+
+#include "common.h"
+
+// Recent frames of every streaming layer, so a capture can start in the past
+// ("last N seconds"). Layers stream whether or not an app is subscribed; the
+// daemon keeps the tail of each stream here and replays it on request.
+
+#define FRAME_HISTORY_CAPACITY 16384      // Frames per process (~68 s at 240 fps)
+#define FRAME_HISTORY_MAX_PROCESSES 8     // Least recently active process is evicted
+
+// Called with consecutive runs of at most CAPFRAMEX_MAX_FRAME_BATCH frames, oldest first
+typedef void (*frame_history_visitor)(const FrameDataPoint* frames, uint32_t count, void* ctx);
+
+// Append frames received from one layer (all frames share frames[0].pid)
+void frame_history_append(const FrameDataPoint* frames, uint32_t count);
+
+// Visit the frames of `pid` from the last `duration_ms`, measured back from
+// its newest frame. Returns the number of frames visited.
+uint32_t frame_history_replay(pid_t pid, uint32_t duration_ms,
+                              frame_history_visitor visitor, void* ctx);
+
+// Drop the history of a process (its layer disconnected)
+void frame_history_forget(pid_t pid);
+
+// Free all histories
+void frame_history_cleanup(void);
+
+#endif // CAPFRAMEX_FRAME_HISTORY_H
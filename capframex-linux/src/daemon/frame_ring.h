@@ -0,0 +1,99 @@
+#ifndef CAPFRAMEX_FRAME_RING_H
+#define CAPFRAMEX_FRAME_RING_H
+
+#include "common.h"
+#include <stddef.h>
+#include <string.h>
+
+// Shared-memory frame ring between one layer (producer) and the daemon
+// (consumer). The layer creates it in a memfd and passes the fd, together
+// with an eventfd for wakeups, alongside MSG_LAYER_HELLO (SCM_RIGHTS).
+// Positions are free-running counters accessed with __atomic builtins since
+// the ring lives in memory shared by two processes.
+#define CAPFRAMEX_FRAME_RING_MAGIC 0x52584643u  // "CFXR"
+#define CAPFRAMEX_FRAME_RING_VERSION 1
+#define CAPFRAMEX_FRAME_RING_CAPACITY 1024     // Must be a power of two
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t frame_size;
+    uint64_t write_pos __attribute__((aligned(64)));  // Written by the layer only
+    uint64_t read_pos __attribute__((aligned(64)));   // Written by the daemon only
+    FrameDataPoint frames[] __attribute__((aligned(64)));
+} FrameRing;
+
+static inline size_t frame_ring_size(uint32_t capacity) {
+    return offsetof(FrameRing, frames) + (size_t)capacity * sizeof(FrameDataPoint);
+}
+
+static inline void frame_ring_init(FrameRing* ring, uint32_t capacity) {
+    memset(ring, 0, offsetof(FrameRing, frames));
+    ring->magic = CAPFRAMEX_FRAME_RING_MAGIC;
+    ring->version = CAPFRAMEX_FRAME_RING_VERSION;
+    ring->capacity = capacity;
+    ring->frame_size = sizeof(FrameDataPoint);
+}
+
+// Check a ring mapped from another process before trusting its header
+static inline bool frame_ring_valid(const FrameRing* ring, size_t mapped_size) {
+    return mapped_size >= offsetof(FrameRing, frames) &&
+           ring->magic == CAPFRAMEX_FRAME_RING_MAGIC &&
+           ring->version == CAPFRAMEX_FRAME_RING_VERSION &&
+           ring->frame_size == sizeof(FrameDataPoint) &&
+           ring->capacity != 0 && (ring->capacity & (ring->capacity - 1)) == 0 &&
+           frame_ring_size(ring->capacity) <= mapped_size;
+}
+
+// Producer: copy up to count frames into the ring, returns how many fit.
+// *needs_wakeup is set when the consumer had drained everything before this
+// write and may be sleeping on the eventfd.
+static inline uint32_t frame_ring_write(FrameRing* ring, const FrameDataPoint* frames,
+                                        uint32_t count, bool* needs_wakeup) {
+    uint64_t w = __atomic_load_n(&ring->write_pos, __ATOMIC_RELAXED);
+    uint64_t r = __atomic_load_n(&ring->read_pos, __ATOMIC_ACQUIRE);
+    uint64_t space = ring->capacity - (w - r);
+    uint32_t n = count < space ? count : (uint32_t)space;
+
+    for (uint32_t i = 0; i < n; i++) {
+        ring->frames[(w + i) & (ring->capacity - 1)] = frames[i];
+    }
+
+    *needs_wakeup = false;
+    if (n > 0) {
+        // Publish, then check whether the consumer had caught up (pairs with
+        // the read_pos store / write_pos load in frame_ring_read)
+        __atomic_store_n(&ring->write_pos, w + n, __ATOMIC_SEQ_CST);
+        *needs_wakeup = __atomic_load_n(&ring->read_pos, __ATOMIC_SEQ_CST) == w;
+    }
+    return n;
+}
+
+// Consumer: copy up to max frames out of the ring, returns how many were read.
+// Call until it returns 0 before waiting for the next wakeup. capacity is the
+// value validated at attach time - the header itself is writable by the layer.
+static inline uint32_t frame_ring_read(FrameRing* ring, uint32_t capacity,
+                                       FrameDataPoint* out, uint32_t max) {
+    uint64_t r = __atomic_load_n(&ring->read_pos, __ATOMIC_RELAXED);
+    uint64_t w = __atomic_load_n(&ring->write_pos, __ATOMIC_SEQ_CST);
+    uint64_t available = w - r;
+
+    if (available > capacity) {
+        // Producer misbehaved - resync rather than read garbage
+        __atomic_store_n(&ring->read_pos, w, __ATOMIC_SEQ_CST);
+        return 0;
+    }
+
+    uint32_t n = available < max ? (uint32_t)available : max;
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = ring->frames[(r + i) & (capacity - 1)];
+    }
+
+    if (n > 0) {
+        __atomic_store_n(&ring->read_pos, r + n, __ATOMIC_SEQ_CST);
+    }
+    return n;
+}
+
+#endif // CAPFRAMEX_FRAME_RING_H
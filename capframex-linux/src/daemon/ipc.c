@@ -1,4 +1,12 @@
+#define _GNU_SOURCE  // accept4
 #include "ipc.h"
+#include "frame_ring.h"
+#include "capture_policy.h"
+#include "pid_list.h"
+#include "output_queue.h"
+#include "message_stream.h"
+#include "frame_history.h"
+#include "display_timing.h"
 #include "ignore_list.h"
 #include "launcher_detect.h"
 #include <stdio.h>
@@ -8,18 +16,23 @@
 #include <unistd.h>
 #include <errno.h>
 #include <pthread.h>
-#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <time.h>
 
-#define MAX_CLIENTS 16
+#define CLIENT_TABLE_INITIAL 16
+#define MAX_EPOLL_EVENTS 64
 #define MAX_LAYERS 64
 #define MAX_APP_SUBSCRIPTIONS 16
-#define RECV_BUFFER_SIZE 4096
+
+// Capabilities advertised to layers in MSG_HELLO_ACK
+#define DAEMON_CAPABILITIES CAPFRAMEX_CAP_FRAME_BATCH
 
 // Blacklist of process names that should not appear in the game list
 // These are system/utility processes that may use Vulkan but aren't games
@@ -63,19 +76,41 @@ static bool is_blacklisted_process(const char* process_name) {
 static int server_socket = -1;
 static int shm_fd = -1;
 static SharedPidList* shm_pids = NULL;
+static pthread_mutex_t pids_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pid_t detected_pids[MAX_TRACKED_PROCESSES];
+static uint32_t detected_count = 0;
+static int policy_fd = -1;
+static SharedCapturePolicy* shm_policy = NULL;
+static pthread_mutex_t policy_mutex = PTHREAD_MUTEX_INITIALIZER;
 static char socket_path[256];
 static pthread_t server_thread;
 static volatile bool running = false;
+static int epoll_fd = -1;
+static int wake_fd = -1;  // eventfd, signalled by ipc_stop()
 static ipc_message_callback message_callback = NULL;
 
 // Generic client tracking
 typedef struct {
     int fd;
     ClientType type;
+    // Shared-memory frame ring passed by a layer (NULL if none)
+    FrameRing* ring;
+    size_t ring_size;
+    uint32_t ring_capacity;
+    int ring_event_fd;
+    // Messages the socket has not taken yet (see output_queue.h)
+    OutputQueue out;
+    bool write_armed;  // EPOLLOUT requested while out has a backlog
+    bool closing;      // Shut down after an overflow, removed on the hangup
+    // Reassembles messages split across reads. Server thread only.
+    MessageStream in;
 } ClientInfo;
 
-static ClientInfo clients[MAX_CLIENTS];
+// Grows as clients connect - every Vulkan process holds a connection
+static ClientInfo* clients = NULL;
 static int client_count = 0;
+static int client_capacity = 0;
+static uint64_t frames_dropped_total = 0;  // Frames dropped from slow clients' queues
 static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Layer clients (frame producers)
@@ -120,7 +155,8 @@ static int create_socket(void) {
 
     unlink(socket_path);
 
-    server_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    // Non-blocking: the edge-triggered server thread accepts until EAGAIN
+    server_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_socket == -1) {
         LOG_ERROR("Failed to create socket: %s", strerror(errno));
         return -1;
@@ -139,7 +175,7 @@ static int create_socket(void) {
 
     chmod(socket_path, 0666);
 
-    if (listen(server_socket, MAX_CLIENTS) == -1) {
+    if (listen(server_socket, SOMAXCONN) == -1) {
         LOG_ERROR("Failed to listen on socket: %s", strerror(errno));
         close(server_socket);
         server_socket = -1;
@@ -174,33 +210,233 @@ static int create_shared_memory(void) {
         return -1;
     }
 
-    memset(shm_pids, 0, sizeof(SharedPidList));
+    // Readers may still map the list of a previous daemon run - keep the
+    // version going instead of clearing it, and close a write it crashed in
+    uint32_t version = __atomic_load_n(&shm_pids->version, __ATOMIC_RELAXED);
+    if (version & 1) {
+        __atomic_store_n(&shm_pids->version, version + 1, __ATOMIC_RELAXED);
+    }
+    shm_pids->magic = SHARED_PID_LIST_MAGIC;
+    pid_list_write(shm_pids, NULL, 0);
     LOG_INFO("Shared memory created: %s", CAPFRAMEX_SHM_NAME);
     return 0;
 }
 
+// Not fatal if this fails - layers without a policy capture at full tier
+// and the daemon still drops blacklisted layers at hello time
+static void create_policy_memory(void) {
+    policy_fd = shm_open(CAPFRAMEX_SHM_POLICY_NAME, O_CREAT | O_RDWR, 0644);
+    if (policy_fd == -1) {
+        LOG_WARN("Failed to create capture policy memory: %s", strerror(errno));
+        return;
+    }
+
+    if (ftruncate(policy_fd, sizeof(SharedCapturePolicy)) == -1) {
+        LOG_WARN("Failed to size capture policy memory: %s", strerror(errno));
+        close(policy_fd);
+        policy_fd = -1;
+        return;
+    }
+
+    shm_policy = mmap(NULL, sizeof(SharedCapturePolicy), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, policy_fd, 0);
+    if (shm_policy == MAP_FAILED) {
+        LOG_WARN("Failed to map capture policy memory: %s", strerror(errno));
+        close(policy_fd);
+        policy_fd = -1;
+        shm_policy = NULL;
+        return;
+    }
+
+    // A layer may hold a mapping from a previous daemon run - go through the
+    // seqlock rather than clearing the table under it
+    capture_policy_begin_write(shm_policy);
+    shm_policy->magic = CAPFRAMEX_CAPTURE_POLICY_MAGIC;
+    shm_policy->version = CAPFRAMEX_CAPTURE_POLICY_VERSION;
+    shm_policy->default_tier = CAPTURE_TIER_FULL;
+    shm_policy->pid_count = 0;
+    shm_policy->name_count = 0;
+    capture_policy_end_write(shm_policy);
+
+    ipc_publish_capture_policy();
+    LOG_INFO("Capture policy published: %s", CAPFRAMEX_SHM_POLICY_NAME);
+}
+
+static void add_policy_name(const char* name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= CAPTURE_POLICY_NAME_LENGTH ||
+        shm_policy->name_count >= CAPTURE_POLICY_MAX_NAMES) {
+        return;
+    }
+    char* slot = shm_policy->ignored_names[shm_policy->name_count++];
+    memset(slot, 0, CAPTURE_POLICY_NAME_LENGTH);
+    memcpy(slot, name, len);
+}
+
+// Drop PID entries of processes that are gone (caller holds policy_mutex
+// and is inside a write)
+static void prune_policy_pids(void) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < shm_policy->pid_count; i++) {
+        pid_t pid = shm_policy->pids[i].pid;
+        if (kill(pid, 0) == 0 || errno != ESRCH) {
+            shm_policy->pids[kept++] = shm_policy->pids[i];
+        }
+    }
+    shm_policy->pid_count = kept;
+}
+
+// What an epoll event refers to, packed with the fd into epoll_data.u64.
+// Frame ring eventfds carry the fd of the client socket that owns the ring.
+typedef enum {
+    EVENT_LISTEN = 0,
+    EVENT_WAKE = 1,
+    EVENT_CLIENT = 2,
+    EVENT_FRAME_RING = 3,
+} EventSource;
+
+static uint64_t event_key(EventSource source, int fd) {
+    return ((uint64_t)source << 32) | (uint32_t)fd;
+}
+
+static int watch_fd(int fd, EventSource source, int key_fd) {
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLET | (source == EVENT_CLIENT ? EPOLLRDHUP : 0),
+        .data.u64 = event_key(source, key_fd)
+    };
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// Caller holds clients_mutex
+static ClientInfo* find_client(int fd) {
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].fd == fd) {
+            return &clients[i];
+        }
+    }
+    return NULL;
+}
+
+// Ask for EPOLLOUT only while there is a backlog to flush
+static void update_write_interest(ClientInfo* client) {
+    bool want_write = !output_queue_empty(&client->out);
+    if (want_write == client->write_armed) return;
+
+    struct epoll_event ev = {
+        .events = EPOLLIN | EPOLLRDHUP | EPOLLET | (want_write ? EPOLLOUT : 0),
+        .data.u64 = event_key(EVENT_CLIENT, client->fd)
+    };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &ev) == 0) {
+        client->write_armed = want_write;
+    }
+}
+
+// Stop talking to a client from any thread: the shutdown wakes the server
+// thread with a hangup, which removes the client
+static void close_client_later(ClientInfo* client) {
+    if (client->closing) return;
+    client->closing = true;
+    output_queue_free(&client->out);
+    shutdown(client->fd, SHUT_RDWR);
+}
+
+// Queue a message for a client without ever blocking. Caller holds clients_mutex.
+static int send_to_client(ClientInfo* client, MessageType type, const void* payload,
+                          uint32_t payload_size) {
+    if (client->closing) return -1;
+
+    MessageHeader header = {
+        .type = type,
+        .payload_size = payload ? payload_size : 0,
+        .timestamp = get_timestamp_ns()
+    };
+
+    uint64_t dropped_before = client->out.dropped_frames;
+    OutputResult result = output_queue_send(&client->out, client->fd, &header, payload);
+
+    uint64_t dropped = client->out.dropped_frames - dropped_before;
+    if (dropped > 0) {
+        __atomic_fetch_add(&frames_dropped_total, dropped, __ATOMIC_RELAXED);
+        LOG_WARN("Client %d is falling behind: dropped %lu oldest frame(s) (%lu total)",
+                 client->fd, (unsigned long)dropped, (unsigned long)client->out.dropped_frames);
+    }
+
+    switch (result) {
+    case OUTPUT_SENT:
+    case OUTPUT_QUEUED:
+        update_write_interest(client);
+        return 0;
+    case OUTPUT_OVERFLOW:
+        LOG_WARN("Client %d is not reading (%zu bytes queued), disconnecting",
+                 client->fd, client->out.used);
+        close_client_later(client);
+        return -1;
+    default:
+        close_client_later(client);
+        return -1;
+    }
+}
+
 static void add_client(int fd) {
     pthread_mutex_lock(&clients_mutex);
-    if (client_count < MAX_CLIENTS) {
-        clients[client_count].fd = fd;
-        clients[client_count].type = CLIENT_TYPE_UNKNOWN;
-        client_count++;
-        LOG_INFO("Client connected (fd=%d, total=%d)", fd, client_count);
-    } else {
-        LOG_WARN("Max clients reached, rejecting connection");
+    if (client_count == client_capacity) {
+        int capacity = client_capacity ? client_capacity * 2 : CLIENT_TABLE_INITIAL;
+        ClientInfo* grown = realloc(clients, (size_t)capacity * sizeof(ClientInfo));
+        if (!grown) {
+            pthread_mutex_unlock(&clients_mutex);
+            LOG_WARN("Out of memory for client table, rejecting connection");
+            close(fd);
+            return;
+        }
+        clients = grown;
+        client_capacity = capacity;
+    }
+
+    if (watch_fd(fd, EVENT_CLIENT, fd) != 0) {
+        pthread_mutex_unlock(&clients_mutex);
+        LOG_WARN("Failed to watch client %d: %s", fd, strerror(errno));
         close(fd);
+        return;
     }
+
+    clients[client_count].fd = fd;
+    clients[client_count].type = CLIENT_TYPE_UNKNOWN;
+    clients[client_count].ring = NULL;
+    clients[client_count].ring_event_fd = -1;
+    output_queue_init(&clients[client_count].out);
+    message_stream_init(&clients[client_count].in);
+    clients[client_count].write_armed = false;
+    clients[client_count].closing = false;
+    client_count++;
+    LOG_INFO("Client connected (fd=%d, total=%d)", fd, client_count);
     pthread_mutex_unlock(&clients_mutex);
 }
 
+static void drain_frame_ring(int fd);
+static void detach_frame_ring(ClientInfo* client);
+
 static void remove_client(int fd) {
+    // Forward frames still sitting in the layer's ring before it goes away
+    drain_frame_ring(fd);
+
     // First, unregister from layer/app tracking
     ipc_unregister_layer(fd);
     ipc_unregister_app(fd);
+    display_timing_release(fd);
 
     pthread_mutex_lock(&clients_mutex);
     for (int i = 0; i < client_count; i++) {
         if (clients[i].fd == fd) {
+            OutputQueue* out = &clients[i].out;
+            if (out->dropped_messages > 0 || out->coalesced_messages > 0) {
+                LOG_INFO("Client %d dropped %lu message(s) (%lu frames), coalesced %lu",
+                         fd, (unsigned long)out->dropped_messages, (unsigned long)out->dropped_frames,
+                         (unsigned long)out->coalesced_messages);
+            }
+            output_queue_free(out);
+            message_stream_free(&clients[i].in);
+            detach_frame_ring(&clients[i]);
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
             close(fd);
             for (int j = i; j < client_count - 1; j++) {
                 clients[j] = clients[j + 1];
@@ -237,6 +473,181 @@ ClientType ipc_get_client_type(int fd) {
     return type;
 }
 
+// Frame rings are attached, drained and detached only by the server thread,
+// so the ring pointer can be used outside clients_mutex once looked up.
+static void detach_frame_ring(ClientInfo* client) {
+    if (client->ring) {
+        munmap(client->ring, client->ring_size);
+        client->ring = NULL;
+    }
+    if (client->ring_event_fd >= 0) {
+        if (epoll_fd >= 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->ring_event_fd, NULL);
+        }
+        close(client->ring_event_fd);
+        client->ring_event_fd = -1;
+    }
+}
+
+// Map the memfd ring a layer passed with its hello. Takes ownership of both fds.
+static void attach_frame_ring(int client_fd, int ring_fd, int event_fd) {
+    struct stat st;
+    FrameRing* ring = MAP_FAILED;
+
+    if (fstat(ring_fd, &st) == 0 && st.st_size > 0) {
+        ring = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    }
+    close(ring_fd);  // The mapping keeps the memory alive
+
+    if (ring == MAP_FAILED || !frame_ring_valid(ring, (size_t)st.st_size)) {
+        LOG_WARN("Rejected frame ring from client %d", client_fd);
+        if (ring != MAP_FAILED) munmap(ring, (size_t)st.st_size);
+        close(event_fd);
+        return;
+    }
+
+    pthread_mutex_lock(&clients_mutex);
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].fd == client_fd) {
+            if (clients[i].ring) {
+                break;  // Already attached (repeated hello)
+            }
+            // Skip anything left over from a previous daemon instance
+            __atomic_store_n(&ring->read_pos, __atomic_load_n(&ring->write_pos, __ATOMIC_ACQUIRE),
+                             __ATOMIC_SEQ_CST);
+            // Without wakeups the ring would never be drained - the layer
+            // keeps using the socket instead (no CAPFRAMEX_CAP_SHM_RING)
+            if (watch_fd(event_fd, EVENT_FRAME_RING, client_fd) != 0) {
+                LOG_WARN("Failed to watch frame ring of client %d: %s", client_fd, strerror(errno));
+                break;
+            }
+            clients[i].ring = ring;
+            clients[i].ring_size = (size_t)st.st_size;
+            clients[i].ring_capacity = ring->capacity;
+            clients[i].ring_event_fd = event_fd;
+            pthread_mutex_unlock(&clients_mutex);
+            LOG_INFO("Frame ring attached: fd=%d, capacity=%u", client_fd, ring->capacity);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&clients_mutex);
+
+    munmap(ring, (size_t)st.st_size);
+    close(event_fd);
+}
+
+static bool client_has_frame_ring(int fd) {
+    bool has_ring = false;
+    pthread_mutex_lock(&clients_mutex);
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].fd == fd) {
+            has_ring = clients[i].ring != NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&clients_mutex);
+    return has_ring;
+}
+
+// Forward everything currently in a client's frame ring
+static void drain_frame_ring(int fd) {
+    FrameRing* ring = NULL;
+    uint32_t capacity = 0;
+
+    pthread_mutex_lock(&clients_mutex);
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].fd == fd) {
+            ring = clients[i].ring;
+            capacity = clients[i].ring_capacity;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&clients_mutex);
+
+    if (!ring) return;
+
+    FrameDataPoint frames[CAPFRAMEX_MAX_FRAME_BATCH];
+    uint32_t count;
+    while ((count = frame_ring_read(ring, capacity, frames, CAPFRAMEX_MAX_FRAME_BATCH)) > 0) {
+        ipc_forward_frame_batch(frames, count);
+    }
+}
+
+// Receive from a client, picking up the ring/eventfd pair a layer may attach
+static ssize_t recv_client(int fd, char* buffer, size_t size) {
+    union {
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { .iov_base = buffer, .iov_len = size };
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf)
+    };
+
+    // Never blocks: the server thread reads edge-triggered until EAGAIN
+    ssize_t len = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    if (len < 0) {
+        return len;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+
+        int fds[2];
+        size_t fd_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        if (fd_count > 2) fd_count = 2;
+        memcpy(fds, CMSG_DATA(cmsg), fd_count * sizeof(int));
+
+        if (fd_count == 2) {
+            attach_frame_ring(fd, fds[0], fds[1]);
+        } else {
+            for (size_t i = 0; i < fd_count; i++) close(fds[i]);
+        }
+    }
+
+    return len;
+}
+
+// Rewrite the shared PID list: detected games plus processes with a
+// connected layer. Call without layers_mutex held.
+static void publish_pid_list(void) {
+    pthread_mutex_lock(&pids_mutex);
+    if (!shm_pids) {
+        pthread_mutex_unlock(&pids_mutex);
+        return;
+    }
+
+    SharedPidEntry entries[MAX_TRACKED_PROCESSES];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < detected_count; i++) {
+        entries[count].pid = detected_pids[i];
+        entries[count].flags = SHARED_PID_DETECTED;
+        count++;
+    }
+
+    pthread_mutex_lock(&layers_mutex);
+    for (int i = 0; i < layer_count; i++) {
+        uint32_t j = 0;
+        while (j < count && entries[j].pid != layer_clients[i].pid) {
+            j++;
+        }
+        if (j == count) {
+            if (count == MAX_TRACKED_PROCESSES) continue;
+            entries[count].pid = layer_clients[i].pid;
+            entries[count].flags = 0;
+            count++;
+        }
+        entries[j].flags |= SHARED_PID_LAYER;
+    }
+    pthread_mutex_unlock(&layers_mutex);
+
+    pid_list_write(shm_pids, entries, count);
+    pthread_mutex_unlock(&pids_mutex);
+}
+
 // Layer client management
 // Returns true if this is a new layer (should be broadcast), false if updated or blacklisted
 bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
@@ -274,6 +685,7 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
 
             // Update present timing support status
             layer_clients[i].present_timing_supported = hello->present_timing_supported != 0;
+            layer_clients[i].graphics_api = hello->graphics_api;
 
             // Capture data needed for broadcast before releasing lock
             pid_t broadcast_pid = layer_clients[i].pid;
@@ -284,6 +696,7 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
             uint32_t broadcast_height = layer_clients[i].swapchain_height;
             bool has_swapchain = layer_clients[i].has_swapchain;
             bool broadcast_present_timing = layer_clients[i].present_timing_supported;
+            uint8_t broadcast_api = layer_clients[i].graphics_api;
 
             strncpy(broadcast_process_name, layer_clients[i].process_name, sizeof(broadcast_process_name) - 1);
             broadcast_process_name[sizeof(broadcast_process_name) - 1] = '\0';
@@ -309,6 +722,7 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
                     update.resolution_height = broadcast_height;
                 }
                 update.present_timing_supported = broadcast_present_timing ? 1 : 0;
+                update.graphics_api = broadcast_api;
                 LOG_INFO("[DEBUG] Broadcasting GPU update to apps: PID=%d, GPU=%s, res=%ux%u, present_timing=%d",
                          update.pid, update.gpu_name, update.resolution_width, update.resolution_height,
                          update.present_timing_supported);
@@ -328,11 +742,13 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
             strncpy(layer_clients[i].gpu_name, hello->gpu_name,
                     sizeof(layer_clients[i].gpu_name) - 1);
             layer_clients[i].present_timing_supported = hello->present_timing_supported != 0;
+            layer_clients[i].graphics_api = hello->graphics_api;
             LOG_INFO("Layer updated (same fd): PID=%d, process=%s, GPU=%s, present_timing=%d",
                      hello->pid, hello->process_name, hello->gpu_name,
                      layer_clients[i].present_timing_supported);
             pthread_mutex_unlock(&layers_mutex);
             set_client_type(client_fd, CLIENT_TYPE_LAYER);
+            publish_pid_list();
             return true;  // New PID on existing connection, broadcast
         }
     }
@@ -351,6 +767,7 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
         layer->swapchain_height = 0;
         layer->swapchain_format = 0;
         layer->present_timing_supported = hello->present_timing_supported != 0;
+        layer->graphics_api = hello->graphics_api;
         layer_count++;
 
         LOG_INFO("Layer registered: PID=%d, process=%s, GPU=%s, present_timing=%d (total=%d)",
@@ -358,6 +775,7 @@ bool ipc_register_layer(int client_fd, const LayerHelloPayload* hello) {
                  layer->present_timing_supported, layer_count);
         pthread_mutex_unlock(&layers_mutex);
         set_client_type(client_fd, CLIENT_TYPE_LAYER);
+        publish_pid_list();
         return true;  // New layer, broadcast
     } else {
         LOG_WARN("Max layers reached, cannot register PID=%d", hello->pid);
@@ -387,23 +805,41 @@ void ipc_update_layer_swapchain(int client_fd, const SwapchainInfoPayload* info)
 }
 
 void ipc_unregister_layer(int client_fd) {
+    pid_t pid = 0;
+    bool removed = false;
     pthread_mutex_lock(&layers_mutex);
 
     for (int i = 0; i < layer_count; i++) {
         if (layer_clients[i].fd == client_fd) {
             LOG_INFO("Layer unregistered: PID=%d, process=%s",
                      layer_clients[i].pid, layer_clients[i].process_name);
+            pid = layer_clients[i].pid;
 
             // Shift remaining layers
             for (int j = i; j < layer_count - 1; j++) {
                 layer_clients[j] = layer_clients[j + 1];
             }
             layer_count--;
+            removed = true;
             break;
         }
     }
 
+    // Keep the history while another connection of the process is still streaming
+    for (int i = 0; pid != 0 && i < layer_count; i++) {
+        if (layer_clients[i].pid == pid) {
+            pid = 0;
+        }
+    }
+
     pthread_mutex_unlock(&layers_mutex);
+
+    if (pid != 0) {
+        frame_history_forget(pid);
+    }
+    if (removed) {
+        publish_pid_list();
+    }
 }
 
 LayerClient* ipc_get_layer_by_pid(pid_t pid) {
@@ -473,15 +909,40 @@ bool ipc_get_layer_by_pid_copy(pid_t pid, LayerClient* out) {
     return false;
 }
 
+static void send_history_batch(const FrameDataPoint* frames, uint32_t count, void* ctx) {
+    int fd = *(const int*)ctx;
+    char payload[sizeof(FrameBatchHeader) + CAPFRAMEX_MAX_FRAME_BATCH * sizeof(FrameDataPoint)];
+    FrameBatchHeader batch = { .count = count, .frame_size = sizeof(FrameDataPoint) };
+
+    memcpy(payload, &batch, sizeof(batch));
+    memcpy(payload + sizeof(batch), frames, count * sizeof(FrameDataPoint));
+    ipc_send(fd, MSG_FRAME_HISTORY, payload, sizeof(batch) + count * sizeof(FrameDataPoint));
+}
+
+// Replay the recent frames of target_pid, terminated by an empty batch.
+// Called with subscriptions_mutex held so no live frame overtakes the replay.
+static void replay_history(int client_fd, pid_t target_pid, uint32_t history_ms) {
+    uint32_t count = frame_history_replay(target_pid, history_ms, send_history_batch, &client_fd);
+
+    FrameBatchHeader end = { .count = 0, .frame_size = sizeof(FrameDataPoint) };
+    ipc_send(client_fd, MSG_FRAME_HISTORY, &end, sizeof(end));
+    LOG_INFO("Replayed %u frame(s) (%u ms) of PID %d to client %d",
+             count, history_ms, target_pid, client_fd);
+}
+
 // App subscription management
-void ipc_subscribe_app(int client_fd, pid_t target_pid) {
+void ipc_subscribe_app(int client_fd, pid_t target_pid, uint32_t capabilities, uint32_t history_ms) {
     pthread_mutex_lock(&subscriptions_mutex);
 
     // Check if already subscribed (update)
     for (int i = 0; i < subscription_count; i++) {
         if (app_subscriptions[i].fd == client_fd) {
             app_subscriptions[i].subscribed_pid = target_pid;
+            app_subscriptions[i].capabilities = capabilities;
             LOG_INFO("App subscription updated: fd=%d -> PID=%d", client_fd, target_pid);
+            if (history_ms > 0) {
+                replay_history(client_fd, target_pid, history_ms);
+            }
             pthread_mutex_unlock(&subscriptions_mutex);
             set_client_type(client_fd, CLIENT_TYPE_APP);
             return;
@@ -492,9 +953,13 @@ void ipc_subscribe_app(int client_fd, pid_t target_pid) {
     if (subscription_count < MAX_APP_SUBSCRIPTIONS) {
         app_subscriptions[subscription_count].fd = client_fd;
         app_subscriptions[subscription_count].subscribed_pid = target_pid;
+        app_subscriptions[subscription_count].capabilities = capabilities;
         subscription_count++;
-        LOG_INFO("App subscribed: fd=%d -> PID=%d (total=%d)",
-                 client_fd, target_pid, subscription_count);
+        LOG_INFO("App subscribed: fd=%d -> PID=%d, caps=0x%x (total=%d)",
+                 client_fd, target_pid, capabilities, subscription_count);
+        if (history_ms > 0) {
+            replay_history(client_fd, target_pid, history_ms);
+        }
     } else {
         LOG_WARN("Max subscriptions reached");
     }
@@ -540,13 +1005,42 @@ static uint64_t frames_forwarded = 0;
 static uint64_t last_frame_log = 0;
 static bool first_frame_logged = false;
 
-void ipc_forward_frame_data(const FrameDataPoint* frame) {
-    frames_received++;
+// Send frames to one subscriber, as a single batch message when supported
+static int send_frames_to_app(const AppSubscription* sub, const FrameDataPoint* frames, uint32_t count) {
+    if (count > 1 && (sub->capabilities & CAPFRAMEX_CAP_FRAME_BATCH)) {
+        char payload[sizeof(FrameBatchHeader) + CAPFRAMEX_MAX_FRAME_BATCH * sizeof(FrameDataPoint)];
+        FrameBatchHeader batch = { .count = count, .frame_size = sizeof(FrameDataPoint) };
+
+        memcpy(payload, &batch, sizeof(batch));
+        memcpy(payload + sizeof(batch), frames, count * sizeof(FrameDataPoint));
+        return ipc_send(sub->fd, MSG_FRAMETIME_BATCH, payload,
+                        sizeof(batch) + count * sizeof(FrameDataPoint)) == 0 ? (int)count : 0;
+    }
+
+    int sent = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (ipc_send(sub->fd, MSG_FRAMETIME_DATA, (void*)&frames[i], sizeof(FrameDataPoint)) == 0) {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+void ipc_forward_frame_batch(const FrameDataPoint* frames, uint32_t count) {
+    if (count == 0) return;
+    if (count > CAPFRAMEX_MAX_FRAME_BATCH) count = CAPFRAMEX_MAX_FRAME_BATCH;
+
+    // All frames of a batch come from the same layer
+    pid_t pid = frames[0].pid;
+    frames_received += count;
+
+    // Recorded before forwarding, so a replay never misses a forwarded frame
+    frame_history_append(frames, count);
 
     // Log the very first frame for debugging
     if (!first_frame_logged) {
         LOG_INFO(">>> First frame received! pid=%d, frametime=%.2fms <<<",
-                 frame->pid, frame->frametime_ms);
+                 pid, frames[0].frametime_ms);
         first_frame_logged = true;
     }
 
@@ -554,29 +1048,27 @@ void ipc_forward_frame_data(const FrameDataPoint* frame) {
 
     int forwarded_this_frame = 0;
     for (int i = 0; i < subscription_count; i++) {
-        if (app_subscriptions[i].subscribed_pid == frame->pid) {
+        if (app_subscriptions[i].subscribed_pid == pid) {
             // This app is subscribed to this layer's frames
-            int result = ipc_send(app_subscriptions[i].fd, MSG_FRAMETIME_DATA,
-                     (void*)frame, sizeof(FrameDataPoint));
-            if (result == 0) {
-                frames_forwarded++;
-                forwarded_this_frame++;
-            }
+            int sent = send_frames_to_app(&app_subscriptions[i], frames, count);
+            frames_forwarded += sent;
+            forwarded_this_frame += sent;
         }
     }
 
     // Log periodically (every 500 frames for more visibility)
     if (frames_received - last_frame_log >= 500) {
-        LOG_INFO("Frame stats: received=%lu, forwarded=%lu, subs=%d, frame_pid=%d, forwarded_now=%d",
+        LOG_INFO("Frame stats: received=%lu, forwarded=%lu, dropped=%lu, subs=%d, frame_pid=%d, forwarded_now=%d",
                  (unsigned long)frames_received, (unsigned long)frames_forwarded,
-                 subscription_count, frame->pid, forwarded_this_frame);
+                 (unsigned long)__atomic_load_n(&frames_dropped_total, __ATOMIC_RELAXED),
+                 subscription_count, pid, forwarded_this_frame);
 
         // Log subscription details - helps diagnose PID mismatch
         for (int i = 0; i < subscription_count; i++) {
             LOG_INFO("  Sub[%d]: fd=%d, wants_pid=%d (frame has pid=%d, match=%s)",
                      i, app_subscriptions[i].fd, app_subscriptions[i].subscribed_pid,
-                     frame->pid,
-                     app_subscriptions[i].subscribed_pid == frame->pid ? "YES" : "NO");
+                     pid,
+                     app_subscriptions[i].subscribed_pid == pid ? "YES" : "NO");
         }
 
         // Log layer info
@@ -594,6 +1086,50 @@ void ipc_forward_frame_data(const FrameDataPoint* frame) {
     pthread_mutex_unlock(&subscriptions_mutex);
 }
 
+void ipc_forward_frame_data(const FrameDataPoint* frame) {
+    ipc_forward_frame_batch(frame, 1);
+}
+
+void ipc_forward_layer_overhead(const LayerOverheadPayload* stats) {
+    pthread_mutex_lock(&subscriptions_mutex);
+    for (int i = 0; i < subscription_count; i++) {
+        if (app_subscriptions[i].subscribed_pid == stats->pid) {
+            ipc_send(app_subscriptions[i].fd, MSG_LAYER_OVERHEAD_STATS, (void*)stats, sizeof(*stats));
+        }
+    }
+    pthread_mutex_unlock(&subscriptions_mutex);
+}
+
+// Unpack a MSG_FRAMETIME_BATCH payload. Frames may be smaller (older layer)
+// or larger (newer layer) than our FrameDataPoint; copy the common prefix.
+static void handle_frame_batch(int client_fd, const char* payload, uint32_t payload_size) {
+    FrameBatchHeader batch;
+    if (payload_size < sizeof(batch)) {
+        LOG_WARN("Short frame batch from client %d", client_fd);
+        return;
+    }
+    memcpy(&batch, payload, sizeof(batch));
+
+    if (batch.count == 0 || batch.frame_size == 0 ||
+        batch.count > CAPFRAMEX_MAX_FRAME_BATCH ||
+        (uint64_t)batch.count * batch.frame_size > payload_size - sizeof(batch)) {
+        LOG_WARN("Malformed frame batch from client %d (count=%u, frame_size=%u, payload=%u)",
+                 client_fd, batch.count, batch.frame_size, payload_size);
+        return;
+    }
+
+    FrameDataPoint frames[CAPFRAMEX_MAX_FRAME_BATCH];
+    size_t copy_size = batch.frame_size < sizeof(FrameDataPoint) ? batch.frame_size : sizeof(FrameDataPoint);
+    const char* src = payload + sizeof(batch);
+
+    for (uint32_t i = 0; i < batch.count; i++) {
+        memset(&frames[i], 0, sizeof(frames[i]));
+        memcpy(&frames[i], src + (size_t)i * batch.frame_size, copy_size);
+    }
+
+    ipc_forward_frame_batch(frames, batch.count);
+}
+
 static void handle_client_message(int client_fd, char* buffer, ssize_t len) {
     if (len < (ssize_t)sizeof(MessageHeader)) {
         LOG_WARN("Received incomplete message from client %d", client_fd);
@@ -607,13 +1143,28 @@ static void handle_client_message(int client_fd, char* buffer, ssize_t len) {
 
     // Handle frame data forwarding (high priority, before callback)
     if (header->type == MSG_FRAMETIME_DATA && payload) {
-        FrameDataPoint* frame = (FrameDataPoint*)payload;
-        ipc_forward_frame_data(frame);
+        // Older layers send shorter frames - missing fields stay zero
+        FrameDataPoint frame = {0};
+        memcpy(&frame, payload, header->payload_size < sizeof(frame) ? header->payload_size : sizeof(frame));
+        ipc_forward_frame_data(&frame);
+        return;  // Don't pass to callback
+    }
+
+    if (header->type == MSG_FRAMETIME_BATCH && payload) {
+        handle_frame_batch(client_fd, payload, header->payload_size);
         return;  // Don't pass to callback
     }
 
+    if (header->type == MSG_LAYER_OVERHEAD_STATS && payload) {
+        LayerOverheadPayload stats = {0};
+        memcpy(&stats, payload, header->payload_size < sizeof(stats) ? header->payload_size : sizeof(stats));
+        ipc_forward_layer_overhead(&stats);
+        return;
+    }
+
     // Note: MSG_LAYER_HELLO, MSG_SWAPCHAIN_CREATED, MSG_SWAPCHAIN_DESTROYED
-    // are all handled in main.c callback to ensure proper broadcast to apps
+    // are all handled in main.c callback to ensure proper broadcast to apps;
+    // the hello is additionally acknowledged below
 
     // Pass to main callback for handling
     if (message_callback) {
@@ -625,76 +1176,148 @@ static void handle_client_message(int client_fd, char* buffer, ssize_t len) {
         case MSG_PING:
             ipc_send(client_fd, MSG_PONG, NULL, 0);
             break;
+        case MSG_LAYER_HELLO: {
+            // Tell the layer which protocol extensions it may use
+            HelloAckPayload ack = { .capabilities = DAEMON_CAPABILITIES };
+            if (client_has_frame_ring(client_fd)) {
+                ack.capabilities |= CAPFRAMEX_CAP_SHM_RING;
+            }
+            ipc_send(client_fd, MSG_HELLO_ACK, &ack, sizeof(ack));
+            break;
+        }
         default:
             break;
     }
 }
 
-static void* server_thread_func(void* arg) {
-    (void)arg;
+static void dispatch_client_message(void* context, char* message, size_t len) {
+    handle_client_message((int)(intptr_t)context, message, (ssize_t)len);
+}
 
-    struct pollfd* fds = malloc((MAX_CLIENTS + 1) * sizeof(struct pollfd));
-    if (!fds) {
-        LOG_ERROR("Failed to allocate poll fds");
-        return NULL;
+// Flush a client's backlog once its socket is writable again
+static void flush_client(int fd) {
+    pthread_mutex_lock(&clients_mutex);
+    ClientInfo* client = find_client(fd);
+    if (client && !client->closing) {
+        if (output_queue_flush(&client->out, fd) == OUTPUT_ERROR) {
+            close_client_later(client);
+        } else {
+            update_write_interest(client);
+        }
     }
+    pthread_mutex_unlock(&clients_mutex);
+}
 
-    while (running) {
-        int nfds = 0;
+static void accept_clients(void) {
+    for (;;) {
+        // Non-blocking: sends queue instead of stalling the IPC thread
+        int client_fd = accept4(server_socket, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN("Accept failed: %s", strerror(errno));
+            }
+            return;
+        }
+        add_client(client_fd);
+    }
+}
 
-        // Add server socket
-        fds[nfds].fd = server_socket;
-        fds[nfds].events = POLLIN;
-        nfds++;
+// Read until the socket is drained (edge-triggered), then drop the client
+// if it hung up. A read may hold any number of messages (the layer batches
+// frames into one write) and end in the middle of one.
+static void read_client(int fd, uint32_t events) {
+    static char buffer[MESSAGE_STREAM_READ_SIZE];  // Server thread only
+    bool closed = (events & (EPOLLHUP | EPOLLERR)) != 0;
 
-        // Add client sockets
-        pthread_mutex_lock(&clients_mutex);
-        for (int i = 0; i < client_count; i++) {
-            fds[nfds].fd = clients[i].fd;
-            fds[nfds].events = POLLIN;
-            nfds++;
+    // Clients are only added and removed on this thread, so the entry stays put
+    pthread_mutex_lock(&clients_mutex);
+    ClientInfo* client = find_client(fd);
+    pthread_mutex_unlock(&clients_mutex);
+    if (!client) return;
+
+    for (;;) {
+        ssize_t len = recv_client(fd, buffer, sizeof(buffer));
+        if (len > 0) {
+            if (!message_stream_feed(&client->in, buffer, (size_t)len,
+                                     dispatch_client_message, (void*)(intptr_t)fd)) {
+                LOG_WARN("Corrupt message stream from client %d, disconnecting", fd);
+                closed = true;
+                break;
+            }
+            continue;
         }
-        pthread_mutex_unlock(&clients_mutex);
+        if (len < 0 && errno == EINTR) continue;
+        if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closed = true;
+        }
+        break;
+    }
+
+    if (closed) {
+        remove_client(fd);
+    }
+}
+
+static void* server_thread_func(void* arg) {
+    (void)arg;
+    struct epoll_event events[MAX_EPOLL_EVENTS];
 
-        int ret = poll(fds, nfds, 1000);  // 1 second timeout
-        if (ret < 0) {
+    while (running) {
+        int count = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (count < 0) {
             if (errno == EINTR) continue;
-            LOG_ERROR("Poll error: %s", strerror(errno));
+            LOG_ERROR("epoll_wait error: %s", strerror(errno));
             break;
         }
 
-        if (ret == 0) continue;  // Timeout
-
-        // Check server socket for new connections
-        if (fds[0].revents & POLLIN) {
-            int client_fd = accept(server_socket, NULL, NULL);
-            if (client_fd != -1) {
-                add_client(client_fd);
+        for (int i = 0; i < count && running; i++) {
+            EventSource source = (EventSource)(events[i].data.u64 >> 32);
+            int fd = (int)(uint32_t)events[i].data.u64;
+
+            switch (source) {
+            case EVENT_LISTEN:
+                accept_clients();
+                break;
+            case EVENT_WAKE:
+                break;  // ipc_stop() - running is false now
+            case EVENT_FRAME_RING: {
+                // fd is the ring's owner; reset the eventfd before draining so
+                // a wakeup during the drain is not lost
+                int event_fd = -1;
+                pthread_mutex_lock(&clients_mutex);
+                for (int c = 0; c < client_count; c++) {
+                    if (clients[c].fd == fd) {
+                        event_fd = clients[c].ring_event_fd;
+                        break;
+                    }
+                }
+                pthread_mutex_unlock(&clients_mutex);
+                if (event_fd >= 0) {
+                    uint64_t wakeups;
+                    if (read(event_fd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+                        LOG_WARN("Frame ring eventfd read failed: %s", strerror(errno));
+                    }
+                    drain_frame_ring(fd);
+                }
+                break;
             }
-        }
-
-        // Check client sockets for data
-        char buffer[RECV_BUFFER_SIZE];
-        for (int i = 1; i < nfds; i++) {
-            if (fds[i].revents & POLLIN) {
-                ssize_t len = recv(fds[i].fd, buffer, sizeof(buffer), 0);
-                if (len <= 0) {
-                    remove_client(fds[i].fd);
-                } else {
-                    handle_client_message(fds[i].fd, buffer, len);
+            case EVENT_CLIENT:
+                if (events[i].events & EPOLLOUT) {
+                    flush_client(fd);
                 }
-            } else if (fds[i].revents & (POLLHUP | POLLERR)) {
-                remove_client(fds[i].fd);
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                    read_client(fd, events[i].events);
+                }
+                break;
             }
         }
     }
 
-    free(fds);
     return NULL;
 }
 
 int ipc_init(void) {
-    memset(clients, 0, sizeof(clients));
     memset(layer_clients, 0, sizeof(layer_clients));
     memset(app_subscriptions, 0, sizeof(app_subscriptions));
 
@@ -708,37 +1331,74 @@ int ipc_init(void) {
         return -1;
     }
 
+    create_policy_memory();
+
     return 0;
 }
 
 int ipc_start(ipc_message_callback callback) {
     message_callback = callback;
-    running = true;
 
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epoll_fd == -1 || wake_fd == -1 ||
+        watch_fd(server_socket, EVENT_LISTEN, server_socket) != 0 ||
+        watch_fd(wake_fd, EVENT_WAKE, wake_fd) != 0) {
+        LOG_ERROR("Failed to set up epoll: %s", strerror(errno));
+        goto fail;
+    }
+
+    running = true;
     if (pthread_create(&server_thread, NULL, server_thread_func, NULL) != 0) {
         LOG_ERROR("Failed to create server thread: %s", strerror(errno));
         running = false;
-        return -1;
+        goto fail;
     }
 
     LOG_INFO("IPC server started");
     return 0;
+
+fail:
+    if (wake_fd != -1) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    if (epoll_fd != -1) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+    return -1;
 }
 
 void ipc_stop(void) {
     if (!running) return;
 
     running = false;
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        LOG_WARN("Failed to wake IPC server: %s", strerror(errno));
+    }
     pthread_join(server_thread, NULL);
 
     // Close all client connections
     pthread_mutex_lock(&clients_mutex);
     for (int i = 0; i < client_count; i++) {
+        output_queue_free(&clients[i].out);
+        message_stream_free(&clients[i].in);
+        detach_frame_ring(&clients[i]);
         close(clients[i].fd);
     }
     client_count = 0;
+    free(clients);
+    clients = NULL;
+    client_capacity = 0;
     pthread_mutex_unlock(&clients_mutex);
 
+    close(wake_fd);
+    wake_fd = -1;
+    close(epoll_fd);
+    epoll_fd = -1;
+
     // Clear layer and subscription tracking
     pthread_mutex_lock(&layers_mutex);
     layer_count = 0;
@@ -760,6 +1420,7 @@ void ipc_cleanup(void) {
         unlink(socket_path);
     }
 
+    pthread_mutex_lock(&pids_mutex);
     if (shm_pids) {
         munmap(shm_pids, sizeof(SharedPidList));
         shm_pids = NULL;
@@ -770,26 +1431,30 @@ void ipc_cleanup(void) {
         shm_unlink(CAPFRAMEX_SHM_NAME);
         shm_fd = -1;
     }
-}
-
-int ipc_send(int client_fd, MessageType type, void* payload, uint32_t payload_size) {
-    size_t total_size = sizeof(MessageHeader) + payload_size;
-    char* buffer = malloc(total_size);
-    if (!buffer) return -1;
+    pthread_mutex_unlock(&pids_mutex);
 
-    MessageHeader* header = (MessageHeader*)buffer;
-    header->type = type;
-    header->payload_size = payload_size;
-    header->timestamp = get_timestamp_ns();
+    pthread_mutex_lock(&policy_mutex);
+    if (shm_policy) {
+        munmap(shm_policy, sizeof(SharedCapturePolicy));
+        shm_policy = NULL;
+    }
 
-    if (payload && payload_size > 0) {
-        memcpy(buffer + sizeof(MessageHeader), payload, payload_size);
+    if (policy_fd != -1) {
+        close(policy_fd);
+        shm_unlink(CAPFRAMEX_SHM_POLICY_NAME);
+        policy_fd = -1;
     }
+    pthread_mutex_unlock(&policy_mutex);
 
-    ssize_t sent = send(client_fd, buffer, total_size, MSG_NOSIGNAL);
-    free(buffer);
+    frame_history_cleanup();
+}
 
-    return (sent == (ssize_t)total_size) ? 0 : -1;
+int ipc_send(int client_fd, MessageType type, void* payload, uint32_t payload_size) {
+    pthread_mutex_lock(&clients_mutex);
+    ClientInfo* client = find_client(client_fd);
+    int result = client ? send_to_client(client, type, payload, payload_size) : -1;
+    pthread_mutex_unlock(&clients_mutex);
+    return result;
 }
 
 int ipc_broadcast(MessageType type, void* payload, uint32_t payload_size) {
@@ -797,7 +1462,7 @@ int ipc_broadcast(MessageType type, void* payload, uint32_t payload_size) {
 
     pthread_mutex_lock(&clients_mutex);
     for (int i = 0; i < client_count; i++) {
-        if (ipc_send(clients[i].fd, type, payload, payload_size) == 0) {
+        if (send_to_client(&clients[i], type, payload, payload_size) == 0) {
             success_count++;
         }
     }
@@ -812,7 +1477,7 @@ int ipc_broadcast_to_apps(MessageType type, void* payload, uint32_t payload_size
     pthread_mutex_lock(&clients_mutex);
     for (int i = 0; i < client_count; i++) {
         if (clients[i].type == CLIENT_TYPE_APP) {
-            if (ipc_send(clients[i].fd, type, payload, payload_size) == 0) {
+            if (send_to_client(&clients[i], type, payload, payload_size) == 0) {
                 success_count++;
             }
         }
@@ -829,7 +1494,7 @@ int ipc_broadcast_to_non_layers(MessageType type, void* payload, uint32_t payloa
     for (int i = 0; i < client_count; i++) {
         // Send to all clients that are NOT layers (apps and unknown clients)
         if (clients[i].type != CLIENT_TYPE_LAYER) {
-            if (ipc_send(clients[i].fd, type, payload, payload_size) == 0) {
+            if (send_to_client(&clients[i], type, payload, payload_size) == 0) {
                 success_count++;
             }
         }
@@ -844,10 +1509,12 @@ int ipc_update_active_pids(pid_t* pids, uint32_t count) {
 
     uint32_t copy_count = (count > MAX_TRACKED_PROCESSES) ? MAX_TRACKED_PROCESSES : count;
 
-    shm_pids->version++;
-    shm_pids->count = copy_count;
-    memcpy(shm_pids->pids, pids, copy_count * sizeof(pid_t));
+    pthread_mutex_lock(&pids_mutex);
+    memcpy(detected_pids, pids, copy_count * sizeof(pid_t));
+    detected_count = copy_count;
+    pthread_mutex_unlock(&pids_mutex);
 
+    publish_pid_list();
     return 0;
 }
 
@@ -865,3 +1532,67 @@ bool ipc_has_clients(void) {
 bool ipc_is_blacklisted_process(const char* process_name) {
     return is_blacklisted_process(process_name);
 }
+
+void ipc_publish_capture_policy(void) {
+    pthread_mutex_lock(&policy_mutex);
+    if (!shm_policy) {
+        pthread_mutex_unlock(&policy_mutex);
+        return;
+    }
+
+    capture_policy_begin_write(shm_policy);
+
+    // Same names is_blacklisted_process() checks at hello time
+    shm_policy->name_count = 0;
+    for (int i = 0; process_blacklist[i] != NULL; i++) {
+        add_policy_name(process_blacklist[i]);
+    }
+    int ignore_count = ignore_list_count();
+    for (int i = 0; i < ignore_count; i++) {
+        const char* name = ignore_list_get(i);
+        if (name) {
+            add_policy_name(name);
+        }
+    }
+    prune_policy_pids();
+
+    capture_policy_end_write(shm_policy);
+    pthread_mutex_unlock(&policy_mutex);
+}
+
+void ipc_set_policy_tier(pid_t pid, CaptureTier tier) {
+    pthread_mutex_lock(&policy_mutex);
+    if (!shm_policy) {
+        pthread_mutex_unlock(&policy_mutex);
+        return;
+    }
+
+    capture_policy_begin_write(shm_policy);
+
+    if (pid == 0) {
+        // Every layer was told, so per-process tiers no longer apply
+        shm_policy->default_tier = tier;
+        shm_policy->pid_count = 0;
+    } else {
+        uint32_t i = 0;
+        while (i < shm_policy->pid_count && shm_policy->pids[i].pid != pid) {
+            i++;
+        }
+        if (i == shm_policy->pid_count) {
+            if (i == CAPTURE_POLICY_MAX_PIDS) {
+                prune_policy_pids();
+                i = shm_policy->pid_count;
+            }
+            if (i < CAPTURE_POLICY_MAX_PIDS) {
+                shm_policy->pids[i].pid = pid;
+                shm_policy->pid_count++;
+            }
+        }
+        if (i < shm_policy->pid_count) {
+            shm_policy->pids[i].capture_tier = tier;
+        }
+    }
+
+    capture_policy_end_write(shm_policy);
+    pthread_mutex_unlock(&policy_mutex);
+}
@@ -21,12 +21,14 @@ typedef struct {
     uint32_t swapchain_format;
     bool has_swapchain;
     bool present_timing_supported;  // VK_EXT_present_timing available
+    uint8_t graphics_api;           // GraphicsApi from the hello
 } LayerClient;
 
 // App subscription info
 typedef struct {
     int fd;
     pid_t subscribed_pid;  // PID of the layer to receive frames from (0 = none)
+    uint32_t capabilities; // CAPFRAMEX_CAP_* flags announced in MSG_START_CAPTURE
 } AppSubscription;
 
 // Callback for received messages
@@ -56,7 +58,8 @@ int ipc_broadcast_to_non_layers(MessageType type, void* payload, uint32_t payloa
 // Send a message to a specific client
 int ipc_send(int client_fd, MessageType type, void* payload, uint32_t payload_size);
 
-// Update shared memory with active game PIDs
+// Set the detected game PIDs of the shared PID list (published together
+// with the PIDs of connected layers, see SharedPidList)
 int ipc_update_active_pids(pid_t* pids, uint32_t count);
 
 // Get the socket path
@@ -84,17 +87,34 @@ int ipc_get_layers_copy(LayerClient* buffer, int max_count);
 bool ipc_get_layer_by_pid_copy(pid_t pid, LayerClient* out);
 
 // App subscription management
-void ipc_subscribe_app(int client_fd, pid_t target_pid);
+// history_ms > 0 replays that much of the layer's recent frames first
+// (MSG_FRAME_HISTORY, see StartCapturePayload)
+void ipc_subscribe_app(int client_fd, pid_t target_pid, uint32_t capabilities, uint32_t history_ms);
 void ipc_unsubscribe_app(int client_fd);
 void ipc_unregister_app(int client_fd);
 
 // Forward frame data to subscribed apps
 void ipc_forward_frame_data(const FrameDataPoint* frame);
 
+// Forward a batch of frames from one layer to subscribed apps
+// (as MSG_FRAMETIME_BATCH to apps that support it, per frame otherwise)
+void ipc_forward_frame_batch(const FrameDataPoint* frames, uint32_t count);
+
+// Forward a layer's present overhead stats to apps subscribed to its PID
+void ipc_forward_layer_overhead(const LayerOverheadPayload* stats);
+
 // Get client type
 ClientType ipc_get_client_type(int fd);
 
 // Check if a process name is blacklisted (should not appear in game list)
 bool ipc_is_blacklisted_process(const char* process_name);
 
+// Rewrite the shared capture policy's ignored names (process blacklist and
+// ignore list), e.g. after the ignore list changed
+void ipc_publish_capture_policy(void);
+
+// Record a tier change in the shared capture policy so layers loaded later
+// start at it (pid 0 = new default, clears per-process tiers)
+void ipc_set_policy_tier(pid_t pid, CaptureTier tier);
+
 #endif // CAPFRAMEX_IPC_H
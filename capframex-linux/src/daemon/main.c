@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +14,8 @@
 #include "launcher_detect.h"
 #include "ipc.h"
 #include "ignore_list.h"
+#include "display_timing.h"
+#include "drm_events.h"
 
 static volatile bool running = true;
 
@@ -139,6 +142,21 @@ static void process_event_handler(ProcessInfo* info, bool is_new) {
     }
 }
 
+// Send a message to the layer of `pid` (0 = every layer), returns how many got it
+static int send_to_layers(pid_t pid, MessageType type, void* payload, uint32_t payload_size) {
+    LayerClient layers_copy[64];  // MAX_LAYERS from ipc.c
+    int layer_count = ipc_get_layers_copy(layers_copy, 64);
+    int sent_count = 0;
+    for (int i = 0; i < layer_count; i++) {
+        if (pid == 0 || layers_copy[i].pid == pid) {
+            if (ipc_send(layers_copy[i].fd, type, payload, payload_size) == 0) {
+                sent_count++;
+            }
+        }
+    }
+    return sent_count;
+}
+
 static void ipc_message_handler(MessageHeader* header, void* payload, int client_fd) {
     switch (header->type) {
         case MSG_STATUS_REQUEST: {
@@ -180,6 +198,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                     layer_payload.resolution_height = layers_copy[i].swapchain_height;
                 }
                 layer_payload.present_timing_supported = layers_copy[i].present_timing_supported ? 1 : 0;
+                layer_payload.graphics_api = layers_copy[i].graphics_api;
                 // Get launcher chain
                 launcher_get_chain(layers_copy[i].pid, layer_payload.launcher, sizeof(layer_payload.launcher));
 
@@ -198,8 +217,13 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
         case MSG_START_CAPTURE: {
             // App wants to subscribe to frame stream from a specific PID
             if (payload && header->payload_size >= sizeof(pid_t)) {
-                pid_t target_pid = *(pid_t*)payload;
-                LOG_INFO(">>> Client %d subscribing to frame stream from PID %d <<<", client_fd, target_pid);
+                // Older apps send only the PID, newer ones append capabilities
+                StartCapturePayload request = {0};
+                memcpy(&request, payload, header->payload_size < sizeof(request) ?
+                       header->payload_size : sizeof(request));
+                pid_t target_pid = request.pid;
+                LOG_INFO(">>> Client %d subscribing to frame stream from PID %d (history %u ms) <<<",
+                         client_fd, target_pid, request.history_ms);
 
                 // Check if there's a matching layer
                 LayerClient* layer = ipc_get_layer_by_pid(target_pid);
@@ -217,7 +241,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                     }
                 }
 
-                ipc_subscribe_app(client_fd, target_pid);
+                ipc_subscribe_app(client_fd, target_pid, request.capabilities, request.history_ms);
             }
             break;
         }
@@ -229,6 +253,40 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
             break;
         }
 
+        case MSG_CONFIG_UPDATE: {
+            // App changes the capture tier of one layer (or all of them)
+            if (payload && header->payload_size >= sizeof(CaptureConfigPayload) &&
+                ipc_get_client_type(client_fd) != CLIENT_TYPE_LAYER) {
+                CaptureConfigPayload config;
+                memcpy(&config, payload, sizeof(config));
+                if (config.capture_tier > CAPTURE_TIER_FULL) {
+                    LOG_WARN("Client %d sent unknown capture tier %u", client_fd, config.capture_tier);
+                    break;
+                }
+
+                // Layers loaded later (new processes, recreated instances) start at it
+                ipc_set_policy_tier(config.pid, (CaptureTier)config.capture_tier);
+
+                int sent_count = send_to_layers(config.pid, MSG_CONFIG_UPDATE, &config, sizeof(config));
+                LOG_INFO("Capture tier %u sent to %d layer(s) (PID %d)",
+                         config.capture_tier, sent_count, config.pid);
+            }
+            break;
+        }
+
+        case MSG_FRAME_LIMIT: {
+            // App sets the frame cap of one layer (or all of them)
+            if (payload && header->payload_size >= sizeof(FrameLimitPayload) &&
+                ipc_get_client_type(client_fd) != CLIENT_TYPE_LAYER) {
+                FrameLimitPayload limit;
+                memcpy(&limit, payload, sizeof(limit));
+                int sent_count = send_to_layers(limit.pid, MSG_FRAME_LIMIT, &limit, sizeof(limit));
+                LOG_INFO("Frame limit %.2f FPS sent to %d layer(s) (PID %d)",
+                         limit.fps_limit, sent_count, limit.pid);
+            }
+            break;
+        }
+
         case MSG_LAYER_HELLO: {
             // Layer announced itself
             if (payload) {
@@ -248,6 +306,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                     strncpy(game_payload.gpu_name, hello->gpu_name,
                             sizeof(game_payload.gpu_name) - 1);
                     game_payload.present_timing_supported = hello->present_timing_supported;
+                    game_payload.graphics_api = hello->graphics_api;
 
                     // Get launcher chain
                     launcher_get_chain(hello->pid, game_payload.launcher, sizeof(game_payload.launcher));
@@ -279,6 +338,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                     update.resolution_width = info->width;
                     update.resolution_height = info->height;
                     update.present_timing_supported = layer_copy.present_timing_supported ? 1 : 0;
+                    update.graphics_api = layer_copy.graphics_api;
 
                     launcher_get_chain(info->pid, update.launcher, sizeof(update.launcher));
 
@@ -311,6 +371,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                     update.resolution_width = 0;
                     update.resolution_height = 0;
                     update.present_timing_supported = layer_copy.present_timing_supported ? 1 : 0;
+                    update.graphics_api = layer_copy.graphics_api;
                     launcher_get_chain(info->pid, update.launcher, sizeof(update.launcher));
 
                     ipc_broadcast_to_non_layers(MSG_GAME_UPDATED, &update, sizeof(update));
@@ -319,6 +380,35 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
             break;
         }
 
+        case MSG_DISPLAY_TIMING: {
+            // App asks for the vblank cadence of the displays. The first
+            // request starts tracking, which lasts until the app disconnects.
+            display_timing_hold(client_fd);
+            DisplayTimingPayload timing = {0};
+            timing.crtc_count = display_timing_get_stats(timing.crtcs, DISPLAY_TIMING_MAX_CRTCS);
+            ipc_send(client_fd, MSG_DISPLAY_TIMING, &timing, sizeof(timing));
+            break;
+        }
+
+        case MSG_DISPLAY_VBLANKS: {
+            // App asks which vblank each of its presents reached
+            size_t header_size = offsetof(DisplayVblankRequest, present_ns);
+            if (payload && header->payload_size >= header_size) {
+                DisplayVblankRequest request = {0};
+                memcpy(&request, payload, header->payload_size < sizeof(request) ?
+                       header->payload_size : sizeof(request));
+                // Only the timestamps the payload actually carries
+                uint32_t carried = (header->payload_size - header_size) / sizeof(uint64_t);
+                if (request.count > carried) request.count = carried;
+
+                display_timing_hold(client_fd);
+                DisplayVblankReply reply;
+                uint32_t size = display_timing_match_vblanks(&request, &reply);
+                ipc_send(client_fd, MSG_DISPLAY_VBLANKS, &reply, size);
+            }
+            break;
+        }
+
         case MSG_IGNORE_LIST_ADD: {
             // Add process to ignore list
             if (payload && header->payload_size >= sizeof(IgnoreListEntry)) {
@@ -326,6 +416,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                 if (ignore_list_add(entry->process_name) == 0) {
                     LOG_INFO("Added to ignore list: %s (requested by client %d)",
                              entry->process_name, client_fd);
+                    ipc_publish_capture_policy();
                     // Broadcast update to all app clients
                     ipc_broadcast_to_non_layers(MSG_IGNORE_LIST_UPDATED, NULL, 0);
                 }
@@ -340,6 +431,7 @@ static void ipc_message_handler(MessageHeader* header, void* payload, int client
                 if (ignore_list_remove(entry->process_name) == 0) {
                     LOG_INFO("Removed from ignore list: %s (requested by client %d)",
                              entry->process_name, client_fd);
+                    ipc_publish_capture_policy();
                     // Broadcast update to all app clients
                     ipc_broadcast_to_non_layers(MSG_IGNORE_LIST_UPDATED, NULL, 0);
                 }
@@ -500,10 +592,19 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // Track display vblanks (optional, needs access to a DRM card node)
+    if (strcmp(cfg->display_timing_device, "off") != 0) {
+        DisplayTimingSource* source = drm_events_open(cfg->display_timing_device);
+        if (source) {
+            display_timing_start(source);
+        }
+    }
+
     // Start IPC server
     if (ipc_start(ipc_message_handler) != 0) {
         LOG_ERROR("Failed to start IPC server");
         ipc_cleanup();
+        display_timing_stop();
         process_monitor_cleanup();
         return 1;
     }
@@ -512,6 +613,7 @@ int main(int argc, char* argv[]) {
     if (process_monitor_start(process_event_handler) != 0) {
         LOG_ERROR("Failed to start process monitor");
         ipc_cleanup();
+        display_timing_stop();
         process_monitor_cleanup();
         return 1;
     }
@@ -533,6 +635,7 @@ int main(int argc, char* argv[]) {
     LOG_INFO("Shutting down...");
     process_monitor_cleanup();
     ipc_cleanup();
+    display_timing_stop();
     ignore_list_cleanup();
 
     LOG_INFO("Daemon stopped");
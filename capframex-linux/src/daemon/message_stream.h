@@ -0,0 +1,107 @@
+#ifndef CAPFRAMEX_MESSAGE_STREAM_H
+#define CAPFRAMEX_MESSAGE_STREAM_H
+
+#include "common.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Incremental decoder for the MessageHeader + payload stream on the IPC
+// socket, used by the daemon (one per client) and the layer. A read may end
+// anywhere: it can hold several messages, and its last message may continue
+// in the next read. Complete messages are dispatched straight from the read
+// buffer; only the bytes of a message cut by the end of a read are copied,
+// into a buffer allocated the first time that happens.
+
+#define MESSAGE_STREAM_READ_SIZE (64 * 1024)     // Bytes per recv()
+#define MESSAGE_STREAM_MAX_MESSAGE (64 * 1024)   // Header plus payload
+
+typedef struct {
+    char* partial;       // MESSAGE_STREAM_MAX_MESSAGE bytes once needed
+    size_t partial_len;  // Bytes of the cut message received so far
+} MessageStream;
+
+// Called once per complete message: len bytes starting with the header.
+// Valid until the handler returns.
+typedef void (*MessageStreamHandler)(void* context, char* message, size_t len);
+
+static inline void message_stream_init(MessageStream* stream) {
+    stream->partial = NULL;
+    stream->partial_len = 0;
+}
+
+static inline void message_stream_free(MessageStream* stream) {
+    free(stream->partial);
+    message_stream_init(stream);
+}
+
+// Forget a cut message, e.g. after reconnecting
+static inline void message_stream_reset(MessageStream* stream) {
+    stream->partial_len = 0;
+}
+
+static inline size_t message_stream_length(const MessageHeader* header) {
+    return sizeof(MessageHeader) + header->payload_size;
+}
+
+// Dispatch every message completed by len more bytes. Returns false if the
+// stream is corrupt (a message longer than MESSAGE_STREAM_MAX_MESSAGE) or
+// the partial buffer could not be allocated; the connection should be
+// dropped then since the message boundaries are lost.
+static inline bool message_stream_feed(MessageStream* stream, char* data, size_t len,
+                                       MessageStreamHandler handler, void* context) {
+    size_t offset = 0;
+
+    // Finish the message the previous read cut off
+    if (stream->partial_len > 0) {
+        size_t needed = sizeof(MessageHeader);
+        if (stream->partial_len >= sizeof(MessageHeader)) {
+            needed = message_stream_length((const MessageHeader*)stream->partial);
+        }
+        for (;;) {
+            size_t take = needed - stream->partial_len;
+            if (take > len - offset) take = len - offset;
+            memcpy(stream->partial + stream->partial_len, data + offset, take);
+            stream->partial_len += take;
+            offset += take;
+
+            if (stream->partial_len < needed) {
+                return true;  // Still incomplete, wait for more
+            }
+            if (needed == sizeof(MessageHeader)) {
+                // Header complete, now the payload
+                needed = message_stream_length((const MessageHeader*)stream->partial);
+                if (needed > MESSAGE_STREAM_MAX_MESSAGE) return false;
+                if (needed > stream->partial_len) continue;
+            }
+            break;
+        }
+
+        stream->partial_len = 0;
+        handler(context, stream->partial, needed);
+    }
+
+    // Whole messages straight from the read buffer
+    while (len - offset >= sizeof(MessageHeader)) {
+        MessageHeader header;
+        memcpy(&header, data + offset, sizeof(header));
+        size_t msg_len = message_stream_length(&header);
+        if (msg_len > MESSAGE_STREAM_MAX_MESSAGE) return false;
+        if (msg_len > len - offset) break;
+
+        handler(context, data + offset, msg_len);
+        offset += msg_len;
+    }
+
+    // Keep the start of a message that continues in the next read
+    if (offset < len) {
+        if (!stream->partial) {
+            stream->partial = malloc(MESSAGE_STREAM_MAX_MESSAGE);
+            if (!stream->partial) return false;
+        }
+        memcpy(stream->partial, data + offset, len - offset);
+        stream->partial_len = len - offset;
+    }
+    return true;
+}
+
+#endif // CAPFRAMEX_MESSAGE_STREAM_H
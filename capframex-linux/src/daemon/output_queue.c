@@ -0,0 +1,284 @@
+#include "output_queue.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Metadata of one queued message, collected while making room
+typedef struct {
+    size_t offset;   // From the queue head
+    size_t size;     // Header plus payload
+    uint32_t type;
+    int32_t pid;     // First payload field of state messages
+    uint32_t frames; // Frames carried (0 = not a frame message)
+    bool keep;
+} QueuedMessage;
+
+void output_queue_init(OutputQueue* queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+void output_queue_free(OutputQueue* queue) {
+    free(queue->data);
+    queue->data = NULL;
+    queue->head = 0;
+    queue->used = 0;
+    queue->partial = 0;
+}
+
+// Copy len bytes starting offset bytes after the head
+static void ring_read(const OutputQueue* queue, size_t offset, void* dst, size_t len) {
+    size_t pos = (queue->head + offset) % OUTPUT_QUEUE_SIZE;
+    size_t first = OUTPUT_QUEUE_SIZE - pos < len ? OUTPUT_QUEUE_SIZE - pos : len;
+    memcpy(dst, queue->data + pos, first);
+    memcpy((char*)dst + first, queue->data, len - first);
+}
+
+static void ring_append(OutputQueue* queue, const void* src, size_t len) {
+    if (len == 0) return;
+    size_t pos = (queue->head + queue->used) % OUTPUT_QUEUE_SIZE;
+    size_t first = OUTPUT_QUEUE_SIZE - pos < len ? OUTPUT_QUEUE_SIZE - pos : len;
+    memcpy(queue->data + pos, src, first);
+    memcpy(queue->data, (const char*)src + first, len - first);
+    queue->used += len;
+}
+
+static void consume(OutputQueue* queue, size_t len) {
+    queue->head = (queue->head + len) % OUTPUT_QUEUE_SIZE;
+    queue->used -= len;
+}
+
+// Account for n bytes the socket took, tracking where a message was cut
+static void advance(OutputQueue* queue, size_t n) {
+    if (queue->partial > 0) {
+        size_t done = n < queue->partial ? n : queue->partial;
+        consume(queue, done);
+        queue->partial -= done;
+        n -= done;
+    }
+
+    while (n > 0) {
+        MessageHeader header;
+        ring_read(queue, 0, &header, sizeof(header));
+        size_t size = sizeof(header) + header.payload_size;
+        if (n >= size) {
+            consume(queue, size);
+            n -= size;
+        } else {
+            consume(queue, n);
+            queue->partial = size - n;
+            n = 0;
+        }
+    }
+}
+
+static void describe_message(const OutputQueue* queue, size_t offset, QueuedMessage* msg) {
+    MessageHeader header;
+    ring_read(queue, offset, &header, sizeof(header));
+
+    msg->offset = offset;
+    msg->size = sizeof(header) + header.payload_size;
+    msg->type = header.type;
+    msg->pid = 0;
+    msg->frames = 0;
+    msg->keep = true;
+
+    switch (header.type) {
+    case MSG_FRAMETIME_DATA:
+        msg->frames = 1;
+        break;
+    case MSG_FRAMETIME_BATCH:
+    case MSG_FRAME_HISTORY:
+        // The empty batch ending a replay is not a frame message
+        if (header.payload_size >= sizeof(FrameBatchHeader)) {
+            FrameBatchHeader batch;
+            ring_read(queue, offset + sizeof(header), &batch, sizeof(batch));
+            msg->frames = batch.count;
+        }
+        break;
+    case MSG_GAME_UPDATED:
+    case MSG_LAYER_OVERHEAD_STATS:
+        if (header.payload_size >= sizeof(int32_t)) {
+            ring_read(queue, offset + sizeof(header), &msg->pid, sizeof(msg->pid));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static bool is_state_message(const QueuedMessage* msg) {
+    return msg->type == MSG_GAME_UPDATED || msg->type == MSG_LAYER_OVERHEAD_STATS;
+}
+
+// Free at least needed bytes by coalescing state messages and dropping the
+// oldest frames. Frees a quarter of the queue beyond that when it has to drop
+// frames, so a stalled client is not compacted again for every message.
+static bool make_room(OutputQueue* queue, size_t needed) {
+    size_t count = 0;
+    for (size_t offset = queue->partial; offset < queue->used; count++) {
+        MessageHeader header;
+        ring_read(queue, offset, &header, sizeof(header));
+        offset += sizeof(header) + header.payload_size;
+    }
+
+    QueuedMessage* msgs = malloc((count ? count : 1) * sizeof(QueuedMessage));
+    char* compacted = malloc(OUTPUT_QUEUE_SIZE);
+    if (!msgs || !compacted) {
+        free(msgs);
+        free(compacted);
+        return false;
+    }
+
+    size_t offset = queue->partial;
+    for (size_t i = 0; i < count; i++) {
+        describe_message(queue, offset, &msgs[i]);
+        offset += msgs[i].size;
+    }
+
+    size_t free_bytes = OUTPUT_QUEUE_SIZE - queue->used;
+    uint64_t coalesced = 0, dropped = 0, dropped_frames = 0;
+
+    // Only the newest state message per type and PID matters
+    for (size_t i = count; i-- > 0;) {
+        if (!is_state_message(&msgs[i])) continue;
+        for (size_t j = i + 1; j < count; j++) {
+            if (msgs[j].keep && msgs[j].type == msgs[i].type && msgs[j].pid == msgs[i].pid) {
+                msgs[i].keep = false;
+                free_bytes += msgs[i].size;
+                coalesced++;
+                break;
+            }
+        }
+    }
+
+    size_t goal = needed + OUTPUT_QUEUE_SIZE / 4;
+    if (goal > OUTPUT_QUEUE_SIZE) goal = OUTPUT_QUEUE_SIZE;
+    for (size_t i = 0; i < count && free_bytes < goal; i++) {
+        if (msgs[i].keep && msgs[i].frames > 0) {
+            msgs[i].keep = false;
+            free_bytes += msgs[i].size;
+            dropped++;
+            dropped_frames += msgs[i].frames;
+        }
+    }
+
+    if (coalesced + dropped > 0) {
+        // Rebuild linearly: the cut message first, then everything kept
+        size_t used = 0;
+        ring_read(queue, 0, compacted, queue->partial);
+        used += queue->partial;
+        for (size_t i = 0; i < count; i++) {
+            if (msgs[i].keep) {
+                ring_read(queue, msgs[i].offset, compacted + used, msgs[i].size);
+                used += msgs[i].size;
+            }
+        }
+
+        free(queue->data);
+        queue->data = compacted;
+        compacted = NULL;
+        queue->head = 0;
+        queue->used = used;
+        queue->coalesced_messages += coalesced;
+        queue->dropped_messages += dropped;
+        queue->dropped_frames += dropped_frames;
+    }
+
+    free(compacted);
+    free(msgs);
+    return OUTPUT_QUEUE_SIZE - queue->used >= needed;
+}
+
+OutputResult output_queue_flush(OutputQueue* queue, int fd) {
+    while (queue->used > 0) {
+        size_t first = OUTPUT_QUEUE_SIZE - queue->head;
+        if (first > queue->used) first = queue->used;
+
+        struct iovec iov[2] = {
+            { .iov_base = queue->data + queue->head, .iov_len = first },
+            { .iov_base = queue->data, .iov_len = queue->used - first },
+        };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = iov[1].iov_len ? 2 : 1 };
+
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return OUTPUT_QUEUED;
+            return OUTPUT_ERROR;
+        }
+        advance(queue, (size_t)sent);
+    }
+
+    // Drained - give the memory back until the next backlog
+    output_queue_free(queue);
+    return OUTPUT_SENT;
+}
+
+OutputResult output_queue_send(OutputQueue* queue, int fd, const MessageHeader* header,
+                               const void* payload) {
+    size_t payload_size = payload ? header->payload_size : 0;
+    size_t total = sizeof(*header) + payload_size;
+    size_t sent = 0;
+
+    if (output_queue_empty(queue)) {
+        struct iovec iov[2] = {
+            { .iov_base = (void*)header, .iov_len = sizeof(*header) },
+            { .iov_base = (void*)payload, .iov_len = payload_size },
+        };
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = payload_size ? 2 : 1 };
+
+        ssize_t n;
+        do {
+            n = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return OUTPUT_ERROR;
+            n = 0;
+        }
+        if ((size_t)n == total) return OUTPUT_SENT;
+        sent = (size_t)n;
+    }
+
+    size_t remaining = total - sent;
+    if (remaining > OUTPUT_QUEUE_SIZE) {
+        // Only possible for a message larger than the whole queue
+        return sent > 0 ? OUTPUT_ERROR : OUTPUT_OVERFLOW;
+    }
+    if (!queue->data) {
+        queue->data = malloc(OUTPUT_QUEUE_SIZE);
+        if (!queue->data) return OUTPUT_OVERFLOW;
+    }
+
+    // A message cut by the socket has to be completed, whatever its size
+    if (sent == 0 && OUTPUT_QUEUE_SIZE - queue->used < remaining && !make_room(queue, remaining)) {
+        queue->dropped_messages++;
+        if (header->type == MSG_FRAMETIME_DATA) {
+            queue->dropped_frames++;
+        } else if ((header->type == MSG_FRAMETIME_BATCH || header->type == MSG_FRAME_HISTORY) &&
+                   payload_size >= sizeof(FrameBatchHeader)) {
+            FrameBatchHeader batch;
+            memcpy(&batch, payload, sizeof(batch));
+            queue->dropped_frames += batch.count;
+        }
+        if (output_queue_empty(queue)) {
+            output_queue_free(queue);
+        }
+        return OUTPUT_OVERFLOW;
+    }
+
+    if (sent < sizeof(*header)) {
+        ring_append(queue, (const char*)header + sent, sizeof(*header) - sent);
+        ring_append(queue, payload, payload_size);
+    } else {
+        ring_append(queue, (const char*)payload + (sent - sizeof(*header)), remaining);
+    }
+    if (sent > 0) {
+        queue->partial = remaining;
+    }
+
+    return output_queue_flush(queue, fd);
+}
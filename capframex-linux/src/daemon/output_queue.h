@@ -0,0 +1,60 @@
+#ifndef CAPFRAMEX_OUTPUT_QUEUE_H
+#define CAPFRAMEX_OUTPUT_QUEUE_H
+
+#include "common.h"
+#include <stddef.h>
+
+// Bounded per-client output queue for the daemon's non-blocking sockets.
+//
+// Messages go straight to the socket while it keeps up; whatever it does not
+// take is queued in a ring buffer (allocated only while there is a backlog)
+// and flushed with gather writes when the socket becomes writable again. A
+// slow consumer therefore never blocks the IPC thread, and with it frame
+// ingestion from every game.
+//
+// When a message does not fit, room is made in two steps: state messages
+// that a newer queued message of the same kind and PID supersedes
+// (MSG_GAME_UPDATED, MSG_LAYER_OVERHEAD_STATS) are coalesced away, then the
+// oldest frame messages are dropped. Everything else is never dropped; if it
+// still does not fit the client is not reading at all.
+//
+// Not thread safe - callers serialize access per queue.
+
+// Large enough for a full retroactive replay (~16k frames) plus slack
+#define OUTPUT_QUEUE_SIZE (2 * 1024 * 1024)
+
+typedef struct {
+    char* data;       // OUTPUT_QUEUE_SIZE bytes while anything is queued
+    size_t head;      // Ring offset of the first unsent byte
+    size_t used;      // Unsent bytes
+    size_t partial;   // Unsent bytes of the first message, already partly written
+
+    // Totals since the client connected
+    uint64_t dropped_frames;
+    uint64_t dropped_messages;
+    uint64_t coalesced_messages;
+} OutputQueue;
+
+typedef enum {
+    OUTPUT_SENT = 0,      // Everything written, nothing queued
+    OUTPUT_QUEUED = 1,    // Backlog left - flush when the socket is writable
+    OUTPUT_OVERFLOW = 2,  // Message dropped, no room even after dropping frames
+    OUTPUT_ERROR = 3,     // Socket error, the client is gone
+} OutputResult;
+
+void output_queue_init(OutputQueue* queue);
+void output_queue_free(OutputQueue* queue);
+
+static inline bool output_queue_empty(const OutputQueue* queue) {
+    return queue->used == 0;
+}
+
+// Send one message (payload may be NULL if header->payload_size is 0),
+// behind anything already queued
+OutputResult output_queue_send(OutputQueue* queue, int fd, const MessageHeader* header,
+                               const void* payload);
+
+// Write as much of the backlog as the socket takes
+OutputResult output_queue_flush(OutputQueue* queue, int fd);
+
+#endif // CAPFRAMEX_OUTPUT_QUEUE_H
@@ -0,0 +1,56 @@
+#ifndef CAPFRAMEX_PID_LIST_H
+#define CAPFRAMEX_PID_LIST_H
+
+#include "common.h"
+
+// Seqlock access to the shared PID list (SharedPidList in common.h). The
+// daemon is the only writer; readers copy the list and retry if the version
+// was odd or changed while they copied. __atomic builtins since the list
+// lives in memory shared between processes (see frame_ring.h).
+
+// Writer: replace the whole list
+static inline void pid_list_write(SharedPidList* list, const SharedPidEntry* entries, uint32_t count) {
+    if (count > MAX_TRACKED_PROCESSES) count = MAX_TRACKED_PROCESSES;
+
+    uint32_t version = __atomic_load_n(&list->version, __ATOMIC_RELAXED);
+    __atomic_store_n(&list->version, version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (uint32_t i = 0; i < count; i++) {
+        __atomic_store_n(&list->pids[i].pid, entries[i].pid, __ATOMIC_RELAXED);
+        __atomic_store_n(&list->pids[i].flags, entries[i].flags, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&list->count, count, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&list->version, version + 2, __ATOMIC_RELEASE);
+}
+
+// Copy up to max entries. Returns the number copied, or -1 if no consistent
+// snapshot was seen within a bounded number of attempts. *out_version (if
+// set) is the even version the snapshot belongs to.
+static inline int pid_list_read(const SharedPidList* list, SharedPidEntry* out, int max,
+                                uint32_t* out_version) {
+    for (int attempt = 0; attempt < 64; attempt++) {
+        uint32_t version = __atomic_load_n(&list->version, __ATOMIC_ACQUIRE);
+        if (version & 1) {
+            continue;
+        }
+
+        uint32_t count = __atomic_load_n(&list->count, __ATOMIC_RELAXED);
+        if (count > MAX_TRACKED_PROCESSES) count = MAX_TRACKED_PROCESSES;
+        int n = (int)count < max ? (int)count : max;
+        for (int i = 0; i < n; i++) {
+            out[i].pid = __atomic_load_n(&list->pids[i].pid, __ATOMIC_RELAXED);
+            out[i].flags = __atomic_load_n(&list->pids[i].flags, __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&list->version, __ATOMIC_RELAXED) == version) {
+            if (out_version) *out_version = version;
+            return n;
+        }
+    }
+    return -1;
+}
+
+#endif // CAPFRAMEX_PID_LIST_H
@@ -0,0 +1,577 @@
+// OpenGL capture for GLX and EGL applications, loaded with
+// LD_PRELOAD=libcapframex_gl.so.
+//
+// glXSwapBuffers, eglSwapBuffers and eglSwapBuffersWithDamage{KHR,EXT} are
+// interposed and timed the way the Vulkan layer times vkQueuePresentKHR: the
+// same timing contexts, frame limiter and IPC client, with the hello tagged
+// GRAPHICS_API_OPENGL_GLX or _EGL. Each drawable/surface gets its own frame
+// stream, like a swapchain.
+//
+// Applications reach the swap functions three ways, all of which end up here:
+//   - linked directly: the exported hooks below precede libGL/libEGL
+//   - glXGetProcAddress/eglGetProcAddress: those are interposed as well
+//   - dlopen + dlsym (SDL, most engines): dlsym itself is interposed
+// The real functions are whatever the application's own lookup returned, or
+// the next definition after this library. dlsym only intercepts the hooked
+// names with an explicit handle or RTLD_DEFAULT; everything else, and every
+// RTLD_NEXT lookup, tail-jumps into glibc's dlsym so lookup scope, dlerror
+// and IFUNCs are glibc's own and RTLD_NEXT stays relative to the caller.
+//
+// No GL, GLX, EGL or X11 headers or libraries are needed: the few types
+// involved are declared below.
+
+#define _GNU_SOURCE
+#include "timing.h"
+#include "ipc_client.h"
+#include "capture_tier.h"
+#include "frame_limiter.h"
+#include "overhead.h"
+#include "handle_map.h"
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GL_EXPORT __attribute__((visibility("default")))
+
+typedef void (*GlProc)(void);
+typedef unsigned long GlxDrawable;  // XID
+typedef unsigned int EglBoolean;
+typedef int32_t EglInt;
+
+#define GL_RENDERER_ENUM 0x1F01
+#define GLX_WIDTH_ENUM   0x801D
+#define GLX_HEIGHT_ENUM  0x801E
+#define EGL_HEIGHT_ENUM  0x3056
+#define EGL_WIDTH_ENUM   0x3057
+
+typedef void (*PFN_glXSwapBuffers)(void* dpy, GlxDrawable drawable);
+typedef GlProc (*PFN_glXGetProcAddress)(const unsigned char* name);
+typedef void (*PFN_glXQueryDrawable)(void* dpy, GlxDrawable drawable, int attribute, unsigned int* value);
+typedef EglBoolean (*PFN_eglSwapBuffers)(void* dpy, void* surface);
+typedef EglBoolean (*PFN_eglSwapBuffersWithDamage)(void* dpy, void* surface, const EglInt* rects, EglInt n_rects);
+typedef EglBoolean (*PFN_eglDestroySurface)(void* dpy, void* surface);
+typedef GlProc (*PFN_eglGetProcAddress)(const char* name);
+typedef EglBoolean (*PFN_eglQuerySurface)(void* dpy, void* surface, EglInt attribute, EglInt* value);
+typedef const unsigned char* (*PFN_glGetString)(unsigned int name);
+
+// Surface size is re-read at most this often (glXQueryDrawable is a server
+// round-trip)
+#define SIZE_CHECK_INTERVAL_NS 1000000000ULL
+
+// ============================================================================
+// Interposed functions
+// ============================================================================
+
+typedef enum {
+    HOOK_GLX_GET_PROC_ADDRESS,
+    HOOK_GLX_GET_PROC_ADDRESS_ARB,
+    HOOK_GLX_SWAP_BUFFERS,
+    HOOK_EGL_GET_PROC_ADDRESS,
+    HOOK_EGL_SWAP_BUFFERS,
+    HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_KHR,
+    HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_EXT,
+    HOOK_EGL_DESTROY_SURFACE,
+    HOOK_COUNT
+} HookId;
+
+GL_EXPORT GlProc glXGetProcAddress(const unsigned char* name);
+GL_EXPORT GlProc glXGetProcAddressARB(const unsigned char* name);
+GL_EXPORT void glXSwapBuffers(void* dpy, GlxDrawable drawable);
+GL_EXPORT GlProc eglGetProcAddress(const char* name);
+GL_EXPORT EglBoolean eglSwapBuffers(void* dpy, void* surface);
+GL_EXPORT EglBoolean eglSwapBuffersWithDamageKHR(void* dpy, void* surface, const EglInt* rects, EglInt n_rects);
+GL_EXPORT EglBoolean eglSwapBuffersWithDamageEXT(void* dpy, void* surface, const EglInt* rects, EglInt n_rects);
+GL_EXPORT EglBoolean eglDestroySurface(void* dpy, void* surface);
+
+typedef struct {
+    const char* name;
+    void* hook;
+    _Atomic(void*) real;  // Set by the first lookup that finds it
+} Hook;
+
+static Hook hooks[HOOK_COUNT] = {
+    [HOOK_GLX_GET_PROC_ADDRESS]             = { "glXGetProcAddress", (void*)glXGetProcAddress, NULL },
+    [HOOK_GLX_GET_PROC_ADDRESS_ARB]         = { "glXGetProcAddressARB", (void*)glXGetProcAddressARB, NULL },
+    [HOOK_GLX_SWAP_BUFFERS]                 = { "glXSwapBuffers", (void*)glXSwapBuffers, NULL },
+    [HOOK_EGL_GET_PROC_ADDRESS]             = { "eglGetProcAddress", (void*)eglGetProcAddress, NULL },
+    [HOOK_EGL_SWAP_BUFFERS]                 = { "eglSwapBuffers", (void*)eglSwapBuffers, NULL },
+    [HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_KHR] = { "eglSwapBuffersWithDamageKHR", (void*)eglSwapBuffersWithDamageKHR, NULL },
+    [HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_EXT] = { "eglSwapBuffersWithDamageEXT", (void*)eglSwapBuffersWithDamageEXT, NULL },
+    [HOOK_EGL_DESTROY_SURFACE]              = { "eglDestroySurface", (void*)eglDestroySurface, NULL },
+};
+
+typedef void* (*PFN_dlsym)(void* handle, const char* name);
+
+static _Atomic(void*) real_dlsym_ptr = NULL;
+
+// glibc's dlsym. Looked up by version since dlsym(RTLD_NEXT, "dlsym") would
+// find this library's; dlsym moved from libdl to libc in glibc 2.34.
+static PFN_dlsym get_real_dlsym(void) {
+    PFN_dlsym real = (PFN_dlsym)atomic_load_explicit(&real_dlsym_ptr, memory_order_acquire);
+    if (!real) {
+        static const char* const versions[] = { "GLIBC_2.34", "GLIBC_2.2.5", "GLIBC_2.17", "GLIBC_2.0" };
+        for (size_t i = 0; i < sizeof(versions) / sizeof(versions[0]) && !real; i++) {
+            real = (PFN_dlsym)dlvsym(RTLD_NEXT, "dlsym", versions[i]);
+        }
+        if (!real) {
+            fprintf(stderr, "[CapFrameX GL] Cannot find the real dlsym\n");
+            return NULL;
+        }
+        atomic_store_explicit(&real_dlsym_ptr, (void*)real, memory_order_release);
+    }
+    return real;
+}
+
+static void* call_real_dlsym(void* handle, const char* name) {
+    PFN_dlsym real = get_real_dlsym();
+    return real ? real(handle, name) : NULL;
+}
+
+static int find_hook(const char* name) {
+    // Nearly every lookup is a GL function: rule those out on the prefix
+    if (!name || !((name[0] == 'g' && name[1] == 'l' && name[2] == 'X') ||
+                   (name[0] == 'e' && name[1] == 'g' && name[2] == 'l'))) {
+        return -1;
+    }
+    for (int i = 0; i < HOOK_COUNT; i++) {
+        if (strcmp(name, hooks[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Remember what an application lookup returned for a hooked name
+static void note_real(int id, void* real) {
+    if (real && real != hooks[id].hook) {
+        void* expected = NULL;
+        atomic_compare_exchange_strong(&hooks[id].real, &expected, real);
+    }
+}
+
+static void* get_real(HookId id) {
+    void* real = atomic_load_explicit(&hooks[id].real, memory_order_acquire);
+    if (!real) {
+        // Called through the exported symbol: the next definition is the real one
+        note_real(id, call_real_dlsym(RTLD_NEXT, hooks[id].name));
+        real = atomic_load_explicit(&hooks[id].real, memory_order_acquire);
+    }
+    return real;
+}
+
+// Non-hooked GL/GLX/EGL entry points used for the hello and surface sizes
+static void* lookup_gl_function(GraphicsApi api, const char* name) {
+    void* fn = call_real_dlsym(RTLD_DEFAULT, name);
+    if (fn) return fn;
+
+    // Libraries dlopen'ed RTLD_LOCAL only answer through GetProcAddress
+    if (api == GRAPHICS_API_OPENGL_EGL) {
+        PFN_eglGetProcAddress gpa = (PFN_eglGetProcAddress)get_real(HOOK_EGL_GET_PROC_ADDRESS);
+        return gpa ? (void*)gpa(name) : NULL;
+    }
+    PFN_glXGetProcAddress gpa = (PFN_glXGetProcAddress)get_real(HOOK_GLX_GET_PROC_ADDRESS_ARB);
+    if (!gpa) gpa = (PFN_glXGetProcAddress)get_real(HOOK_GLX_GET_PROC_ADDRESS);
+    return gpa ? (void*)gpa((const unsigned char*)name) : NULL;
+}
+
+// ============================================================================
+// Capture state
+// ============================================================================
+
+// Frame stream of one GLX drawable or EGL surface
+typedef struct {
+    uint32_t id;  // Reported as FrameTimingData.swapchain_id
+    TimingContext* timing;
+    FrameLimiter limiter;
+    uint64_t frame_count;
+    uint32_t width;
+    uint32_t height;
+    uint64_t size_checked_ns;
+    uint32_t capture_generation;
+} GlSurface;
+
+// GLX drawables are XIDs, EGL surfaces pointers: separate maps so they
+// can't collide. GLX drawables are plain X windows whose destruction GLX
+// never sees, so their state lives until exit.
+static HandleMap glx_surfaces = HANDLE_MAP_INITIALIZER;
+static HandleMap egl_surfaces = HANDLE_MAP_INITIALIZER;
+static _Atomic uint32_t next_surface_id = 1;
+
+// Set up on the first swap, whose API the hello reports
+static atomic_bool initialized = false;
+static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Daemon connection the hello and surface info were last sent on
+// (ipc_client_connection_generation), 0 = none yet
+static _Atomic uint32_t announced_connection = 0;
+
+static pthread_mutex_t gpu_name_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char gpu_name[256];
+
+static void gl_capture_init(GraphicsApi api) {
+    if (layer_initial_capture_tier() == CAPTURE_TIER_OFF) {
+        // Passthrough only - no sender thread, no socket, no reconnects
+        return;
+    }
+
+    ipc_client_set_graphics_api(api);
+    ipc_client_init();
+    frame_limiter_init();
+
+    fprintf(stderr, "[CapFrameX GL] Initialized for PID %d (%s, capture tier: %s)\n",
+            getpid(), api == GRAPHICS_API_OPENGL_EGL ? "EGL" : "GLX",
+            capture_tier_name(layer_initial_capture_tier()));
+}
+
+static void ensure_initialized(GraphicsApi api) {
+    if (atomic_load_explicit(&initialized, memory_order_acquire)) {
+        return;
+    }
+    pthread_mutex_lock(&init_mutex);
+    if (!atomic_load_explicit(&initialized, memory_order_relaxed)) {
+        gl_capture_init(api);
+        atomic_store_explicit(&initialized, true, memory_order_release);
+    }
+    pthread_mutex_unlock(&init_mutex);
+}
+
+// GL_RENDERER of the context being swapped, read once
+static const char* get_gpu_name(GraphicsApi api) {
+    pthread_mutex_lock(&gpu_name_mutex);
+    if (gpu_name[0] == '\0') {
+        PFN_glGetString get_string = (PFN_glGetString)lookup_gl_function(api, "glGetString");
+        const unsigned char* renderer = get_string ? get_string(GL_RENDERER_ENUM) : NULL;
+        snprintf(gpu_name, sizeof(gpu_name), "%s", renderer ? (const char*)renderer : "OpenGL");
+        ipc_client_set_gpu_name(gpu_name);
+    }
+    pthread_mutex_unlock(&gpu_name_mutex);
+    return gpu_name;
+}
+
+static void query_size(GraphicsApi api, void* display, uint64_t drawable,
+                       uint32_t* width, uint32_t* height) {
+    *width = 0;
+    *height = 0;
+
+    if (api == GRAPHICS_API_OPENGL_EGL) {
+        PFN_eglQuerySurface query = (PFN_eglQuerySurface)lookup_gl_function(api, "eglQuerySurface");
+        EglInt w = 0, h = 0;
+        if (query && query(display, (void*)(uintptr_t)drawable, EGL_WIDTH_ENUM, &w) &&
+            query(display, (void*)(uintptr_t)drawable, EGL_HEIGHT_ENUM, &h) && w > 0 && h > 0) {
+            *width = (uint32_t)w;
+            *height = (uint32_t)h;
+        }
+    } else {
+        PFN_glXQueryDrawable query = (PFN_glXQueryDrawable)lookup_gl_function(api, "glXQueryDrawable");
+        if (query) {
+            unsigned int w = 0, h = 0;
+            query(display, (GlxDrawable)drawable, GLX_WIDTH_ENUM, &w);
+            query(display, (GlxDrawable)drawable, GLX_HEIGHT_ENUM, &h);
+            *width = w;
+            *height = h;
+        }
+    }
+}
+
+static GlSurface* get_surface(GraphicsApi api, uint64_t key) {
+    HandleMap* map = api == GRAPHICS_API_OPENGL_EGL ? &egl_surfaces : &glx_surfaces;
+    GlSurface* surface = handle_map_get(map, key);
+    if (surface) {
+        return surface;
+    }
+
+    surface = calloc(1, sizeof(GlSurface));
+    if (!surface) {
+        return NULL;
+    }
+    surface->id = atomic_fetch_add(&next_surface_id, 1);
+    surface->timing = timing_context_create(surface->id);
+    surface->capture_generation = layer_capture_generation();
+    if (!surface->timing || !handle_map_put(map, key, surface)) {
+        fprintf(stderr, "[CapFrameX GL] Out of memory tracking surface\n");
+        timing_context_destroy(surface->timing);
+        free(surface);
+        return NULL;
+    }
+    return surface;
+}
+
+// Timestamps of a swap in progress
+typedef struct {
+    GlSurface* surface;
+    uint64_t enter_ns;
+    uint64_t pre_swap_ns;
+    uint64_t limiter_wait_ns;
+    uint64_t limiter_error_ns;
+    bool limited;
+} SwapRecord;
+
+// Everything before the real swap. False if this swap isn't captured.
+static bool swap_begin(GraphicsApi api, void* display, uint64_t drawable, SwapRecord* rec) {
+    ensure_initialized(api);
+
+    if (drawable == 0 || layer_capture_tier() == CAPTURE_TIER_OFF) {
+        return false;
+    }
+    uint32_t generation = layer_capture_generation();
+
+    // Everything outside the driver call counts as overhead
+    rec->enter_ns = timing_get_timestamp();
+
+    GlSurface* surface = get_surface(api, drawable);
+    if (!surface) {
+        return false;
+    }
+    rec->surface = surface;
+
+    if (rec->enter_ns - surface->size_checked_ns >= SIZE_CHECK_INTERVAL_NS) {
+        uint32_t width, height;
+        query_size(api, display, drawable, &width, &height);
+        if (width != surface->width || height != surface->height) {
+            surface->width = width;
+            surface->height = height;
+            atomic_store(&announced_connection, 0);  // Announce the new size
+        }
+        surface->size_checked_ns = rec->enter_ns;
+    }
+
+    // Announce this process once per connection (the IPC thread connects
+    // in the background) and again after a resize
+    uint32_t connection = ipc_client_connection_generation();
+    if (connection != 0 && connection != atomic_load_explicit(&announced_connection, memory_order_relaxed) &&
+        ipc_client_is_connected()) {
+        ipc_client_send_hello(get_gpu_name(api), false);
+        if (surface->width > 0 && surface->height > 0) {
+            ipc_client_send_swapchain_created(surface->width, surface->height, 0, 0);
+        }
+        atomic_store_explicit(&announced_connection, connection, memory_order_relaxed);
+    }
+
+    // The capture tier changed since this surface's last swap. Swaps in
+    // between may have gone unrecorded, so the gap isn't reported as a frametime.
+    if (surface->capture_generation != generation) {
+        timing_reset_baseline(surface->timing);
+        surface->capture_generation = generation;
+    }
+
+    rec->limiter_wait_ns = 0;
+    rec->limiter_error_ns = 0;
+    rec->limited = frame_limiter_wait(&surface->limiter, &rec->limiter_wait_ns, &rec->limiter_error_ns);
+
+    rec->pre_swap_ns = timing_get_timestamp();
+    return true;
+}
+
+// Everything after the real swap
+static void swap_end(SwapRecord* rec) {
+    uint64_t post_swap_ns = timing_get_timestamp();
+    GlSurface* surface = rec->surface;
+
+    surface->frame_count++;
+
+    PresentTimestamps times;
+    memset(&times, 0, sizeof(times));
+    times.frame_number = surface->frame_count;
+    times.pre_present_ns = rec->pre_swap_ns;
+    times.post_present_ns = post_swap_ns;
+    if (rec->limited) {
+        times.limiter_wait_ns = rec->limiter_wait_ns;
+        times.limiter_error_ms = (float)rec->limiter_error_ns / 1000000.0f;
+    }
+    timing_record_frame(surface->timing, &times);
+
+    overhead_record((rec->pre_swap_ns - rec->enter_ns - rec->limiter_wait_ns) +
+                    (timing_get_timestamp() - post_swap_ns));
+}
+
+// ============================================================================
+// Hooks
+// ============================================================================
+
+GL_EXPORT void glXSwapBuffers(void* dpy, GlxDrawable drawable) {
+    PFN_glXSwapBuffers real = (PFN_glXSwapBuffers)get_real(HOOK_GLX_SWAP_BUFFERS);
+
+    SwapRecord rec;
+    bool capture = swap_begin(GRAPHICS_API_OPENGL_GLX, dpy, drawable, &rec);
+    if (real) {
+        real(dpy, drawable);
+    }
+    if (capture) {
+        swap_end(&rec);
+    }
+}
+
+GL_EXPORT EglBoolean eglSwapBuffers(void* dpy, void* surface) {
+    PFN_eglSwapBuffers real = (PFN_eglSwapBuffers)get_real(HOOK_EGL_SWAP_BUFFERS);
+
+    SwapRecord rec;
+    bool capture = swap_begin(GRAPHICS_API_OPENGL_EGL, dpy, (uint64_t)(uintptr_t)surface, &rec);
+    EglBoolean result = real ? real(dpy, surface) : 0;
+    if (capture) {
+        swap_end(&rec);
+    }
+    return result;
+}
+
+static EglBoolean swap_with_damage(HookId id, void* dpy, void* surface,
+                                   const EglInt* rects, EglInt n_rects) {
+    PFN_eglSwapBuffersWithDamage real = (PFN_eglSwapBuffersWithDamage)get_real(id);
+
+    SwapRecord rec;
+    bool capture = swap_begin(GRAPHICS_API_OPENGL_EGL, dpy, (uint64_t)(uintptr_t)surface, &rec);
+    EglBoolean result = real ? real(dpy, surface, rects, n_rects) : 0;
+    if (capture) {
+        swap_end(&rec);
+    }
+    return result;
+}
+
+GL_EXPORT EglBoolean eglSwapBuffersWithDamageKHR(void* dpy, void* surface,
+                                                 const EglInt* rects, EglInt n_rects) {
+    return swap_with_damage(HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_KHR, dpy, surface, rects, n_rects);
+}
+
+GL_EXPORT EglBoolean eglSwapBuffersWithDamageEXT(void* dpy, void* surface,
+                                                 const EglInt* rects, EglInt n_rects) {
+    return swap_with_damage(HOOK_EGL_SWAP_BUFFERS_WITH_DAMAGE_EXT, dpy, surface, rects, n_rects);
+}
+
+GL_EXPORT EglBoolean eglDestroySurface(void* dpy, void* surface) {
+    PFN_eglDestroySurface real = (PFN_eglDestroySurface)get_real(HOOK_EGL_DESTROY_SURFACE);
+
+    // EGL requires the surface to be idle, so no swap can still be using it
+    GlSurface* state = handle_map_remove(&egl_surfaces, (uint64_t)(uintptr_t)surface);
+    if (state) {
+        timing_context_destroy(state->timing);
+        free(state);
+    }
+    return real ? real(dpy, surface) : 0;
+}
+
+static GlProc glx_get_proc_address(HookId self, const unsigned char* name) {
+    PFN_glXGetProcAddress real = (PFN_glXGetProcAddress)get_real(self);
+    GlProc proc = real ? real(name) : NULL;
+
+    int id = find_hook((const char*)name);
+    if (id < 0 || !proc) {
+        return proc;
+    }
+    note_real(id, (void*)proc);
+    return (GlProc)hooks[id].hook;
+}
+
+GL_EXPORT GlProc glXGetProcAddress(const unsigned char* name) {
+    return glx_get_proc_address(HOOK_GLX_GET_PROC_ADDRESS, name);
+}
+
+GL_EXPORT GlProc glXGetProcAddressARB(const unsigned char* name) {
+    return glx_get_proc_address(HOOK_GLX_GET_PROC_ADDRESS_ARB, name);
+}
+
+GL_EXPORT GlProc eglGetProcAddress(const char* name) {
+    PFN_eglGetProcAddress real = (PFN_eglGetProcAddress)get_real(HOOK_EGL_GET_PROC_ADDRESS);
+    GlProc proc = real ? real(name) : NULL;
+
+    int id = find_hook(name);
+    if (id < 0 || !proc) {
+        return proc;
+    }
+    note_real(id, (void*)proc);
+    return (GlProc)hooks[id].hook;
+}
+
+// What the exported dlsym does with a lookup: return result, or jump to
+// forward with the original arguments
+typedef struct {
+    void* result;
+    void* forward;
+} DlsymRoute;
+
+DlsymRoute capframex_dlsym_route(void* handle, const char* name);
+
+// Lookups of hooked names get the hook; everything else goes to glibc.
+// RTLD_NEXT is forwarded even for hooked names: glibc answers it for the
+// caller, so an interposer loaded before this library gets the hook and one
+// loaded after gets the next definition down.
+DlsymRoute capframex_dlsym_route(void* handle, const char* name) {
+    DlsymRoute route = { NULL, NULL };
+    PFN_dlsym real = get_real_dlsym();
+    if (!real) {
+        return route;
+    }
+
+    int id = handle == RTLD_NEXT ? -1 : find_hook(name);
+    if (id < 0) {
+        route.forward = (void*)real;
+        return route;
+    }
+
+    void* sym = real(handle, name);
+    if (sym) {
+        note_real(id, sym);
+        route.result = hooks[id].hook;
+    }
+    return route;
+}
+
+// The exported dlsym. glibc resolves RTLD_NEXT (and RTLD_DEFAULT's local
+// scope) from the return address, so forwarded lookups must reach it with
+// the caller's: a tail jump, which only assembly can guarantee (GCC has no
+// musttail). DlsymRoute comes back in rax:rdx / x0:x1.
+#if defined(__x86_64__)
+__asm__(
+    ".text\n"
+    ".globl dlsym\n"
+    ".type dlsym, @function\n"
+    "dlsym:\n"
+#if defined(__CET__)
+    "    endbr64\n"
+#endif
+    "    push %rdi\n"
+    "    push %rsi\n"
+    "    sub $8, %rsp\n"  // 16-byte stack alignment for the call
+    "    call capframex_dlsym_route\n"
+    "    add $8, %rsp\n"
+    "    pop %rsi\n"
+    "    pop %rdi\n"
+    "    test %rdx, %rdx\n"
+    "    jz 1f\n"
+    "    jmp *%rdx\n"
+    "1:  ret\n"
+    ".size dlsym, .-dlsym\n"
+);
+#elif defined(__aarch64__)
+__asm__(
+    ".text\n"
+    ".globl dlsym\n"
+    ".type dlsym, %function\n"
+    ".p2align 2\n"
+    "dlsym:\n"
+#if defined(__ARM_FEATURE_BTI_DEFAULT)
+    "    hint 34\n"  // bti c
+#endif
+    "    stp x29, x30, [sp, #-32]!\n"
+    "    mov x29, sp\n"
+    "    stp x0, x1, [sp, #16]\n"
+    "    bl capframex_dlsym_route\n"
+    "    cbz x1, 1f\n"
+    "    mov x16, x1\n"
+    "    ldp x0, x1, [sp, #16]\n"
+    "    ldp x29, x30, [sp], #32\n"
+    "    br x16\n"
+    "1:  ldp x29, x30, [sp], #32\n"
+    "    ret\n"
+    ".size dlsym, .-dlsym\n"
+);
+#else
+// No tail jump: RTLD_NEXT lookups by other objects search after this library
+GL_EXPORT void* dlsym(void* handle, const char* name) {
+    DlsymRoute route = capframex_dlsym_route(handle, name);
+    return route.forward ? ((PFN_dlsym)route.forward)(handle, name) : route.result;
+}
+#endif
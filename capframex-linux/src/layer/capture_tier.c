@@ -0,0 +1,114 @@
+#include "capture_tier.h"
+#include "ipc_client.h"
+#include "../daemon/capture_policy.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Tier from the environment (-1 = not read yet) and the tier in effect
+static int initial_tier = -1;
+static _Atomic uint32_t active_tier = CAPTURE_TIER_FULL;
+static _Atomic uint32_t tier_generation = 0;
+
+const char* capture_tier_name(CaptureTier tier) {
+    switch (tier) {
+    case CAPTURE_TIER_OFF:        return "off";
+    case CAPTURE_TIER_TIMESTAMPS: return "timestamps";
+    default:                      return "full";
+    }
+}
+
+// Consult the daemon's shared capture policy (capture_policy.h): a plain
+// shm read, no socket round trip, so it is cheap enough for instance creation
+static CapturePolicyDecision read_capture_policy(CaptureTier* out_tier, char* name, size_t name_size) {
+    name[0] = '\0';
+    FILE* f = fopen("/proc/self/comm", "r");
+    if (f) {
+        if (fgets(name, (int)name_size, f)) {
+            name[strcspn(name, "\n")] = '\0';
+        }
+        fclose(f);
+    }
+
+    int fd = shm_open(CAPFRAMEX_SHM_POLICY_NAME, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return CAPTURE_POLICY_UNAVAILABLE;
+    }
+
+    CapturePolicyDecision decision = CAPTURE_POLICY_UNAVAILABLE;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SharedCapturePolicy)) {
+        void* mapped = mmap(NULL, sizeof(SharedCapturePolicy), PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            decision = capture_policy_lookup(mapped, getpid(), name, out_tier);
+            munmap(mapped, sizeof(SharedCapturePolicy));
+        }
+    }
+    close(fd);
+    return decision;
+}
+
+CaptureTier layer_initial_capture_tier(void) {
+    if (initial_tier < 0) {
+        const char* env = getenv("CAPFRAMEX_CAPTURE_TIER");
+        CaptureTier tier = CAPTURE_TIER_FULL;
+        CaptureTier start_tier = CAPTURE_TIER_FULL;
+        if (env && env[0] != '\0') {
+            if (strcasecmp(env, "off") == 0 || strcmp(env, "0") == 0) {
+                tier = CAPTURE_TIER_OFF;
+            } else if (strcasecmp(env, "timestamps") == 0 || strcmp(env, "1") == 0) {
+                tier = CAPTURE_TIER_TIMESTAMPS;
+            } else if (strcasecmp(env, "full") != 0 && strcmp(env, "2") != 0) {
+                fprintf(stderr, "[CapFrameX Layer] Unknown CAPFRAMEX_CAPTURE_TIER '%s' - using full\n", env);
+            }
+            start_tier = tier;
+        } else {
+            // Without an explicit tier the daemon decides: blacklisted and
+            // ignored processes load as pure passthrough, everything else is
+            // set up for full capture and starts at the tier the app last chose
+            char name[CAPTURE_POLICY_NAME_LENGTH + 1];
+            switch (read_capture_policy(&start_tier, name, sizeof(name))) {
+            case CAPTURE_POLICY_IGNORED:
+                ipc_debug_log("'%s' is ignored by the daemon - passthrough", name);
+                tier = CAPTURE_TIER_OFF;
+                start_tier = CAPTURE_TIER_OFF;
+                break;
+            case CAPTURE_POLICY_CAPTURE:
+                break;
+            default:
+                start_tier = CAPTURE_TIER_FULL;
+                break;
+            }
+        }
+        atomic_store(&active_tier, start_tier);
+        initial_tier = tier;
+    }
+    return (CaptureTier)initial_tier;
+}
+
+CaptureTier layer_capture_tier(void) {
+    return (CaptureTier)atomic_load_explicit(&active_tier, memory_order_relaxed);
+}
+
+uint32_t layer_capture_generation(void) {
+    return atomic_load_explicit(&tier_generation, memory_order_acquire);
+}
+
+void layer_set_capture_tier(CaptureTier tier) {
+    if (layer_initial_capture_tier() == CAPTURE_TIER_OFF || tier > CAPTURE_TIER_FULL) {
+        return;
+    }
+    uint32_t previous = atomic_exchange(&active_tier, tier);
+    if (previous != (uint32_t)tier) {
+        atomic_fetch_add_explicit(&tier_generation, 1, memory_order_release);
+        fprintf(stderr, "[CapFrameX Layer] Capture tier: %s -> %s\n",
+                capture_tier_name((CaptureTier)previous), capture_tier_name(tier));
+    }
+}
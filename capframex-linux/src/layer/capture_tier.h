@@ -0,0 +1,29 @@
+#ifndef CAPFRAMEX_CAPTURE_TIER_H
+#define CAPFRAMEX_CAPTURE_TIER_H
+
+#include <stdint.h>
+
+#include "../daemon/common.h"
+
+// Capture tier of this process, shared by the Vulkan layer and the GL
+// capture library (no Vulkan types here).
+
+// Capture tier the layer was loaded with (CAPFRAMEX_CAPTURE_TIER=off|timestamps|full,
+// default full). Off hands the application the next layer's functions and never
+// talks to the daemon; timestamps and full set the device up for full capture so
+// the tier can be raised again at runtime (GPU queries only if loaded as full
+// with CAPFRAMEX_GPU_TIMING=1).
+CaptureTier layer_initial_capture_tier(void);
+
+// Tier in effect now. Cheap enough to check on every present/submit.
+CaptureTier layer_capture_tier(void);
+
+// Bumped on every runtime tier change, so per-swapchain state can restart
+uint32_t layer_capture_generation(void);
+
+// Change the tier at runtime (MSG_CONFIG_UPDATE); ignored if loaded as off
+void layer_set_capture_tier(CaptureTier tier);
+
+const char* capture_tier_name(CaptureTier tier);
+
+#endif // CAPFRAMEX_CAPTURE_TIER_H
@@ -0,0 +1,120 @@
+#include "frame_limiter.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+
+// Caps outside this range are ignored
+#define FRAME_LIMITER_MIN_FPS 1.0f
+#define FRAME_LIMITER_MAX_FPS 10000.0f
+
+// Spin at least this long before a deadline, at most FRAME_LIMITER_MAX_SPIN_NS
+#define FRAME_LIMITER_MIN_SPIN_NS 50000ULL
+#define FRAME_LIMITER_MAX_SPIN_NS 2000000ULL
+#define FRAME_LIMITER_INITIAL_OVERSHOOT_NS 100000ULL
+
+// Target frame interval, 0 = uncapped
+static _Atomic uint64_t target_interval_ns = 0;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void frame_limiter_init(void) {
+    const char* env = getenv("CAPFRAMEX_FPS_LIMIT");
+    if (env && env[0] != '\0') {
+        frame_limiter_set_fps(strtof(env, NULL));
+    }
+}
+
+void frame_limiter_set_fps(float fps) {
+    uint64_t interval = 0;
+    if (fps >= FRAME_LIMITER_MIN_FPS && fps <= FRAME_LIMITER_MAX_FPS) {
+        interval = (uint64_t)(1000000000.0 / fps + 0.5);
+    } else if (fps != 0.0f) {
+        fprintf(stderr, "[CapFrameX Layer] Ignoring frame limit %.2f FPS\n", fps);
+        return;
+    }
+
+    if (atomic_exchange(&target_interval_ns, interval) != interval) {
+        if (interval) {
+            fprintf(stderr, "[CapFrameX Layer] Frame limit: %.2f FPS\n", fps);
+        } else {
+            fprintf(stderr, "[CapFrameX Layer] Frame limit off\n");
+        }
+    }
+}
+
+float frame_limiter_get_fps(void) {
+    uint64_t interval = atomic_load_explicit(&target_interval_ns, memory_order_relaxed);
+    return interval ? (float)(1000000000.0 / (double)interval) : 0.0f;
+}
+
+// Sleep until `wake_ns` and fold the lateness into the overshoot estimate
+static uint64_t sleep_until(FrameLimiter* limiter, uint64_t wake_ns) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(wake_ns / 1000000000ULL),
+        .tv_nsec = (long)(wake_ns % 1000000000ULL)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+
+    uint64_t now = timing_get_timestamp();
+    uint64_t late = now > wake_ns ? now - wake_ns : 0;
+    limiter->sleep_overshoot_ns = limiter->sleep_overshoot_ns - limiter->sleep_overshoot_ns / 8 + late / 8;
+    return now;
+}
+
+bool frame_limiter_wait(FrameLimiter* limiter, uint64_t* wait_ns, uint64_t* error_ns) {
+    uint64_t interval = atomic_load_explicit(&target_interval_ns, memory_order_relaxed);
+    if (interval == 0) {
+        limiter->next_deadline_ns = 0;
+        return false;
+    }
+
+    uint64_t now = timing_get_timestamp();
+    *wait_ns = 0;
+    *error_ns = 0;
+
+    // First capped frame, new cap, or more than a frame behind: start the
+    // schedule here rather than letting a burst of frames through
+    if (limiter->next_deadline_ns == 0 || limiter->interval_ns != interval ||
+        now > limiter->next_deadline_ns + interval) {
+        if (limiter->sleep_overshoot_ns == 0) {
+            limiter->sleep_overshoot_ns = FRAME_LIMITER_INITIAL_OVERSHOOT_NS;
+        }
+        limiter->interval_ns = interval;
+        limiter->next_deadline_ns = now + interval;
+        return true;
+    }
+
+    uint64_t deadline = limiter->next_deadline_ns;
+    limiter->next_deadline_ns = deadline + interval;
+    if (now >= deadline) {
+        return true;
+    }
+
+    uint64_t start = now;
+    uint64_t spin = limiter->sleep_overshoot_ns * 2 + FRAME_LIMITER_MIN_SPIN_NS;
+    if (spin > FRAME_LIMITER_MAX_SPIN_NS) {
+        spin = FRAME_LIMITER_MAX_SPIN_NS;
+    }
+    if (deadline - now > spin) {
+        now = sleep_until(limiter, deadline - spin);
+    }
+    while (now < deadline) {
+        cpu_relax();
+        now = timing_get_timestamp();
+    }
+
+    *wait_ns = now - start;
+    *error_ns = now - deadline;
+    return true;
+}
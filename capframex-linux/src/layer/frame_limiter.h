@@ -0,0 +1,39 @@
+#ifndef CAPFRAMEX_FRAME_LIMITER_H
+#define CAPFRAMEX_FRAME_LIMITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Optional frame cap (CAPFRAMEX_FPS_LIMIT at load, MSG_FRAME_LIMIT from the
+// daemon at runtime).
+//
+// Each swapchain releases its presents on a fixed schedule one interval
+// apart: clock_nanosleep() until shortly before the deadline, then spin on
+// timing_get_timestamp() for the rest. The spin margin follows the observed
+// sleep overshoot, so the CPU only spins as long as the scheduler needs.
+// A frame that arrives late goes through immediately and the schedule keeps
+// its phase; one that is more than an interval late restarts it.
+
+// Pacing state of one swapchain, only touched by its presenting thread
+typedef struct {
+    uint64_t interval_ns;         // Interval the schedule was set up for
+    uint64_t next_deadline_ns;    // 0 = no schedule yet
+    uint64_t sleep_overshoot_ns;  // Running estimate of clock_nanosleep lateness
+} FrameLimiter;
+
+// Read CAPFRAMEX_FPS_LIMIT (frames per second, 0 or unset = uncapped)
+void frame_limiter_init(void);
+
+// Change the cap for every swapchain, 0 = uncapped
+void frame_limiter_set_fps(float fps);
+
+// Current cap, 0 if uncapped
+float frame_limiter_get_fps(void);
+
+// Hold the present until the swapchain's next deadline. Returns false if no
+// cap is set. wait_ns is how long the present was held, error_ns how far
+// past the deadline it was released (0 if the frame was already late - that's
+// the application, not the limiter).
+bool frame_limiter_wait(FrameLimiter* limiter, uint64_t* wait_ns, uint64_t* error_ns);
+
+#endif // CAPFRAMEX_FRAME_LIMITER_H
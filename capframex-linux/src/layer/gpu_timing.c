@@ -0,0 +1,610 @@
+#include "gpu_timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define GPU_TIMING_QUERIES_PER_QUEUE (GPU_TIMING_FRAMES * GPU_TIMING_MAX_SUBMITS * 2)
+#define GPU_TIMING_PAIRS_PER_QUEUE (GPU_TIMING_FRAMES * GPU_TIMING_MAX_SUBMITS)
+
+typedef enum {
+    GPU_FRAME_FREE = 0,
+    GPU_FRAME_OPEN,      // Collecting submits until the next present
+    GPU_FRAME_CLOSED,    // Presented, waiting for query results
+    GPU_FRAME_DONE,      // Result ready for its swapchain
+} GpuFrameState;
+
+typedef struct {
+    GpuFrameState state;
+    uint32_t swapchain_id;
+    uint64_t frame_number;
+    uint64_t closed_at_present;
+    float gpu_active_ms;
+    uint32_t used[GPU_TIMING_MAX_QUEUES];     // Timed submits per queue
+    uint32_t failed[GPU_TIMING_MAX_QUEUES];   // Bitmask of submits that didn't reach the GPU
+} GpuFrame;
+
+typedef struct {
+    VkQueue queue;
+    uint32_t family;
+    bool initialized;
+    bool usable;
+    uint64_t timestamp_mask;
+    VkCommandPool command_pool;
+    VkQueryPool query_pool;
+    // Pre-recorded per query pair: reset + begin timestamp, end timestamp
+    VkCommandBuffer begin_cbs[GPU_TIMING_PAIRS_PER_QUEUE];
+    VkCommandBuffer end_cbs[GPU_TIMING_PAIRS_PER_QUEUE];
+    // Signaled once the pair's submit has run: until then its queries may
+    // still hold the previous use's timestamps
+    VkFence fences[GPU_TIMING_PAIRS_PER_QUEUE];
+    bool fence_pending[GPU_TIMING_PAIRS_PER_QUEUE];
+} GpuQueueTimer;
+
+struct GpuTimingDevice {
+    DeviceData* dev_data;
+    PFN_vkSetDeviceLoaderData set_loader_data;
+    float timestamp_period;  // Nanoseconds per tick
+
+    PFN_vkCreateQueryPool CreateQueryPool;
+    PFN_vkDestroyQueryPool DestroyQueryPool;
+    PFN_vkGetQueryPoolResults GetQueryPoolResults;
+    PFN_vkCreateCommandPool CreateCommandPool;
+    PFN_vkDestroyCommandPool DestroyCommandPool;
+    PFN_vkAllocateCommandBuffers AllocateCommandBuffers;
+    PFN_vkBeginCommandBuffer BeginCommandBuffer;
+    PFN_vkEndCommandBuffer EndCommandBuffer;
+    PFN_vkCmdResetQueryPool CmdResetQueryPool;
+    PFN_vkCmdWriteTimestamp CmdWriteTimestamp;
+    PFN_vkCreateFence CreateFence;
+    PFN_vkDestroyFence DestroyFence;
+    PFN_vkGetFenceStatus GetFenceStatus;
+    PFN_vkResetFences ResetFences;
+
+    // Submits come from any thread; everything below is protected by mutex
+    pthread_mutex_t mutex;
+    GpuQueueTimer queues[GPU_TIMING_MAX_QUEUES];
+    uint32_t queue_count;
+    GpuFrame frames[GPU_TIMING_FRAMES];
+    int open_frame;  // -1 while every slot is in flight
+    uint64_t present_count;
+};
+
+bool gpu_timing_requested(void) {
+    const char* env = getenv("CAPFRAMEX_GPU_TIMING");
+    return env && strcmp(env, "1") == 0;
+}
+
+GpuTimingDevice* gpu_timing_create(DeviceData* dev_data, PFN_vkGetDeviceProcAddr fpGetDeviceProcAddr,
+                                   PFN_vkSetDeviceLoaderData set_loader_data) {
+    if (!set_loader_data) {
+        // Layer-owned command buffers need the loader's dispatch pointer
+        return NULL;
+    }
+
+    GpuTimingDevice* gpu = calloc(1, sizeof(GpuTimingDevice));
+    if (!gpu) {
+        return NULL;
+    }
+
+    gpu->dev_data = dev_data;
+    gpu->set_loader_data = set_loader_data;
+    pthread_mutex_init(&gpu->mutex, NULL);
+
+#define LOAD_GPU_PROC(name) \
+    gpu->name = (PFN_vk##name)fpGetDeviceProcAddr(dev_data->device, "vk" #name)
+
+    LOAD_GPU_PROC(CreateQueryPool);
+    LOAD_GPU_PROC(DestroyQueryPool);
+    LOAD_GPU_PROC(GetQueryPoolResults);
+    LOAD_GPU_PROC(CreateCommandPool);
+    LOAD_GPU_PROC(DestroyCommandPool);
+    LOAD_GPU_PROC(AllocateCommandBuffers);
+    LOAD_GPU_PROC(BeginCommandBuffer);
+    LOAD_GPU_PROC(EndCommandBuffer);
+    LOAD_GPU_PROC(CmdResetQueryPool);
+    LOAD_GPU_PROC(CmdWriteTimestamp);
+    LOAD_GPU_PROC(CreateFence);
+    LOAD_GPU_PROC(DestroyFence);
+    LOAD_GPU_PROC(GetFenceStatus);
+    LOAD_GPU_PROC(ResetFences);
+
+#undef LOAD_GPU_PROC
+
+    if (!gpu->CreateQueryPool || !gpu->DestroyQueryPool || !gpu->GetQueryPoolResults ||
+        !gpu->CreateCommandPool || !gpu->DestroyCommandPool || !gpu->AllocateCommandBuffers ||
+        !gpu->BeginCommandBuffer || !gpu->EndCommandBuffer ||
+        !gpu->CmdResetQueryPool || !gpu->CmdWriteTimestamp ||
+        !gpu->CreateFence || !gpu->DestroyFence || !gpu->GetFenceStatus || !gpu->ResetFences) {
+        pthread_mutex_destroy(&gpu->mutex);
+        free(gpu);
+        return NULL;
+    }
+
+    VkPhysicalDeviceProperties props;
+    dev_data->instance_data->dispatch.GetPhysicalDeviceProperties(dev_data->physical_device, &props);
+    gpu->timestamp_period = props.limits.timestampPeriod;
+
+    gpu->frames[0].state = GPU_FRAME_OPEN;
+    gpu->open_frame = 0;
+
+    fprintf(stderr, "[CapFrameX Layer] GPU timing enabled (timestamp period %.3f ns)\n",
+            gpu->timestamp_period);
+    return gpu;
+}
+
+static void destroy_queue_timer(GpuTimingDevice* gpu, GpuQueueTimer* timer) {
+    VkDevice device = gpu->dev_data->device;
+    for (uint32_t pair = 0; pair < GPU_TIMING_PAIRS_PER_QUEUE; pair++) {
+        if (timer->fences[pair]) {
+            gpu->DestroyFence(device, timer->fences[pair], NULL);
+            timer->fences[pair] = VK_NULL_HANDLE;
+        }
+    }
+    if (timer->command_pool) {
+        gpu->DestroyCommandPool(device, timer->command_pool, NULL);
+    }
+    if (timer->query_pool) {
+        gpu->DestroyQueryPool(device, timer->query_pool, NULL);
+    }
+    timer->command_pool = VK_NULL_HANDLE;
+    timer->query_pool = VK_NULL_HANDLE;
+    timer->usable = false;
+}
+
+void gpu_timing_destroy(GpuTimingDevice* gpu) {
+    if (!gpu) return;
+
+    for (uint32_t i = 0; i < gpu->queue_count; i++) {
+        destroy_queue_timer(gpu, &gpu->queues[i]);
+    }
+    pthread_mutex_destroy(&gpu->mutex);
+    free(gpu);
+}
+
+void gpu_timing_register_queue(GpuTimingDevice* gpu, VkQueue queue, uint32_t family) {
+    if (!gpu || !queue) return;
+
+    pthread_mutex_lock(&gpu->mutex);
+    bool known = false;
+    for (uint32_t i = 0; i < gpu->queue_count; i++) {
+        if (gpu->queues[i].queue == queue) {
+            known = true;
+            break;
+        }
+    }
+    if (!known && gpu->queue_count < GPU_TIMING_MAX_QUEUES) {
+        GpuQueueTimer* timer = &gpu->queues[gpu->queue_count++];
+        memset(timer, 0, sizeof(*timer));
+        timer->queue = queue;
+        timer->family = family;
+    }
+    pthread_mutex_unlock(&gpu->mutex);
+}
+
+// Record a one-off command buffer that stays valid for the queue's lifetime
+static bool record_command_buffer(GpuTimingDevice* gpu, GpuQueueTimer* timer, VkCommandBuffer cb,
+                                  uint32_t query, bool begin) {
+    if (gpu->set_loader_data(gpu->dev_data->device, cb) != VK_SUCCESS) {
+        return false;
+    }
+
+    // Resubmitted only after its fence showed the previous submit completed
+    VkCommandBufferBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+    };
+    if (gpu->BeginCommandBuffer(cb, &begin_info) != VK_SUCCESS) {
+        return false;
+    }
+    if (begin) {
+        gpu->CmdResetQueryPool(cb, timer->query_pool, query, 2);
+        gpu->CmdWriteTimestamp(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer->query_pool, query);
+    } else {
+        gpu->CmdWriteTimestamp(cb, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer->query_pool, query + 1);
+    }
+    return gpu->EndCommandBuffer(cb) == VK_SUCCESS;
+}
+
+// Create the query pool and command buffers of a queue on its first timed
+// submit (caller holds mutex)
+static void init_queue_timer(GpuTimingDevice* gpu, GpuQueueTimer* timer) {
+    timer->initialized = true;
+
+    DeviceData* dev_data = gpu->dev_data;
+    InstanceData* inst_data = dev_data->instance_data;
+    VkDevice device = dev_data->device;
+
+    uint32_t family_count = 0;
+    inst_data->dispatch.GetPhysicalDeviceQueueFamilyProperties(dev_data->physical_device, &family_count, NULL);
+    if (timer->family >= family_count) {
+        return;
+    }
+    VkQueueFamilyProperties* families = calloc(family_count, sizeof(VkQueueFamilyProperties));
+    if (!families) {
+        return;
+    }
+    inst_data->dispatch.GetPhysicalDeviceQueueFamilyProperties(dev_data->physical_device, &family_count, families);
+    uint32_t valid_bits = families[timer->family].timestampValidBits;
+    free(families);
+
+    if (valid_bits == 0) {
+        fprintf(stderr, "[CapFrameX Layer] Queue family %u has no timestamps - GPU timing skipped\n",
+                timer->family);
+        return;
+    }
+    timer->timestamp_mask = valid_bits >= 64 ? UINT64_MAX : (1ULL << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo query_info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = GPU_TIMING_QUERIES_PER_QUEUE
+    };
+    VkCommandPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .queueFamilyIndex = timer->family
+    };
+    if (gpu->CreateQueryPool(device, &query_info, NULL, &timer->query_pool) != VK_SUCCESS ||
+        gpu->CreateCommandPool(device, &pool_info, NULL, &timer->command_pool) != VK_SUCCESS) {
+        destroy_queue_timer(gpu, timer);
+        return;
+    }
+
+    VkCommandBufferAllocateInfo alloc_info = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = timer->command_pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = GPU_TIMING_PAIRS_PER_QUEUE
+    };
+    if (gpu->AllocateCommandBuffers(device, &alloc_info, timer->begin_cbs) != VK_SUCCESS ||
+        gpu->AllocateCommandBuffers(device, &alloc_info, timer->end_cbs) != VK_SUCCESS) {
+        destroy_queue_timer(gpu, timer);
+        return;
+    }
+
+    VkFenceCreateInfo fence_info = { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    for (uint32_t pair = 0; pair < GPU_TIMING_PAIRS_PER_QUEUE; pair++) {
+        if (!record_command_buffer(gpu, timer, timer->begin_cbs[pair], pair * 2, true) ||
+            !record_command_buffer(gpu, timer, timer->end_cbs[pair], pair * 2, false) ||
+            gpu->CreateFence(device, &fence_info, NULL, &timer->fences[pair]) != VK_SUCCESS) {
+            destroy_queue_timer(gpu, timer);
+            return;
+        }
+    }
+
+    timer->usable = true;
+}
+
+// A submit slot reserved in the open frame
+typedef struct {
+    int frame;
+    uint32_t queue_index;
+    uint32_t submit;
+    VkCommandBuffer begin_cb;
+    VkCommandBuffer end_cb;
+    VkFence fence;
+} TimedSubmit;
+
+static bool reserve_submit(GpuTimingDevice* gpu, VkQueue queue, TimedSubmit* out) {
+    bool reserved = false;
+    pthread_mutex_lock(&gpu->mutex);
+
+    int frame = gpu->open_frame;
+    for (uint32_t i = 0; frame >= 0 && i < gpu->queue_count; i++) {
+        GpuQueueTimer* timer = &gpu->queues[i];
+        if (timer->queue != queue) {
+            continue;
+        }
+        if (!timer->initialized) {
+            init_queue_timer(gpu, timer);
+        }
+
+        uint32_t submit = gpu->frames[frame].used[i];
+        if (!timer->usable || submit >= GPU_TIMING_MAX_SUBMITS) {
+            break;
+        }
+
+        // The pair's fence is reset once its previous submit has completed.
+        // One still running (its frame was dropped unresolved) can't be
+        // reused yet, so this submit goes untimed.
+        uint32_t pair = (uint32_t)frame * GPU_TIMING_MAX_SUBMITS + submit;
+        if (timer->fence_pending[pair]) {
+            VkDevice device = gpu->dev_data->device;
+            if (gpu->GetFenceStatus(device, timer->fences[pair]) != VK_SUCCESS ||
+                gpu->ResetFences(device, 1, &timer->fences[pair]) != VK_SUCCESS) {
+                break;
+            }
+            timer->fence_pending[pair] = false;
+        }
+
+        gpu->frames[frame].used[i]++;
+        timer->fence_pending[pair] = true;
+        out->frame = frame;
+        out->queue_index = i;
+        out->submit = submit;
+        out->begin_cb = timer->begin_cbs[pair];
+        out->end_cb = timer->end_cbs[pair];
+        out->fence = timer->fences[pair];
+        reserved = true;
+        break;
+    }
+
+    pthread_mutex_unlock(&gpu->mutex);
+    return reserved;
+}
+
+// The submit failed - its queries will never become available, or its
+// fence was never submitted
+static void cancel_submit(GpuTimingDevice* gpu, const TimedSubmit* timed) {
+    pthread_mutex_lock(&gpu->mutex);
+    gpu->frames[timed->frame].failed[timed->queue_index] |= 1u << timed->submit;
+    uint32_t pair = (uint32_t)timed->frame * GPU_TIMING_MAX_SUBMITS + timed->submit;
+    gpu->queues[timed->queue_index].fence_pending[pair] = false;
+    pthread_mutex_unlock(&gpu->mutex);
+}
+
+VkResult gpu_timing_queue_submit(DeviceData* dev_data, VkQueue queue, uint32_t submitCount,
+                                 const VkSubmitInfo* pSubmits, VkFence fence) {
+    GpuTimingDevice* gpu = dev_data->gpu_timing;
+    uint32_t last = submitCount - 1;
+
+    // Device groups pair command buffers with masks, protected submits need
+    // protected command buffers - leave those alone
+    bool timeable = gpu && submitCount > 0 && submitCount <= GPU_TIMING_MAX_BATCHES &&
+                    pSubmits[0].commandBufferCount < GPU_TIMING_MAX_COMMAND_BUFFERS - 1 &&
+                    pSubmits[last].commandBufferCount < GPU_TIMING_MAX_COMMAND_BUFFERS - 1;
+    for (uint32_t i = 0; timeable && i < submitCount; i++) {
+        if (layer_find_in_chain(pSubmits[i].pNext, VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO) ||
+            layer_find_in_chain(pSubmits[i].pNext, VK_STRUCTURE_TYPE_PROTECTED_SUBMIT_INFO)) {
+            timeable = false;
+        }
+    }
+
+    TimedSubmit timed;
+    if (!timeable || !reserve_submit(gpu, queue, &timed)) {
+        return dev_data->dispatch.QueueSubmit(queue, submitCount, pSubmits, fence);
+    }
+
+    VkSubmitInfo submits[GPU_TIMING_MAX_BATCHES];
+    VkCommandBuffer first_cbs[GPU_TIMING_MAX_COMMAND_BUFFERS];
+    VkCommandBuffer last_cbs[GPU_TIMING_MAX_COMMAND_BUFFERS];
+    memcpy(submits, pSubmits, submitCount * sizeof(VkSubmitInfo));
+
+    // Begin timestamp before the first batch's command buffers
+    first_cbs[0] = timed.begin_cb;
+    memcpy(&first_cbs[1], pSubmits[0].pCommandBuffers, pSubmits[0].commandBufferCount * sizeof(VkCommandBuffer));
+    submits[0].pCommandBuffers = first_cbs;
+    submits[0].commandBufferCount = pSubmits[0].commandBufferCount + 1;
+
+    // End timestamp after the last batch's command buffers
+    const VkCommandBuffer* last_src = submits[last].pCommandBuffers;
+    uint32_t last_count = submits[last].commandBufferCount;
+    memcpy(last_cbs, last_src, last_count * sizeof(VkCommandBuffer));
+    last_cbs[last_count] = timed.end_cb;
+    submits[last].pCommandBuffers = last_cbs;
+    submits[last].commandBufferCount = last_count + 1;
+
+    // Our fence rides along unless the app brought its own; then an empty
+    // submit signals it after everything queued before
+    VkResult result = dev_data->dispatch.QueueSubmit(queue, submitCount, submits, fence ? fence : timed.fence);
+    if (result != VK_SUCCESS ||
+        (fence && dev_data->dispatch.QueueSubmit(queue, 0, NULL, timed.fence) != VK_SUCCESS)) {
+        cancel_submit(gpu, &timed);
+    }
+    return result;
+}
+
+VkResult gpu_timing_queue_submit2(DeviceData* dev_data, VkQueue queue, uint32_t submitCount,
+                                  const VkSubmitInfo2* pSubmits, VkFence fence) {
+    GpuTimingDevice* gpu = dev_data->gpu_timing;
+    uint32_t last = submitCount - 1;
+
+    bool timeable = gpu && submitCount > 0 && submitCount <= GPU_TIMING_MAX_BATCHES &&
+                    pSubmits[0].commandBufferInfoCount < GPU_TIMING_MAX_COMMAND_BUFFERS - 1 &&
+                    pSubmits[last].commandBufferInfoCount < GPU_TIMING_MAX_COMMAND_BUFFERS - 1;
+    for (uint32_t i = 0; timeable && i < submitCount; i++) {
+        if (pSubmits[i].flags & VK_SUBMIT_PROTECTED_BIT) {
+            timeable = false;
+        }
+    }
+
+    TimedSubmit timed;
+    if (!timeable || !reserve_submit(gpu, queue, &timed)) {
+        return dev_data->dispatch.QueueSubmit2(queue, submitCount, pSubmits, fence);
+    }
+
+    VkSubmitInfo2 submits[GPU_TIMING_MAX_BATCHES];
+    VkCommandBufferSubmitInfo first_cbs[GPU_TIMING_MAX_COMMAND_BUFFERS];
+    VkCommandBufferSubmitInfo last_cbs[GPU_TIMING_MAX_COMMAND_BUFFERS];
+    memcpy(submits, pSubmits, submitCount * sizeof(VkSubmitInfo2));
+
+    first_cbs[0] = (VkCommandBufferSubmitInfo){
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = timed.begin_cb
+    };
+    memcpy(&first_cbs[1], pSubmits[0].pCommandBufferInfos,
+           pSubmits[0].commandBufferInfoCount * sizeof(VkCommandBufferSubmitInfo));
+    submits[0].pCommandBufferInfos = first_cbs;
+    submits[0].commandBufferInfoCount = pSubmits[0].commandBufferInfoCount + 1;
+
+    const VkCommandBufferSubmitInfo* last_src = submits[last].pCommandBufferInfos;
+    uint32_t last_count = submits[last].commandBufferInfoCount;
+    memcpy(last_cbs, last_src, last_count * sizeof(VkCommandBufferSubmitInfo));
+    last_cbs[last_count] = (VkCommandBufferSubmitInfo){
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = timed.end_cb
+    };
+    submits[last].pCommandBufferInfos = last_cbs;
+    submits[last].commandBufferInfoCount = last_count + 1;
+
+    // Our fence rides along unless the app brought its own; then an empty
+    // submit signals it after everything queued before
+    VkResult result = dev_data->dispatch.QueueSubmit2(queue, submitCount, submits, fence ? fence : timed.fence);
+    if (result != VK_SUCCESS ||
+        (fence && dev_data->dispatch.QueueSubmit2(queue, 0, NULL, timed.fence) != VK_SUCCESS)) {
+        cancel_submit(gpu, &timed);
+    }
+    return result;
+}
+
+// Open the next free frame slot for upcoming submits (caller holds mutex)
+static void open_next_frame(GpuTimingDevice* gpu, int after) {
+    gpu->open_frame = -1;
+    for (int i = 1; i <= GPU_TIMING_FRAMES; i++) {
+        int frame = (after + i) % GPU_TIMING_FRAMES;
+        if (gpu->frames[frame].state == GPU_FRAME_FREE) {
+            memset(&gpu->frames[frame], 0, sizeof(GpuFrame));
+            gpu->frames[frame].state = GPU_FRAME_OPEN;
+            gpu->open_frame = frame;
+            return;
+        }
+    }
+}
+
+bool gpu_timing_end_frame(GpuTimingDevice* gpu, uint32_t swapchain_id, uint64_t frame_number) {
+    if (!gpu) return false;
+
+    pthread_mutex_lock(&gpu->mutex);
+    gpu->present_count++;
+
+    int frame = gpu->open_frame;
+    if (frame < 0) {
+        // Every slot was in flight; time the next frame if one freed up
+        open_next_frame(gpu, 0);
+        pthread_mutex_unlock(&gpu->mutex);
+        return false;
+    }
+
+    GpuFrame* slot = &gpu->frames[frame];
+    bool any_submits = false;
+    for (uint32_t i = 0; i < gpu->queue_count; i++) {
+        if (slot->used[i] > 0) {
+            any_submits = true;
+        }
+    }
+    if (!any_submits) {
+        // Nothing was submitted this frame - keep collecting for the next
+        pthread_mutex_unlock(&gpu->mutex);
+        return false;
+    }
+
+    slot->state = GPU_FRAME_CLOSED;
+    slot->swapchain_id = swapchain_id;
+    slot->frame_number = frame_number;
+    slot->closed_at_present = gpu->present_count;
+    open_next_frame(gpu, frame);
+
+    pthread_mutex_unlock(&gpu->mutex);
+    return true;
+}
+
+typedef struct {
+    uint64_t begin;
+    uint64_t end;
+} GpuInterval;
+
+// Read a closed frame's queries. Returns false while results are pending.
+static bool resolve_frame(GpuTimingDevice* gpu, int frame) {
+    GpuFrame* slot = &gpu->frames[frame];
+    GpuInterval intervals[GPU_TIMING_MAX_QUEUES * GPU_TIMING_MAX_SUBMITS];
+    uint32_t interval_count = 0;
+
+    for (uint32_t q = 0; q < gpu->queue_count; q++) {
+        GpuQueueTimer* timer = &gpu->queues[q];
+        uint32_t used = slot->used[q];
+        if (used == 0 || !timer->usable) {
+            continue;
+        }
+
+        // Until a submit's fence signals, its queries may not even have been
+        // reset yet and still read as the previous use's timestamps
+        for (uint32_t s = 0; s < used; s++) {
+            uint32_t pair = (uint32_t)frame * GPU_TIMING_MAX_SUBMITS + s;
+            if (!(slot->failed[q] & (1u << s)) &&
+                gpu->GetFenceStatus(gpu->dev_data->device, timer->fences[pair]) != VK_SUCCESS) {
+                return false;
+            }
+        }
+
+        // value + availability per query
+        uint64_t results[GPU_TIMING_MAX_SUBMITS * 2][2];
+        uint32_t first_query = (uint32_t)frame * GPU_TIMING_MAX_SUBMITS * 2;
+        VkResult result = gpu->GetQueryPoolResults(gpu->dev_data->device, timer->query_pool,
+                                                   first_query, used * 2, sizeof(results), results,
+                                                   sizeof(results[0]),
+                                                   VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY) {
+            continue;
+        }
+
+        for (uint32_t s = 0; s < used; s++) {
+            if (slot->failed[q] & (1u << s)) {
+                continue;
+            }
+            if (!results[s * 2][1] || !results[s * 2 + 1][1]) {
+                return false;
+            }
+            uint64_t begin = results[s * 2][0] & timer->timestamp_mask;
+            uint64_t end = results[s * 2 + 1][0] & timer->timestamp_mask;
+            if (end > begin) {
+                intervals[interval_count].begin = begin;
+                intervals[interval_count].end = end;
+                interval_count++;
+            }
+        }
+    }
+
+    // Union of the intervals, so overlapping queues aren't counted twice
+    for (uint32_t i = 1; i < interval_count; i++) {
+        GpuInterval key = intervals[i];
+        uint32_t j = i;
+        while (j > 0 && intervals[j - 1].begin > key.begin) {
+            intervals[j] = intervals[j - 1];
+            j--;
+        }
+        intervals[j] = key;
+    }
+
+    uint64_t active_ticks = 0;
+    uint64_t covered_until = 0;
+    for (uint32_t i = 0; i < interval_count; i++) {
+        uint64_t begin = intervals[i].begin > covered_until ? intervals[i].begin : covered_until;
+        if (intervals[i].end > begin) {
+            active_ticks += intervals[i].end - begin;
+            covered_until = intervals[i].end;
+        }
+    }
+
+    slot->gpu_active_ms = (float)((double)active_ticks * gpu->timestamp_period / 1000000.0);
+    slot->state = GPU_FRAME_DONE;
+    return true;
+}
+
+uint32_t gpu_timing_collect(GpuTimingDevice* gpu, uint32_t swapchain_id,
+                            GpuFrameResult* out, uint32_t max_results) {
+    if (!gpu) return 0;
+
+    uint32_t count = 0;
+    pthread_mutex_lock(&gpu->mutex);
+
+    for (int frame = 0; frame < GPU_TIMING_FRAMES; frame++) {
+        GpuFrame* slot = &gpu->frames[frame];
+        if (slot->state == GPU_FRAME_CLOSED) {
+            resolve_frame(gpu, frame);
+        }
+
+        if (slot->state == GPU_FRAME_DONE && slot->swapchain_id == swapchain_id && count < max_results) {
+            out[count].frame_number = slot->frame_number;
+            out[count].gpu_active_ms = slot->gpu_active_ms;
+            count++;
+            slot->state = GPU_FRAME_FREE;
+        } else if ((slot->state == GPU_FRAME_CLOSED || slot->state == GPU_FRAME_DONE) &&
+                   gpu->present_count - slot->closed_at_present > GPU_TIMING_MAX_AGE) {
+            // Lost results, or a swapchain that stopped presenting
+            slot->state = GPU_FRAME_FREE;
+        }
+    }
+
+    pthread_mutex_unlock(&gpu->mutex);
+    return count;
+}
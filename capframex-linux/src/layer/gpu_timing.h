@@ -0,0 +1,68 @@
+#ifndef CAPFRAMEX_GPU_TIMING_H
+#define CAPFRAMEX_GPU_TIMING_H
+
+#include "layer.h"
+
+// GPU active time per frame. Opt-in with CAPFRAMEX_GPU_TIMING=1 on top of
+// capture tier full (see layer.h): without it the layer hooks no submits.
+//
+// Every vkQueueSubmit/vkQueueSubmit2 between two presents is bracketed with
+// timestamp writes: a layer-owned command buffer that resets a query pair and
+// writes a TOP_OF_PIPE timestamp is prepended to the first batch, one writing
+// a BOTTOM_OF_PIPE timestamp is appended to the last. Each queue has a query
+// pool with a fixed region per in-flight frame. Each timed submit also
+// signals a layer fence (through an extra empty submit if the app passes its
+// own); a frame's queries are read, without waiting, only once all its fences
+// have signaled, since the queries are reset on the GPU. A frame's GPU active
+// time is the union of its submission intervals over all queues.
+
+// Frames in flight per device
+#define GPU_TIMING_FRAMES 6
+
+// Timed vkQueueSubmit calls per queue and frame (later ones aren't counted)
+#define GPU_TIMING_MAX_SUBMITS 16
+
+// Queues timed per device
+#define GPU_TIMING_MAX_QUEUES 16
+
+// Submits with more batches or command buffers than this aren't timed
+#define GPU_TIMING_MAX_BATCHES 16
+#define GPU_TIMING_MAX_COMMAND_BUFFERS 64
+
+// Presents after which an unresolved frame is dropped
+#define GPU_TIMING_MAX_AGE 16
+
+// GPU active time of one presented frame
+typedef struct {
+    uint64_t frame_number;
+    float gpu_active_ms;
+} GpuFrameResult;
+
+// Whether GPU timing was asked for (CAPFRAMEX_GPU_TIMING=1)
+bool gpu_timing_requested(void);
+
+// Load the functions GPU timing needs, NULL if unavailable or out of memory
+GpuTimingDevice* gpu_timing_create(DeviceData* dev_data, PFN_vkGetDeviceProcAddr fpGetDeviceProcAddr,
+                                   PFN_vkSetDeviceLoaderData set_loader_data);
+
+// Destroy query and command pools. The device must be idle.
+void gpu_timing_destroy(GpuTimingDevice* gpu);
+
+// Remember which family a queue belongs to (from vkGetDeviceQueue*)
+void gpu_timing_register_queue(GpuTimingDevice* gpu, VkQueue queue, uint32_t family);
+
+// Submit with timestamps around the batches, or pass through untimed
+VkResult gpu_timing_queue_submit(DeviceData* dev_data, VkQueue queue, uint32_t submitCount,
+                                 const VkSubmitInfo* pSubmits, VkFence fence);
+VkResult gpu_timing_queue_submit2(DeviceData* dev_data, VkQueue queue, uint32_t submitCount,
+                                  const VkSubmitInfo2* pSubmits, VkFence fence);
+
+// Close the submissions since the previous present and tag them with the
+// presented frame. Returns false if the frame isn't timed.
+bool gpu_timing_end_frame(GpuTimingDevice* gpu, uint32_t swapchain_id, uint64_t frame_number);
+
+// Collect finished frames of one swapchain, returns how many were written
+uint32_t gpu_timing_collect(GpuTimingDevice* gpu, uint32_t swapchain_id,
+                            GpuFrameResult* out, uint32_t max_results);
+
+#endif // CAPFRAMEX_GPU_TIMING_H
@@ -0,0 +1,217 @@
+#include "handle_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDLE_MAP_MIN_CAPACITY 16
+
+typedef struct {
+    uint64_t key;
+    void* value;
+} HandleMapEntry;
+
+struct HandleMapTable {
+    uint32_t capacity;  // Power of two, at most half full
+    uint32_t count;
+    HandleMapTable* next_retired;
+    HandleMapEntry entries[];
+};
+
+// Handles and dispatch pointers are aligned, so mix the bits before masking
+static inline uint32_t hash_key(uint64_t key, uint32_t capacity) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t)key & (capacity - 1);
+}
+
+static HandleMapEntry* find_slot(HandleMapTable* table, uint64_t key) {
+    uint32_t mask = table->capacity - 1;
+    uint32_t i = hash_key(key, table->capacity);
+
+    // Never full (load factor <= 0.5), so an empty slot always ends the probe
+    while (table->entries[i].key != 0 && table->entries[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    return &table->entries[i];
+}
+
+// Readers announce themselves before loading the table. Both sides use
+// seq_cst so a writer that stores a new table and then sees no readers knows
+// every later reader loads the new table (see reclaim_retired).
+static inline HandleMapTable* read_lock(HandleMap* map) {
+    atomic_fetch_add_explicit(&map->readers, 1, memory_order_seq_cst);
+    return atomic_load_explicit(&map->table, memory_order_seq_cst);
+}
+
+static void reclaim_retired(HandleMap* map);
+
+// The last reader out frees tables a write had to leave behind. trylock
+// keeps lookups from ever blocking on a writer; if one holds the mutex the
+// tables wait for the next lookup to finish.
+static inline void read_unlock(HandleMap* map) {
+    if (atomic_fetch_sub_explicit(&map->readers, 1, memory_order_seq_cst) == 1 &&
+        atomic_load_explicit(&map->has_retired, memory_order_relaxed) &&
+        pthread_mutex_trylock(&map->write_mutex) == 0) {
+        reclaim_retired(map);
+        pthread_mutex_unlock(&map->write_mutex);
+    }
+}
+
+void* handle_map_get(HandleMap* map, uint64_t key) {
+    if (key == 0) {
+        return NULL;
+    }
+
+    HandleMapTable* table = read_lock(map);
+    void* value = NULL;
+    if (table) {
+        HandleMapEntry* entry = find_slot(table, key);
+        if (entry->key == key) {
+            value = entry->value;
+        }
+    }
+    read_unlock(map);
+    return value;
+}
+
+// Build a copy of old (if any) sized for count entries, skipping skip_key
+static HandleMapTable* copy_table(HandleMapTable* old, uint32_t count, uint64_t skip_key) {
+    uint32_t capacity = HANDLE_MAP_MIN_CAPACITY;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+
+    HandleMapTable* table = calloc(1, sizeof(HandleMapTable) + capacity * sizeof(HandleMapEntry));
+    if (!table) {
+        return NULL;
+    }
+    table->capacity = capacity;
+
+    if (old) {
+        for (uint32_t i = 0; i < old->capacity; i++) {
+            if (old->entries[i].key != 0 && old->entries[i].key != skip_key) {
+                *find_slot(table, old->entries[i].key) = old->entries[i];
+                table->count++;
+            }
+        }
+    }
+    return table;
+}
+
+// Free retired tables if no reader is active (caller holds write_mutex and
+// the current table is already published). A reader counted after this
+// load loads the table after the publish, so it never sees a retired one.
+// If readers are active the last of them calls back in (read_unlock).
+static void reclaim_retired(HandleMap* map) {
+    if (atomic_load_explicit(&map->readers, memory_order_seq_cst) != 0) {
+        return;
+    }
+
+    while (map->retired) {
+        HandleMapTable* next = map->retired->next_retired;
+        free(map->retired);
+        map->retired = next;
+    }
+    atomic_store_explicit(&map->has_retired, false, memory_order_relaxed);
+}
+
+// Publish a new table and retire the old one (caller holds write_mutex)
+static void publish_table(HandleMap* map, HandleMapTable* old, HandleMapTable* table) {
+    atomic_store_explicit(&map->table, table, memory_order_seq_cst);
+
+    if (old) {
+        old->next_retired = map->retired;
+        map->retired = old;
+        atomic_store_explicit(&map->has_retired, true, memory_order_seq_cst);
+    }
+    reclaim_retired(map);
+}
+
+bool handle_map_put(HandleMap* map, uint64_t key, void* value) {
+    if (key == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&map->write_mutex);
+
+    HandleMapTable* old = atomic_load_explicit(&map->table, memory_order_relaxed);
+    uint32_t count = old ? old->count : 0;
+
+    HandleMapTable* table = copy_table(old, count + 1, key);
+    if (!table) {
+        pthread_mutex_unlock(&map->write_mutex);
+        return false;
+    }
+
+    HandleMapEntry* entry = find_slot(table, key);
+    entry->key = key;
+    entry->value = value;
+    table->count++;
+
+    publish_table(map, old, table);
+
+    pthread_mutex_unlock(&map->write_mutex);
+    return true;
+}
+
+void* handle_map_remove(HandleMap* map, uint64_t key) {
+    if (key == 0) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&map->write_mutex);
+
+    HandleMapTable* old = atomic_load_explicit(&map->table, memory_order_relaxed);
+    HandleMapEntry* entry = old ? find_slot(old, key) : NULL;
+    if (!entry || entry->key != key) {
+        pthread_mutex_unlock(&map->write_mutex);
+        return NULL;
+    }
+
+    void* value = entry->value;
+    HandleMapTable* table = copy_table(old, old->count - 1, key);
+    if (!table) {
+        // Out of memory - keep the entry rather than corrupt the live table
+        pthread_mutex_unlock(&map->write_mutex);
+        return NULL;
+    }
+
+    publish_table(map, old, table);
+
+    pthread_mutex_unlock(&map->write_mutex);
+    return value;
+}
+
+uint32_t handle_map_count(HandleMap* map) {
+    HandleMapTable* table = read_lock(map);
+    uint32_t count = table ? table->count : 0;
+    read_unlock(map);
+    return count;
+}
+
+void handle_map_for_each(HandleMap* map, void (*fn)(uint64_t key, void* value, void* ctx), void* ctx) {
+    HandleMapTable* table = read_lock(map);
+    if (table) {
+        for (uint32_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i].key != 0) {
+                fn(table->entries[i].key, table->entries[i].value, ctx);
+            }
+        }
+    }
+    read_unlock(map);
+}
+
+void handle_map_destroy(HandleMap* map) {
+    pthread_mutex_lock(&map->write_mutex);
+
+    free(atomic_exchange(&map->table, NULL));
+    while (map->retired) {
+        HandleMapTable* next = map->retired->next_retired;
+        free(map->retired);
+        map->retired = next;
+    }
+    atomic_store_explicit(&map->has_retired, false, memory_order_relaxed);
+
+    pthread_mutex_unlock(&map->write_mutex);
+}
@@ -0,0 +1,60 @@
+#ifndef CAPFRAMEX_HANDLE_MAP_H
+#define CAPFRAMEX_HANDLE_MAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Read-mostly map from a 64-bit handle key to a pointer.
+//
+// Lookups are lock-free: they load the current table with acquire semantics
+// and probe it. Inserts and removes are rare (object creation/destruction),
+// so they take write_mutex, build a new table and publish it (RCU-style
+// copy-on-write). Every reader bumps the map's reader count for the duration
+// of its probe; replaced tables go on a retired list and are freed as soon
+// as the count is seen at zero - by the write itself, or by the last reader
+// to leave (a reader that starts after the publish only sees the new table).
+//
+// Key 0 is reserved (no valid Vulkan handle or dispatch key is 0).
+
+typedef struct HandleMapTable HandleMapTable;
+
+typedef struct {
+    _Atomic(HandleMapTable*) table;
+    atomic_uint readers;      // Lookups currently probing some table
+    pthread_mutex_t write_mutex;
+    HandleMapTable* retired;  // Newest first, protected by write_mutex
+    atomic_bool has_retired;  // retired != NULL, readable without the mutex
+} HandleMap;
+
+#define HANDLE_MAP_INITIALIZER { NULL, 0, PTHREAD_MUTEX_INITIALIZER, NULL, false }
+
+// Loader dispatch key of a dispatchable handle. Child handles (physical
+// devices, queues, command buffers) share the key of their instance/device.
+static inline uint64_t handle_map_dispatch_key(const void* handle) {
+    return (uint64_t)(uintptr_t)*(void* const*)handle;
+}
+
+// Lock-free lookup, returns NULL if not found
+void* handle_map_get(HandleMap* map, uint64_t key);
+
+// Insert or replace. Returns false if out of memory.
+bool handle_map_put(HandleMap* map, uint64_t key, void* value);
+
+// Remove a key, returns the value that was stored (NULL if none).
+// The caller owns the value; freeing it is safe once no other thread can
+// still look the key up (Vulkan external synchronization guarantees this for
+// destroyed handles).
+void* handle_map_remove(HandleMap* map, uint64_t key);
+
+// Number of entries
+uint32_t handle_map_count(HandleMap* map);
+
+// Call fn for every entry of the current snapshot. fn must not modify the map.
+void handle_map_for_each(HandleMap* map, void (*fn)(uint64_t key, void* value, void* ctx), void* ctx);
+
+// Free all tables. Only call when no other thread uses the map.
+void handle_map_destroy(HandleMap* map);
+
+#endif // CAPFRAMEX_HANDLE_MAP_H
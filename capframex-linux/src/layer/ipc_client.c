@@ -1,6 +1,11 @@
+#define _GNU_SOURCE  // memfd_create
 #include "ipc_client.h"
-#include "swapchain.h"
+#include "capture_tier.h"
+#include "overhead.h"
+#include "frame_limiter.h"
 #include "../daemon/common.h"
+#include "../daemon/frame_ring.h"
+#include "../daemon/message_stream.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,15 +15,93 @@
 #include <errno.h>
 #include <pthread.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
 
+// The connection belongs to the sender thread: it connects in the background,
+// reads the daemon's messages, is the only thread writing to the socket and
+// closes it once it is gone. The socket is non-blocking, so a stalled daemon
+// costs the sender thread a full socket buffer, never a blocked app thread.
 static int sock_fd = -1;
 static bool connected = false;
-static pthread_t receiver_thread;
-static volatile bool receiver_running = false;
+static _Atomic uint32_t connection_generation = 0;  // Bumped on every successful connect
 static pthread_mutex_t ipc_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Bytes of a message the socket did not take yet (sender thread only). They
+// go out before anything else, so messages never interleave.
+static char pending_out[MESSAGE_STREAM_MAX_MESSAGE];
+static size_t pending_out_len = 0;
+static size_t pending_out_sent = 0;
+static int pending_out_fds[2];
+static int pending_out_fd_count = 0;  // Not sent yet, go with the first byte
+
+// Control messages from app threads (hello, swapchain info) wait here for
+// the sender thread
+#define CONTROL_QUEUE_SIZE 16
+
+typedef struct {
+    MessageType type;
+    uint32_t payload_size;
+    union {
+        LayerHelloPayload hello;
+        SwapchainInfoPayload swapchain;
+    } payload;
+} ControlMessage;
+
+static ControlMessage control_queue[CONTROL_QUEUE_SIZE];
+static uint32_t control_head = 0;
+static uint32_t control_count = 0;
+static pthread_mutex_t control_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Daemon messages split across reads (sender thread only)
+static MessageStream receive_stream;
+
+// Frame queue: present threads push, the sender thread drains it and ships
+// frames to the daemon so the present path never touches the socket.
+// Bounded lock-free queue with per-slot sequence numbers.
+#define FRAME_QUEUE_SIZE 1024                // Must be a power of two
+#define FRAME_BATCH_MAX 8                    // Frames per send() on the legacy path
+#define FRAME_FLUSH_INTERVAL_NS 2000000ULL   // Sender wakes every 2 ms while frames flow
+#define OVERHEAD_REPORT_INTERVAL_NS 1000000000ULL  // Layer overhead stats once per second
+
+typedef struct {
+    _Atomic uint64_t seq;
+    FrameDataPoint point;
+} FrameQueueSlot;
+
+static FrameQueueSlot frame_queue[FRAME_QUEUE_SIZE];
+static _Atomic uint64_t queue_enqueue_pos = 0;
+static uint64_t queue_dequeue_pos = 0;  // Sender thread only
+static _Atomic uint64_t frames_dropped_queue_full = 0;
+// Set while the sender thread sleeps without a timeout on an empty queue;
+// the next frame pushed clears it and wakes the thread
+static _Atomic bool sender_idle = false;
+
+static pthread_t sender_thread;
+static volatile bool sender_running = false;
+static int wake_fd = -1;  // eventfd, wakes the sender thread (control messages, shutdown)
+static void* sender_thread_func(void* arg);
+
+// Connection attempts back off exponentially while there is no daemon, so a
+// Vulkan process without one costs a wakeup every few seconds at most
+#define CONNECT_BACKOFF_MIN_NS 100000000ULL    // 100 ms
+#define CONNECT_BACKOFF_MAX_NS 5000000000ULL   // 5 s
+
+// Shared-memory frame ring handed to the daemon with every hello. Once the
+// daemon acks CAPFRAMEX_CAP_SHM_RING the sender thread writes frames here
+// instead of the socket and only signals ring_event_fd when the daemon idles.
+static FrameRing* frame_ring = NULL;
+static int ring_fd = -1;
+static int ring_event_fd = -1;
+static _Atomic uint64_t frames_dropped_ring_full = 0;
+
+// Capabilities announced by the daemon in MSG_HELLO_ACK (0 until acked,
+// which keeps older daemons on one MSG_FRAMETIME_DATA per frame)
+static _Atomic uint32_t daemon_capabilities = 0;
+
 // Verbose debug mode - set CAPFRAMEX_DEBUG=1 to enable
 static int verbose_mode = -1;  // -1 = not initialized
 
@@ -49,10 +132,7 @@ void ipc_debug_log(const char* fmt, ...) {
 static pid_t cached_pid = 0;
 static char cached_process_name[256] = {0};
 static char cached_gpu_name[256] = {0};
-
-// Reconnection tracking
-static struct timespec last_connect_attempt = {0, 0};
-#define RECONNECT_INTERVAL_MS 100  // 0.1 seconds between reconnect attempts
+static uint8_t cached_graphics_api = GRAPHICS_API_UNKNOWN;
 
 static const char* get_socket_path(void) {
     static char path[256];
@@ -75,94 +155,318 @@ static const char* get_socket_path(void) {
     return path;
 }
 
-static int send_message(MessageType type, void* payload, uint32_t payload_size) {
+static uint64_t get_header_timestamp(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Serialize header + payload into dst, returns the number of bytes written
+static size_t write_message(char* dst, MessageType type, const void* payload,
+                            uint32_t payload_size, uint64_t timestamp) {
+    MessageHeader header = {
+        .type = type,
+        .payload_size = payload_size,
+        .timestamp = timestamp
+    };
+    memcpy(dst, &header, sizeof(header));
+    if (payload && payload_size > 0) {
+        memcpy(dst + sizeof(header), payload, payload_size);
+    }
+    return sizeof(header) + payload_size;
+}
+
+// One non-blocking write, optionally passing file descriptors along
+// (SCM_RIGHTS). Returns the bytes sent, 0 if the socket is full or -1 on error.
+static ssize_t send_nonblocking(const char* buffer, size_t size, const int* fds, int fd_count) {
+    union {
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { .iov_base = (void*)buffer, .iov_len = size };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+
+    if (fd_count > 0) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(fd_count * sizeof(int));
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fd_count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, fd_count * sizeof(int));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(sock_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    return sent;
+}
+
+static void mark_send_failed(ssize_t sent, size_t size) {
+    ipc_debug_log("send FAILED: sent=%zd/%zu, errno=%d (%s)", sent, size, errno, strerror(errno));
+
+    // Mark as disconnected so we reconnect
     pthread_mutex_lock(&ipc_mutex);
+    connected = false;
+    pthread_mutex_unlock(&ipc_mutex);
+}
+
+// Write out what an earlier send left over. Returns false on error.
+static bool flush_pending_out(void) {
+    while (pending_out_sent < pending_out_len) {
+        ssize_t sent = send_nonblocking(pending_out + pending_out_sent,
+                                        pending_out_len - pending_out_sent,
+                                        pending_out_fds, pending_out_fd_count);
+        if (sent < 0) {
+            mark_send_failed(sent, pending_out_len - pending_out_sent);
+            return false;
+        }
+        if (sent == 0) {
+            return true;  // Still full, POLLOUT brings us back
+        }
+        pending_out_fd_count = 0;
+        pending_out_sent += (size_t)sent;
+    }
+    pending_out_len = 0;
+    pending_out_sent = 0;
+    return true;
+}
 
-    // Check connection state under lock
-    if (sock_fd < 0 || !connected) {
-        pthread_mutex_unlock(&ipc_mutex);
+// True while the socket still owes bytes of an earlier message
+static bool send_blocked(void) {
+    return pending_out_len > 0;
+}
+
+// Send one or more already serialized messages in a single write (sender
+// thread only). Whatever the socket does not take is kept and finished
+// first; if an earlier message is still unfinished nothing is sent and -1
+// returned, so callers that must not lose a message check send_blocked().
+static int send_buffer_fds(const char* buffer, size_t size, const int* fds, int fd_count) {
+    if (sock_fd < 0 || !connected || !flush_pending_out() || send_blocked()) {
         return -1;
     }
 
-    // Copy fd while holding lock to avoid race
-    int fd = sock_fd;
-    pthread_mutex_unlock(&ipc_mutex);
+    ssize_t sent = send_nonblocking(buffer, size, fds, fd_count);
+    if (sent < 0 || size - (size_t)sent > sizeof(pending_out)) {
+        mark_send_failed(sent, size);
+        return -1;
+    }
+
+    if ((size_t)sent < size) {
+        memcpy(pending_out, buffer + sent, size - (size_t)sent);
+        pending_out_len = size - (size_t)sent;
+        pending_out_sent = 0;
+        pending_out_fd_count = sent == 0 ? fd_count : 0;
+        if (fd_count > 0) {
+            memcpy(pending_out_fds, fds, fd_count * sizeof(int));
+        }
+    }
+    return 0;
+}
 
+static int send_buffer(const char* buffer, size_t size) {
+    return send_buffer_fds(buffer, size, NULL, 0);
+}
+
+// fd_count is at most 2 (frame ring + eventfd)
+static int send_message_fds(MessageType type, void* payload, uint32_t payload_size,
+                            const int* fds, int fd_count) {
+    char stack_buffer[1024];
     size_t total_size = sizeof(MessageHeader) + payload_size;
-    char* buffer = malloc(total_size);
-    if (!buffer) return -1;
+    char* buffer = stack_buffer;
 
-    MessageHeader* header = (MessageHeader*)buffer;
-    header->type = type;
-    header->payload_size = payload_size;
+    if (total_size > sizeof(stack_buffer)) {
+        buffer = malloc(total_size);
+        if (!buffer) return -1;
+    }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-    header->timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    write_message(buffer, type, payload, payload_size, get_header_timestamp());
+    int result = send_buffer_fds(buffer, total_size, fds, fd_count);
 
-    if (payload && payload_size > 0) {
-        memcpy(buffer + sizeof(MessageHeader), payload, payload_size);
+    if (buffer != stack_buffer) {
+        free(buffer);
     }
+    return result;
+}
 
-    ssize_t sent = send(fd, buffer, total_size, MSG_NOSIGNAL);
-    int send_errno = errno;
-    free(buffer);
+static int send_message(MessageType type, void* payload, uint32_t payload_size) {
+    return send_message_fds(type, payload, payload_size, NULL, 0);
+}
 
-    if (sent != (ssize_t)total_size) {
-        // Always log send failures (errors, not debug)
-        ipc_debug_log("send_message FAILED: type=%d, sent=%zd/%zu, errno=%d (%s)",
-                  type, sent, total_size, send_errno, strerror(send_errno));
+static void wake_sender(void) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        ipc_debug_log("IPC thread wakeup failed: %s", strerror(errno));
+    }
+}
 
-        // Mark as disconnected so we try to reconnect
-        pthread_mutex_lock(&ipc_mutex);
-        connected = false;
-        pthread_mutex_unlock(&ipc_mutex);
-        return -1;
+// Hand a control message to the sender thread (any thread, never blocks on
+// the socket)
+static bool queue_control_message(MessageType type, const void* payload, uint32_t payload_size) {
+    pthread_mutex_lock(&control_mutex);
+    if (control_count == CONTROL_QUEUE_SIZE) {
+        pthread_mutex_unlock(&control_mutex);
+        ipc_debug_log("Control queue full, dropping message type %d", type);
+        return false;
     }
 
-    return 0;
+    ControlMessage* msg = &control_queue[(control_head + control_count) % CONTROL_QUEUE_SIZE];
+    msg->type = type;
+    msg->payload_size = payload_size;
+    memcpy(&msg->payload, payload, payload_size);
+    control_count++;
+    pthread_mutex_unlock(&control_mutex);
+
+    wake_sender();
+    return true;
+}
+
+static void clear_control_queue(void) {
+    pthread_mutex_lock(&control_mutex);
+    control_head = 0;
+    control_count = 0;
+    pthread_mutex_unlock(&control_mutex);
+}
+
+// Send queued control messages while the socket takes them (sender thread)
+static void send_control_messages(void) {
+    while (connected && !send_blocked()) {
+        ControlMessage msg;
+        pthread_mutex_lock(&control_mutex);
+        if (control_count == 0) {
+            pthread_mutex_unlock(&control_mutex);
+            return;
+        }
+        msg = control_queue[control_head];
+        control_head = (control_head + 1) % CONTROL_QUEUE_SIZE;
+        control_count--;
+        pthread_mutex_unlock(&control_mutex);
+
+        // Offer the frame ring with every hello; the daemon keeps the first
+        // one it receives on this connection and acks CAPFRAMEX_CAP_SHM_RING
+        int ring_fds[2] = { ring_fd, ring_event_fd };
+        int fd_count = (msg.type == MSG_LAYER_HELLO && frame_ring) ? 2 : 0;
+        send_message_fds(msg.type, &msg.payload, msg.payload_size, ring_fds, fd_count);
+    }
+}
+
+static bool frame_queue_push(const FrameDataPoint* point) {
+    uint64_t pos = atomic_load_explicit(&queue_enqueue_pos, memory_order_relaxed);
+
+    for (;;) {
+        FrameQueueSlot* slot = &frame_queue[pos & (FRAME_QUEUE_SIZE - 1)];
+        uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            // Slot is free for this position - try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue_enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->point = *point;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Queue full - sender thread is behind
+        } else {
+            pos = atomic_load_explicit(&queue_enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// Sender thread only
+static bool frame_queue_has_frames(void) {
+    FrameQueueSlot* slot = &frame_queue[queue_dequeue_pos & (FRAME_QUEUE_SIZE - 1)];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == queue_dequeue_pos + 1;
+}
+
+static bool frame_queue_pop(FrameDataPoint* out) {
+    uint64_t pos = queue_dequeue_pos;
+    FrameQueueSlot* slot = &frame_queue[pos & (FRAME_QUEUE_SIZE - 1)];
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+        return false;  // Empty (or producer still writing this slot)
+    }
+
+    *out = slot->point;
+    atomic_store_explicit(&slot->seq, pos + FRAME_QUEUE_SIZE, memory_order_release);
+    queue_dequeue_pos = pos + 1;
+    return true;
 }
 
-static void handle_message(MessageHeader* header, void* payload) {
+static void handle_message(const MessageHeader* header, const void* payload) {
     switch (header->type) {
         case MSG_PING:
             send_message(MSG_PONG, NULL, 0);
             break;
 
+        case MSG_HELLO_ACK:
+            if (payload && header->payload_size >= sizeof(HelloAckPayload)) {
+                HelloAckPayload ack;
+                memcpy(&ack, payload, sizeof(ack));
+                atomic_store(&daemon_capabilities, ack.capabilities);
+                ipc_debug_log("Daemon capabilities: 0x%x", ack.capabilities);
+            }
+            break;
+
         case MSG_CONFIG_UPDATE:
-            // Handle config updates if needed
+            if (payload && header->payload_size >= sizeof(CaptureConfigPayload)) {
+                CaptureConfigPayload config;
+                memcpy(&config, payload, sizeof(config));
+                if (config.pid == 0 || config.pid == cached_pid) {
+                    layer_set_capture_tier((CaptureTier)config.capture_tier);
+                }
+            }
+            break;
+
+        case MSG_FRAME_LIMIT:
+            if (payload && header->payload_size >= sizeof(FrameLimitPayload)) {
+                FrameLimitPayload limit;
+                memcpy(&limit, payload, sizeof(limit));
+                if (limit.pid == 0 || limit.pid == cached_pid) {
+                    frame_limiter_set_fps(limit.fps_limit);
+                }
+            }
             break;
 
         default:
             // Layer ignores most messages - it just streams data
             break;
     }
-    (void)payload;
 }
 
-static void* receiver_thread_func(void* arg) {
-    (void)arg;
-    char buffer[4096];
+static void dispatch_message(void* context, char* message, size_t len) {
+    (void)context;
+    MessageHeader header;
+    memcpy(&header, message, sizeof(header));
+    handle_message(&header, len > sizeof(header) ? message + sizeof(header) : NULL);
+}
 
-    while (receiver_running) {
-        ssize_t len = recv(sock_fd, buffer, sizeof(buffer), 0);
+// Handle everything the daemon sent, however the reads split it. Returns
+// false once the connection is gone.
+static bool receive_messages(void) {
+    static char buffer[MESSAGE_STREAM_READ_SIZE];  // Sender thread only
 
-        if (len <= 0) {
+    for (;;) {
+        ssize_t len = recv(sock_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (len < 0) {
             if (errno == EINTR) continue;
-            fprintf(stderr, "[CapFrameX Layer] Disconnected from daemon\n");
-            connected = false;
-            break;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (len == 0) {
+            return false;
         }
 
-        if (len >= (ssize_t)sizeof(MessageHeader)) {
-            MessageHeader* header = (MessageHeader*)buffer;
-            void* payload = (len > (ssize_t)sizeof(MessageHeader)) ?
-                            buffer + sizeof(MessageHeader) : NULL;
-            handle_message(header, payload);
+        if (!message_stream_feed(&receive_stream, buffer, (size_t)len, dispatch_message, NULL)) {
+            fprintf(stderr, "[CapFrameX Layer] Corrupt message from daemon\n");
+            return false;
         }
     }
-
-    return NULL;
 }
 
 static void get_process_name(char* buffer, size_t size) {
@@ -183,6 +487,56 @@ static void get_process_name(char* buffer, size_t size) {
     }
 }
 
+static void create_frame_ring(void) {
+    size_t size = frame_ring_size(CAPFRAMEX_FRAME_RING_CAPACITY);
+
+    ring_fd = memfd_create("capframex-frames", MFD_CLOEXEC);
+    if (ring_fd < 0 || ftruncate(ring_fd, (off_t)size) != 0) {
+        goto fail;
+    }
+
+    frame_ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    if (frame_ring == MAP_FAILED) {
+        frame_ring = NULL;
+        goto fail;
+    }
+    frame_ring_init(frame_ring, CAPFRAMEX_FRAME_RING_CAPACITY);
+
+    ring_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ring_event_fd < 0) {
+        goto fail;
+    }
+    return;
+
+fail:
+    // Not fatal - frames keep going over the socket
+    fprintf(stderr, "[CapFrameX Layer] Shared frame ring unavailable (%s) - using socket\n",
+            strerror(errno));
+    if (frame_ring) {
+        munmap(frame_ring, size);
+        frame_ring = NULL;
+    }
+    if (ring_fd >= 0) {
+        close(ring_fd);
+        ring_fd = -1;
+    }
+}
+
+static void destroy_frame_ring(void) {
+    if (frame_ring) {
+        munmap(frame_ring, frame_ring_size(CAPFRAMEX_FRAME_RING_CAPACITY));
+        frame_ring = NULL;
+    }
+    if (ring_fd >= 0) {
+        close(ring_fd);
+        ring_fd = -1;
+    }
+    if (ring_event_fd >= 0) {
+        close(ring_event_fd);
+        ring_event_fd = -1;
+    }
+}
+
 void ipc_client_init(void) {
     pthread_mutex_lock(&ipc_mutex);
 
@@ -191,48 +545,67 @@ void ipc_client_init(void) {
     get_process_name(cached_process_name, sizeof(cached_process_name));
 
     pthread_mutex_unlock(&ipc_mutex);
-}
 
-void ipc_client_cleanup(void) {
-    pthread_mutex_lock(&ipc_mutex);
+    create_frame_ring();
 
-    if (receiver_running) {
-        receiver_running = false;
-        shutdown(sock_fd, SHUT_RDWR);
-        pthread_join(receiver_thread, NULL);
+    // Start the sender thread, which also connects to the daemon
+    for (uint64_t i = 0; i < FRAME_QUEUE_SIZE; i++) {
+        atomic_init(&frame_queue[i].seq, i);
+    }
+    atomic_store(&queue_enqueue_pos, 0);
+    queue_dequeue_pos = 0;
+
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    sender_running = true;
+    if (pthread_create(&sender_thread, NULL, sender_thread_func, NULL) != 0) {
+        fprintf(stderr, "[CapFrameX Layer] Failed to start IPC thread - not streaming\n");
+        sender_running = false;
     }
+}
 
+// Close the connection (sender thread only)
+static void disconnect(void) {
+    pthread_mutex_lock(&ipc_mutex);
     if (sock_fd >= 0) {
         close(sock_fd);
         sock_fd = -1;
     }
-
     connected = false;
-
     pthread_mutex_unlock(&ipc_mutex);
-}
 
-bool ipc_client_connect(void) {
-    pthread_mutex_lock(&ipc_mutex);
+    // A new connection starts on a message boundary
+    pending_out_len = 0;
+    pending_out_sent = 0;
+    pending_out_fd_count = 0;
+    message_stream_reset(&receive_stream);
+    atomic_store(&daemon_capabilities, 0);
+}
 
-    if (connected) {
-        pthread_mutex_unlock(&ipc_mutex);
-        return true;
+void ipc_client_cleanup(void) {
+    // Stop the sender first - it flushes queued frames over the socket
+    if (sender_running) {
+        sender_running = false;
+        wake_sender();
+        pthread_join(sender_thread, NULL);
     }
 
-    // Clean up any old connection state before reconnecting
-    if (sock_fd >= 0) {
-        // Stop old receiver thread first
-        receiver_running = false;
-        shutdown(sock_fd, SHUT_RDWR);
-        close(sock_fd);
-        sock_fd = -1;
-        // Give the old thread a moment to exit (don't join - may deadlock)
+    disconnect();
+    message_stream_free(&receive_stream);
+
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
     }
 
-    sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sock_fd == -1) {
-        pthread_mutex_unlock(&ipc_mutex);
+    destroy_frame_ring();
+}
+
+// One connection attempt (sender thread only). Unix sockets connect at once
+// or fail - EAGAIN if the daemon's backlog is full - so the non-blocking
+// connect never leaves the thread waiting on a busy daemon.
+static bool try_connect(void) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
         return false;
     }
 
@@ -240,35 +613,28 @@ bool ipc_client_connect(void) {
     addr.sun_family = AF_UNIX;
     strncpy(addr.sun_path, get_socket_path(), sizeof(addr.sun_path) - 1);
 
-    fprintf(stderr, "[CapFrameX Layer] Attempting to connect to: %s\n", addr.sun_path);
-
-    if (connect(sock_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
-        fprintf(stderr, "[CapFrameX Layer] Connection failed: %s\n", strerror(errno));
-        close(sock_fd);
-        sock_fd = -1;
-        pthread_mutex_unlock(&ipc_mutex);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        ipc_debug_log("Connection to %s failed: %s", addr.sun_path, strerror(errno));
+        close(fd);
         return false;
     }
 
+    pthread_mutex_lock(&ipc_mutex);
+    sock_fd = fd;
     connected = true;
-
-    // Start receiver thread
-    receiver_running = true;
-    pthread_create(&receiver_thread, NULL, receiver_thread_func, NULL);
-
-    fprintf(stderr, "[CapFrameX Layer] Connected to daemon\n");
-
     pthread_mutex_unlock(&ipc_mutex);
 
-    // Send hello message to announce ourselves
-    // Note: Full GPU + swapchain info will be sent via pending_swapchain_send mechanism
-    // in QueuePresentKHR on the next frame render, which has access to correct device data
-    // At this point we don't know the present_timing status yet (device not created), pass false
-    fprintf(stderr, "[CapFrameX Layer] DEBUG: Sending hello after connect, cached_gpu_name='%s'\n", cached_gpu_name);
-    ipc_client_send_hello(cached_gpu_name, false);
+    // New connection - wait for this daemon's hello ack before batching
+    atomic_store(&daemon_capabilities, 0);
+    atomic_fetch_add(&connection_generation, 1);
 
-    fprintf(stderr, "[CapFrameX Layer] Connected to daemon - streaming enabled\n");
+    fprintf(stderr, "[CapFrameX Layer] Connected to daemon at %s - streaming enabled\n", addr.sun_path);
 
+    // Announce ourselves right away. GPU and swapchain info follow from the
+    // next present, which sees the new connection generation. Anything still
+    // queued was meant for the previous connection.
+    clear_control_queue();
+    ipc_client_send_hello(cached_gpu_name, false);
     return true;
 }
 
@@ -276,23 +642,8 @@ bool ipc_client_is_connected(void) {
     return connected;
 }
 
-bool ipc_client_try_reconnect(void) {
-    if (connected) return true;
-
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-
-    // Calculate elapsed time in milliseconds
-    long elapsed_ms = (now.tv_sec - last_connect_attempt.tv_sec) * 1000 +
-                      (now.tv_nsec - last_connect_attempt.tv_nsec) / 1000000;
-
-    if (elapsed_ms < RECONNECT_INTERVAL_MS) {
-        return false;  // Too soon to retry
-    }
-    last_connect_attempt = now;
-
-    // Try to connect
-    return ipc_client_connect();
+uint32_t ipc_client_connection_generation(void) {
+    return atomic_load_explicit(&connection_generation, memory_order_acquire);
 }
 
 void ipc_client_set_gpu_name(const char* gpu_name) {
@@ -304,10 +655,15 @@ void ipc_client_set_gpu_name(const char* gpu_name) {
     pthread_mutex_unlock(&ipc_mutex);
 }
 
+void ipc_client_set_graphics_api(GraphicsApi api) {
+    pthread_mutex_lock(&ipc_mutex);
+    cached_graphics_api = (uint8_t)api;
+    pthread_mutex_unlock(&ipc_mutex);
+}
+
 void ipc_client_send_hello(const char* gpu_name, bool present_timing_supported) {
     if (!connected) {
-        fprintf(stderr, "[CapFrameX Layer] DEBUG: send_hello called but not connected, GPU=%s\n",
-                gpu_name ? gpu_name : "(null)");
+        ipc_debug_log("send_hello called but not connected, GPU=%s", gpu_name ? gpu_name : "(null)");
         return;
     }
 
@@ -316,24 +672,24 @@ void ipc_client_send_hello(const char* gpu_name, bool present_timing_supported)
     strncpy(payload.process_name, cached_process_name, sizeof(payload.process_name) - 1);
     if (gpu_name && strlen(gpu_name) > 0) {
         strncpy(payload.gpu_name, gpu_name, sizeof(payload.gpu_name) - 1);
-        fprintf(stderr, "[CapFrameX Layer] DEBUG: Using provided GPU name: '%s'\n", gpu_name);
+        ipc_debug_log("Using provided GPU name: '%s'", gpu_name);
     } else {
         strncpy(payload.gpu_name, cached_gpu_name, sizeof(payload.gpu_name) - 1);
-        fprintf(stderr, "[CapFrameX Layer] DEBUG: Using cached GPU name: '%s' (provided was empty)\n", cached_gpu_name);
+        ipc_debug_log("Using cached GPU name: '%s' (provided was empty)", cached_gpu_name);
     }
     payload.present_timing_supported = present_timing_supported ? 1 : 0;
+    payload.graphics_api = cached_graphics_api;
 
-    int result = send_message(MSG_LAYER_HELLO, &payload, sizeof(payload));
+    bool queued = queue_control_message(MSG_LAYER_HELLO, &payload, sizeof(payload));
 
-    fprintf(stderr, "[CapFrameX Layer] Sent hello: PID=%d, process=%s, GPU='%s', present_timing=%d, result=%d\n",
-            payload.pid, payload.process_name, payload.gpu_name, payload.present_timing_supported, result);
+    ipc_debug_log("Queued hello: PID=%d, process=%s, GPU='%s', present_timing=%d, queued=%d",
+            payload.pid, payload.process_name, payload.gpu_name, payload.present_timing_supported, queued);
 }
 
 void ipc_client_send_swapchain_created(uint32_t width, uint32_t height,
                                         uint32_t format, uint32_t image_count) {
     if (!connected) {
-        fprintf(stderr, "[CapFrameX Layer] DEBUG: send_swapchain_created called but not connected, res=%ux%u\n",
-                width, height);
+        ipc_debug_log("send_swapchain_created called but not connected, res=%ux%u", width, height);
         return;
     }
 
@@ -345,10 +701,10 @@ void ipc_client_send_swapchain_created(uint32_t width, uint32_t height,
         .image_count = image_count
     };
 
-    int result = send_message(MSG_SWAPCHAIN_CREATED, &payload, sizeof(payload));
+    bool queued = queue_control_message(MSG_SWAPCHAIN_CREATED, &payload, sizeof(payload));
 
-    fprintf(stderr, "[CapFrameX Layer] Sent swapchain info: %ux%u, format=%u, images=%u, result=%d\n",
-            width, height, format, image_count, result);
+    ipc_debug_log("Queued swapchain info: %ux%u, format=%u, images=%u, queued=%d",
+            width, height, format, image_count, queued);
 }
 
 void ipc_client_send_swapchain_destroyed(void) {
@@ -362,13 +718,266 @@ void ipc_client_send_swapchain_destroyed(void) {
         .image_count = 0
     };
 
-    send_message(MSG_SWAPCHAIN_DESTROYED, &payload, sizeof(payload));
+    queue_control_message(MSG_SWAPCHAIN_DESTROYED, &payload, sizeof(payload));
 }
 
-// Frame count for debug logging
+// Frame count for debug logging (sender thread only)
 static uint64_t frames_sent = 0;
 static uint64_t last_log_frame = 0;
 
+static void count_frames_sent(uint32_t frame_count, const FrameDataPoint* last) {
+    frames_sent += frame_count;
+    // Log every 1000 frames
+    if (frames_sent - last_log_frame >= 1000) {
+        fprintf(stderr, "[CapFrameX Layer] Sent %lu frames (PID=%d, CPU FT=%.2fms, Actual FT=%.2fms, queue drops=%lu, ring drops=%lu)\n",
+                (unsigned long)frames_sent, cached_pid, last->frametime_ms, last->actual_frametime_ms,
+                (unsigned long)atomic_load(&frames_dropped_queue_full),
+                (unsigned long)atomic_load(&frames_dropped_ring_full));
+        last_log_frame = frames_sent;
+    }
+}
+
+static void send_frame_batch(const char* buffer, size_t size, uint32_t frame_count,
+                             const FrameDataPoint* last) {
+    if (send_buffer(buffer, size) == 0) {
+        count_frames_sent(frame_count, last);
+    }
+}
+
+// Drain the frame queue into the shared frame ring, waking the daemon at most
+// once per flush and only if it had already caught up
+static void flush_frame_queue_ring(void) {
+    FrameDataPoint frames[CAPFRAMEX_MAX_FRAME_BATCH];
+    bool wake = false;
+    uint32_t count;
+
+    do {
+        count = 0;
+        while (count < CAPFRAMEX_MAX_FRAME_BATCH && frame_queue_pop(&frames[count])) {
+            count++;
+        }
+        if (count == 0) break;
+
+        bool needs_wakeup;
+        uint32_t written = frame_ring_write(frame_ring, frames, count, &needs_wakeup);
+        wake |= needs_wakeup;
+        if (written < count) {
+            atomic_fetch_add_explicit(&frames_dropped_ring_full, count - written, memory_order_relaxed);
+        }
+        if (written > 0) {
+            count_frames_sent(written, &frames[written - 1]);
+        }
+    } while (count == CAPFRAMEX_MAX_FRAME_BATCH);
+
+    if (wake) {
+        uint64_t one = 1;
+        if (write(ring_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            ipc_debug_log("Frame ring wakeup failed: %s", strerror(errno));
+        }
+    }
+}
+
+// Drain the frame queue into MSG_FRAMETIME_BATCH messages of up to
+// CAPFRAMEX_MAX_FRAME_BATCH frames
+static void flush_frame_queue_batched(void) {
+    char buffer[sizeof(MessageHeader) + sizeof(FrameBatchHeader) +
+                CAPFRAMEX_MAX_FRAME_BATCH * sizeof(FrameDataPoint)];
+    FrameDataPoint* frames = (FrameDataPoint*)(buffer + sizeof(MessageHeader) + sizeof(FrameBatchHeader));
+    uint32_t count = 0;
+
+    for (;;) {
+        bool have_frame = count < CAPFRAMEX_MAX_FRAME_BATCH && !send_blocked() &&
+                          frame_queue_pop(&frames[count]);
+        if (have_frame) {
+            count++;
+            continue;
+        }
+        if (count == 0) {
+            break;  // Empty, or frames wait in the queue until the socket drains
+        }
+
+        // Header and batch header are written in place in front of the frames
+        FrameBatchHeader batch = { .count = count, .frame_size = sizeof(FrameDataPoint) };
+        uint32_t payload_size = sizeof(batch) + count * sizeof(FrameDataPoint);
+        MessageHeader header = {
+            .type = MSG_FRAMETIME_BATCH,
+            .payload_size = payload_size,
+            .timestamp = get_header_timestamp()
+        };
+        memcpy(buffer, &header, sizeof(header));
+        memcpy(buffer + sizeof(header), &batch, sizeof(batch));
+
+        send_frame_batch(buffer, sizeof(header) + payload_size, count, &frames[count - 1]);
+        count = 0;
+    }
+}
+
+// Drain the frame queue, packing up to FRAME_BATCH_MAX messages per send()
+static void flush_frame_queue(void) {
+    uint32_t caps = atomic_load(&daemon_capabilities);
+
+    if ((caps & CAPFRAMEX_CAP_SHM_RING) && frame_ring) {
+        flush_frame_queue_ring();
+        return;
+    }
+    if (caps & CAPFRAMEX_CAP_FRAME_BATCH) {
+        flush_frame_queue_batched();
+        return;
+    }
+
+    char buffer[FRAME_BATCH_MAX * (sizeof(MessageHeader) + sizeof(FrameDataPoint))];
+    FrameDataPoint point;
+    size_t used = 0;
+    uint32_t batched = 0;
+    uint64_t timestamp = get_header_timestamp();
+
+    while (!send_blocked() && frame_queue_pop(&point)) {
+        used += write_message(buffer + used, MSG_FRAMETIME_DATA, &point, sizeof(point), timestamp);
+        if (++batched == FRAME_BATCH_MAX) {
+            send_frame_batch(buffer, used, batched, &point);
+            used = 0;
+            batched = 0;
+        }
+    }
+
+    if (batched > 0) {
+        send_frame_batch(buffer, used, batched, &point);
+    }
+}
+
+// Report the layer's present overhead if anything changed since last time
+static void send_overhead_stats(void) {
+    static uint64_t last_sample_count = 0;
+
+    OverheadStats stats;
+    if (!connected || !overhead_get_stats(&stats) || stats.sample_count == last_sample_count) {
+        return;
+    }
+    last_sample_count = stats.sample_count;
+
+    LayerOverheadPayload payload = {
+        .pid = cached_pid,
+        .sample_count = stats.sample_count,
+        .p50_ns = stats.p50_ns,
+        .p90_ns = stats.p90_ns,
+        .p99_ns = stats.p99_ns,
+        .p999_ns = stats.p999_ns,
+        .max_ns = stats.max_ns,
+        .mean_ns = stats.mean_ns
+    };
+    send_message(MSG_LAYER_OVERHEAD_STATS, &payload, sizeof(payload));
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Decide whether the sender can sleep until something happens rather than
+// until the next flush: only with an empty queue. A producer pushing a frame
+// after the check sees sender_idle (both sides fence) and wakes the thread.
+static bool sender_go_idle(void) {
+    if (frame_queue_has_frames()) {
+        return false;
+    }
+    atomic_store_explicit(&sender_idle, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (frame_queue_has_frames()) {
+        atomic_store_explicit(&sender_idle, false, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// Connects (and reconnects) to the daemon, handles its messages and ships
+// queued frames every FRAME_FLUSH_INTERVAL_NS while frames are coming in.
+// With nothing queued it sleeps until a frame, a message or shutdown, so an
+// idle process (launcher, minimized app) costs no periodic wakeups.
+static void* sender_thread_func(void* arg) {
+    (void)arg;
+    uint64_t now = monotonic_ns();
+    uint64_t next_flush = now;
+    uint64_t next_connect = now;  // First attempt right away
+    uint64_t backoff_ns = CONNECT_BACKOFF_MIN_NS;
+    uint64_t last_overhead_report = 0;
+
+    while (sender_running) {
+        // A failed send marks the connection lost; close it here
+        if (!connected && sock_fd >= 0) {
+            fprintf(stderr, "[CapFrameX Layer] Disconnected from daemon\n");
+            disconnect();
+        }
+
+        if (!connected && now >= next_connect) {
+            if (try_connect()) {
+                backoff_ns = CONNECT_BACKOFF_MIN_NS;
+                next_flush = now;
+            } else {
+                next_connect = now + backoff_ns;
+                backoff_ns = backoff_ns * 2 < CONNECT_BACKOFF_MAX_NS ? backoff_ns * 2 : CONNECT_BACKOFF_MAX_NS;
+            }
+        }
+
+        // Sleep until the next flush (if frames are queued) or connection
+        // attempt, a frame into an empty queue, a message from the daemon,
+        // room in a full socket, a queued control message or shutdown
+        bool idle = connected && sender_go_idle();
+        uint64_t deadline = connected ? next_flush : next_connect;
+        uint64_t wait_ns = deadline > now ? deadline - now : 0;
+        struct timespec timeout = {
+            .tv_sec = (time_t)(wait_ns / 1000000000ULL),
+            .tv_nsec = (long)(wait_ns % 1000000000ULL)
+        };
+        struct pollfd fds[2] = {
+            { .fd = wake_fd, .events = POLLIN },
+            { .fd = connected ? sock_fd : -1, .events = POLLIN | (send_blocked() ? POLLOUT : 0) }
+        };
+        int ready = ppoll(fds, 2, idle ? NULL : &timeout, NULL);
+        atomic_store_explicit(&sender_idle, false, memory_order_relaxed);
+        now = monotonic_ns();
+
+        if (ready > 0 && fds[0].revents != 0) {
+            uint64_t value;
+            if (read(wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                ipc_debug_log("IPC thread wakeup read failed: %s", strerror(errno));
+            }
+        }
+
+        if (ready > 0 && (fds[1].revents & ~POLLOUT) != 0 && !receive_messages()) {
+            fprintf(stderr, "[CapFrameX Layer] Disconnected from daemon\n");
+            disconnect();
+            next_connect = now + CONNECT_BACKOFF_MIN_NS;
+            continue;
+        }
+
+        if (ready > 0 && (fds[1].revents & POLLOUT)) {
+            flush_pending_out();
+        }
+        send_control_messages();
+
+        if (connected && now >= next_flush) {
+            flush_frame_queue();
+
+            // Every flush drains the whole queue, so don't catch up after
+            // an idle period or a stall (e.g. suspended process)
+            next_flush += FRAME_FLUSH_INTERVAL_NS;
+            if (next_flush <= now) {
+                next_flush = now + FRAME_FLUSH_INTERVAL_NS;
+            }
+
+            if (now - last_overhead_report >= OVERHEAD_REPORT_INTERVAL_NS) {
+                last_overhead_report = now;
+                send_overhead_stats();
+            }
+        }
+    }
+
+    // Ship whatever is left before shutting down
+    flush_frame_queue();
+    return NULL;
+}
+
 void ipc_client_send_frame_data(const FrameTimingData* frame) {
     // Always send if connected - continuous streaming model
     if (!connected) {
@@ -392,16 +1001,26 @@ void ipc_client_send_frame_data(const FrameTimingData* frame) {
         .ms_until_render_complete = frame->ms_until_render_complete,
         .ms_until_displayed = frame->ms_until_displayed,
         .actual_frametime_ms = frame->actual_frametime_ms,
-        .padding = 0
+        .swapchain_id = frame->swapchain_id,
+        .acquire_time_ns = frame->acquire_time_ns,
+        .acquire_wait_ms = frame->acquire_wait_ms,
+        .acquire_to_present_ms = frame->acquire_to_present_ms,
+        .gpu_active_ms = frame->gpu_active_ms,
+        .limiter_error_ms = frame->limiter_error_ms,
+        .display_state = frame->display_state,
+        .missed_vblanks = frame->missed_vblanks
     };
 
-    int result = send_message(MSG_FRAMETIME_DATA, &point, sizeof(point));
+    if (!frame_queue_push(&point)) {
+        atomic_fetch_add_explicit(&frames_dropped_queue_full, 1, memory_order_relaxed);
+        return;
+    }
 
-    frames_sent++;
-    // Log every 1000 frames or every 10 seconds
-    if (frames_sent - last_log_frame >= 1000) {
-        fprintf(stderr, "[CapFrameX Layer] Sent %lu frames (PID=%d, CPU FT=%.2fms, Actual FT=%.2fms, result=%d)\n",
-                (unsigned long)frames_sent, cached_pid, frame->frametime_ms, frame->actual_frametime_ms, result);
-        last_log_frame = frames_sent;
+    // Wake a sender sleeping on an empty queue. It flushes at most once per
+    // FRAME_FLUSH_INTERVAL_NS, so this happens at most once per interval too.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&sender_idle, memory_order_relaxed) &&
+        atomic_exchange_explicit(&sender_idle, false, memory_order_relaxed)) {
+        wake_sender();
     }
 }
@@ -2,27 +2,34 @@
 #define CAPFRAMEX_IPC_CLIENT_H
 
 #include "timing.h"
+#include "../daemon/common.h"
 #include <stdbool.h>
 #include <stdint.h>
 
-// Initialize IPC client (caches process info)
+// Initialize IPC client (caches process info) and start its thread, which
+// connects to the daemon in the background and reconnects with backoff.
+// Never blocks on the daemon.
 void ipc_client_init(void);
 
 // Cleanup IPC client
 void ipc_client_cleanup(void);
 
-// Connect to daemon
-bool ipc_client_connect(void);
-
 // Check if connected to daemon
 bool ipc_client_is_connected(void);
 
-// Try to reconnect if not connected (rate-limited)
-bool ipc_client_try_reconnect(void);
+// Bumped on every successful (re)connect, 0 until the first one. Lets the
+// present path announce GPU and swapchain info once per connection.
+uint32_t ipc_client_connection_generation(void);
 
 // Set GPU name (call when device is created)
 void ipc_client_set_gpu_name(const char* gpu_name);
 
+// Set the API tag sent with every hello (call before connecting)
+void ipc_client_set_graphics_api(GraphicsApi api);
+
+// Control messages below are queued for the IPC thread, which is the only
+// one writing to the socket, so they never block the calling thread.
+
 // Send hello message to daemon (announces this layer instance)
 void ipc_client_send_hello(const char* gpu_name, bool present_timing_supported);
 
@@ -1,13 +1,16 @@
 #include "layer.h"
 #include "swapchain.h"
-#include "timing.h"
 #include "ipc_client.h"
+#include "handle_map.h"
+#include "gpu_timing.h"
+#include "frame_limiter.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
+#include <strings.h>
 #include <unistd.h>
+#include <stdatomic.h>
 
 // Forward declarations for layer entry points
 VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL layer_GetInstanceProcAddr(
@@ -15,19 +18,12 @@ VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL layer_GetInstanceProcAd
 VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL layer_GetDeviceProcAddr(
     VkDevice device, const char* pName);
 
-// Simple hash map for instance/device data
-#define MAX_INSTANCES 16
-#define MAX_DEVICES 16
+// Instance and device data, keyed by loader dispatch pointer so child
+// handles (physical devices, queues) resolve to their parent directly.
+// Lookups are lock-free; see handle_map.h.
+static HandleMap instance_map = HANDLE_MAP_INITIALIZER;
+static HandleMap device_map = HANDLE_MAP_INITIALIZER;
 
-static InstanceData* instance_map[MAX_INSTANCES];
-static VkInstance instance_keys[MAX_INSTANCES];
-static int instance_count = 0;
-
-static DeviceData* device_map[MAX_DEVICES];
-static VkDevice device_keys[MAX_DEVICES];
-static int device_count = 0;
-
-static pthread_mutex_t map_mutex = PTHREAD_MUTEX_INITIALIZER;
 static bool layer_initialized = false;
 
 void layer_init(void) {
@@ -35,116 +31,85 @@ void layer_init(void) {
         return;
     }
 
-    timing_init();
-    ipc_client_init();
-
-    // Try to connect to daemon (will stream frames when connected)
-    bool conn_result = ipc_client_connect();
-
-    if (conn_result) {
-        fprintf(stderr, "[CapFrameX Layer] Connected to daemon - streaming enabled\n");
-    } else {
-        fprintf(stderr, "[CapFrameX Layer] Daemon not available - running standalone\n");
+    if (layer_initial_capture_tier() == CAPTURE_TIER_OFF) {
+        // Passthrough only - no sender thread, no socket, no reconnects
+        layer_initialized = true;
+        return;
     }
 
+    // The IPC thread connects in the background, so instance creation never
+    // waits for the daemon
+    ipc_client_set_graphics_api(GRAPHICS_API_VULKAN);
+    ipc_client_init();
+    frame_limiter_init();
+
     layer_initialized = true;
-    fprintf(stderr, "[CapFrameX Layer] Initialized for PID %d\n", getpid());
+    ipc_debug_log("Initialized for PID %d (capture tier: %s)",
+                  getpid(), capture_tier_name(layer_initial_capture_tier()));
+}
+
+static void free_map_value(uint64_t key, void* value, void* ctx) {
+    (void)key;
+    (void)ctx;
+    free(value);
 }
 
 void layer_cleanup(void) {
     if (!layer_initialized) return;
 
     ipc_client_cleanup();
-    timing_cleanup();
 
-    pthread_mutex_lock(&map_mutex);
-    for (int i = 0; i < instance_count; i++) {
-        free(instance_map[i]);
-    }
-    for (int i = 0; i < device_count; i++) {
-        free(device_map[i]);
-    }
-    instance_count = 0;
-    device_count = 0;
-    pthread_mutex_unlock(&map_mutex);
+    handle_map_for_each(&instance_map, free_map_value, NULL);
+    handle_map_for_each(&device_map, free_map_value, NULL);
+    handle_map_destroy(&instance_map);
+    handle_map_destroy(&device_map);
 
     layer_initialized = false;
 }
 
 InstanceData* layer_get_instance_data(VkInstance instance) {
-    pthread_mutex_lock(&map_mutex);
-    for (int i = 0; i < instance_count; i++) {
-        if (instance_keys[i] == instance) {
-            pthread_mutex_unlock(&map_mutex);
-            return instance_map[i];
-        }
-    }
-    pthread_mutex_unlock(&map_mutex);
-    return NULL;
+    return handle_map_get(&instance_map, handle_map_dispatch_key(instance));
+}
+
+InstanceData* layer_get_physical_device_instance_data(VkPhysicalDevice physical_device) {
+    return handle_map_get(&instance_map, handle_map_dispatch_key(physical_device));
 }
 
 DeviceData* layer_get_device_data(VkDevice device) {
-    pthread_mutex_lock(&map_mutex);
-    for (int i = 0; i < device_count; i++) {
-        if (device_keys[i] == device) {
-            pthread_mutex_unlock(&map_mutex);
-            return device_map[i];
-        }
-    }
-    pthread_mutex_unlock(&map_mutex);
-    return NULL;
+    return handle_map_get(&device_map, handle_map_dispatch_key(device));
+}
+
+DeviceData* layer_get_queue_device_data(VkQueue queue) {
+    return handle_map_get(&device_map, handle_map_dispatch_key(queue));
 }
 
 void layer_store_instance_data(VkInstance instance, InstanceData* data) {
-    pthread_mutex_lock(&map_mutex);
-    if (instance_count < MAX_INSTANCES) {
-        instance_keys[instance_count] = instance;
-        instance_map[instance_count] = data;
-        instance_count++;
+    if (!handle_map_put(&instance_map, handle_map_dispatch_key(instance), data)) {
+        fprintf(stderr, "[CapFrameX Layer] Failed to track instance\n");
     }
-    pthread_mutex_unlock(&map_mutex);
 }
 
 void layer_store_device_data(VkDevice device, DeviceData* data) {
-    pthread_mutex_lock(&map_mutex);
-    if (device_count < MAX_DEVICES) {
-        device_keys[device_count] = device;
-        device_map[device_count] = data;
-        device_count++;
+    if (!handle_map_put(&device_map, handle_map_dispatch_key(device), data)) {
+        fprintf(stderr, "[CapFrameX Layer] Failed to track device\n");
     }
-    pthread_mutex_unlock(&map_mutex);
 }
 
 void layer_remove_instance_data(VkInstance instance) {
-    pthread_mutex_lock(&map_mutex);
-    for (int i = 0; i < instance_count; i++) {
-        if (instance_keys[i] == instance) {
-            free(instance_map[i]);
-            for (int j = i; j < instance_count - 1; j++) {
-                instance_keys[j] = instance_keys[j + 1];
-                instance_map[j] = instance_map[j + 1];
-            }
-            instance_count--;
-            break;
-        }
-    }
-    pthread_mutex_unlock(&map_mutex);
+    free(handle_map_remove(&instance_map, handle_map_dispatch_key(instance)));
 }
 
 void layer_remove_device_data(VkDevice device) {
-    pthread_mutex_lock(&map_mutex);
-    for (int i = 0; i < device_count; i++) {
-        if (device_keys[i] == device) {
-            free(device_map[i]);
-            for (int j = i; j < device_count - 1; j++) {
-                device_keys[j] = device_keys[j + 1];
-                device_map[j] = device_map[j + 1];
-            }
-            device_count--;
-            break;
+    free(handle_map_remove(&device_map, handle_map_dispatch_key(device)));
+}
+
+static bool has_extension(const char* const* names, uint32_t count, const char* name) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return true;
         }
     }
-    pthread_mutex_unlock(&map_mutex);
+    return false;
 }
 
 // Hooked Vulkan functions
@@ -196,6 +161,19 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateInstance(
     LOAD_INSTANCE_PROC(GetPhysicalDeviceProperties);
     LOAD_INSTANCE_PROC(EnumerateDeviceExtensionProperties);
     LOAD_INSTANCE_PROC(GetPhysicalDeviceQueueFamilyProperties);
+    LOAD_INSTANCE_PROC(GetPhysicalDeviceFeatures2);
+    if (!data->dispatch.GetPhysicalDeviceFeatures2) {
+        // Vulkan 1.0 instance with VK_KHR_get_physical_device_properties2
+        data->dispatch.GetPhysicalDeviceFeatures2 =
+            (PFN_vkGetPhysicalDeviceFeatures2)fpGetInstanceProcAddr(*pInstance, "vkGetPhysicalDeviceFeatures2KHR");
+    }
+
+    // Only callable when the app enabled the extension (DXVK/vkd3d do); used to
+    // pick the present stages a surface can report timing for
+    if (has_extension(pCreateInfo->ppEnabledExtensionNames, pCreateInfo->enabledExtensionCount,
+                      VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME)) {
+        LOAD_INSTANCE_PROC(GetPhysicalDeviceSurfaceCapabilities2KHR);
+    }
 
 #undef LOAD_INSTANCE_PROC
 
@@ -221,14 +199,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
     const VkAllocationCallbacks* pAllocator,
     VkDevice* pDevice)
 {
-    // Get instance data from physical device (need to find the instance)
-    // For simplicity, we iterate through instances
-    InstanceData* inst_data = NULL;
-    pthread_mutex_lock(&map_mutex);
-    if (instance_count > 0) {
-        inst_data = instance_map[0];  // Simplified: use first instance
-    }
-    pthread_mutex_unlock(&map_mutex);
+    // Physical devices share their instance's dispatch key
+    InstanceData* inst_data = layer_get_physical_device_instance_data(physicalDevice);
 
     if (!inst_data) {
         return VK_ERROR_INITIALIZATION_FAILED;
@@ -252,7 +224,158 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
 
     chain_info->u.pLayerInfo = chain_info->u.pLayerInfo->pNext;
 
-    VkResult result = fpCreateDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    // Layer-created command buffers need the loader's dispatch pointer
+    PFN_vkSetDeviceLoaderData fpSetDeviceLoaderData = NULL;
+    for (const VkLayerDeviceCreateInfo* info = pCreateInfo->pNext; info;
+         info = (const VkLayerDeviceCreateInfo*)info->pNext) {
+        if (info->sType == VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO &&
+            info->function == VK_LOADER_DATA_CALLBACK) {
+            fpSetDeviceLoaderData = info->u.pfnSetDeviceLoaderData;
+            break;
+        }
+    }
+
+    bool has_ext_present_timing = false;
+    bool has_present_id2 = false;
+    const char* calibrated_timestamps_ext = NULL;
+    bool has_google_display_timing = false;
+
+    // With capture off the device is created exactly as requested
+    bool capture = layer_initial_capture_tier() != CAPTURE_TIER_OFF;
+
+    uint32_t ext_count = 0;
+    if (capture && inst_data->dispatch.EnumerateDeviceExtensionProperties) {
+        inst_data->dispatch.EnumerateDeviceExtensionProperties(physicalDevice, NULL, &ext_count, NULL);
+        if (ext_count > 0) {
+            VkExtensionProperties* exts = malloc(ext_count * sizeof(VkExtensionProperties));
+            if (exts) {
+                inst_data->dispatch.EnumerateDeviceExtensionProperties(physicalDevice, NULL, &ext_count, exts);
+                for (uint32_t i = 0; i < ext_count; i++) {
+                    if (strcmp(exts[i].extensionName, "VK_EXT_present_timing") == 0) {
+                        has_ext_present_timing = true;
+                    }
+                    if (strcmp(exts[i].extensionName, "VK_KHR_present_id2") == 0) {
+                        has_present_id2 = true;
+                    }
+                    if (strcmp(exts[i].extensionName, "VK_KHR_calibrated_timestamps") == 0) {
+                        calibrated_timestamps_ext = "VK_KHR_calibrated_timestamps";
+                    }
+                    if (!calibrated_timestamps_ext &&
+                        strcmp(exts[i].extensionName, "VK_EXT_calibrated_timestamps") == 0) {
+                        calibrated_timestamps_ext = "VK_EXT_calibrated_timestamps";
+                    }
+                    if (strcmp(exts[i].extensionName, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME) == 0) {
+                        has_google_display_timing = true;
+                    }
+                }
+                free(exts);
+            }
+        }
+    }
+
+    // VK_EXT_present_timing needs present IDs (VK_KHR_present_id2) and the
+    // presentTiming/presentId2 features
+    VkPhysicalDevicePresentId2FeaturesKHR id2_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_2_FEATURES_KHR
+    };
+    VkPhysicalDevicePresentTimingFeaturesEXT timing_features = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_TIMING_FEATURES_EXT,
+        .pNext = &id2_features
+    };
+    bool use_ext_timing = false;
+    if (has_ext_present_timing && has_present_id2 && inst_data->dispatch.GetPhysicalDeviceFeatures2) {
+        VkPhysicalDeviceFeatures2 features2 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &timing_features
+        };
+        inst_data->dispatch.GetPhysicalDeviceFeatures2(physicalDevice, &features2);
+        use_ext_timing = timing_features.presentTiming && id2_features.presentId2;
+    }
+
+    // Enable the timing extensions and features ourselves when the app didn't,
+    // so every present can be matched to its display time (see swapchain.c)
+    VkDeviceCreateInfo create_info = *pCreateInfo;
+    const char* extra_exts[4];
+    uint32_t extra_count = 0;
+
+    if (use_ext_timing) {
+        const VkPhysicalDevicePresentTimingFeaturesEXT* app_timing =
+            layer_find_in_chain(pCreateInfo->pNext, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_TIMING_FEATURES_EXT);
+        const VkPhysicalDevicePresentId2FeaturesKHR* app_id2 =
+            layer_find_in_chain(pCreateInfo->pNext, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_2_FEATURES_KHR);
+
+        // The app's feature structs are const - if it chained them with the
+        // feature off, leave its choice alone
+        if ((app_timing && !app_timing->presentTiming) || (app_id2 && !app_id2->presentId2)) {
+            use_ext_timing = false;
+        } else {
+            const void* next = pCreateInfo->pNext;
+            if (!app_id2) {
+                id2_features = (VkPhysicalDevicePresentId2FeaturesKHR){
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_2_FEATURES_KHR,
+                    .pNext = (void*)next,
+                    .presentId2 = VK_TRUE
+                };
+                next = &id2_features;
+            }
+            if (!app_timing) {
+                timing_features = (VkPhysicalDevicePresentTimingFeaturesEXT){
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_TIMING_FEATURES_EXT,
+                    .pNext = (void*)next,
+                    .presentTiming = VK_TRUE
+                };
+                next = &timing_features;
+            }
+            create_info.pNext = next;
+
+            extra_exts[extra_count++] = "VK_EXT_present_timing";
+            extra_exts[extra_count++] = "VK_KHR_present_id2";
+            if (calibrated_timestamps_ext) {
+                extra_exts[extra_count++] = calibrated_timestamps_ext;
+            }
+        }
+    }
+    if (has_google_display_timing) {
+        extra_exts[extra_count++] = VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME;
+    }
+
+    const char** enabled_exts = NULL;
+    if (extra_count > 0) {
+        enabled_exts = malloc((pCreateInfo->enabledExtensionCount + extra_count) * sizeof(const char*));
+        if (enabled_exts) {
+            uint32_t count = pCreateInfo->enabledExtensionCount;
+            if (count > 0) {
+                memcpy(enabled_exts, pCreateInfo->ppEnabledExtensionNames, count * sizeof(const char*));
+            }
+            for (uint32_t i = 0; i < extra_count; i++) {
+                if (!has_extension(pCreateInfo->ppEnabledExtensionNames,
+                                   pCreateInfo->enabledExtensionCount, extra_exts[i])) {
+                    enabled_exts[count++] = extra_exts[i];
+                }
+            }
+            create_info.enabledExtensionCount = count;
+            create_info.ppEnabledExtensionNames = enabled_exts;
+        } else {
+            create_info = *pCreateInfo;
+            use_ext_timing = false;
+            has_google_display_timing = has_google_display_timing &&
+                has_extension(pCreateInfo->ppEnabledExtensionNames, pCreateInfo->enabledExtensionCount,
+                              VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+        }
+    }
+    bool google_display_timing_enabled = has_google_display_timing;
+
+    VkResult result = fpCreateDevice(physicalDevice, &create_info, pAllocator, pDevice);
+    if (result != VK_SUCCESS && extra_count > 0) {
+        // Don't let our additions break device creation - retry as requested
+        use_ext_timing = false;
+        google_display_timing_enabled =
+            has_extension(pCreateInfo->ppEnabledExtensionNames, pCreateInfo->enabledExtensionCount,
+                          VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+        result = fpCreateDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    }
+    free(enabled_exts);
+
     if (result != VK_SUCCESS) {
         return result;
     }
@@ -264,6 +387,7 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
     }
 
     data->device = *pDevice;
+    data->physical_device = physicalDevice;
     data->instance_data = inst_data;
     data->dispatch.GetDeviceProcAddr = fpGetDeviceProcAddr;
 
@@ -272,13 +396,21 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
 
     LOAD_DEVICE_PROC(DestroyDevice);
     LOAD_DEVICE_PROC(GetDeviceQueue);
+    LOAD_DEVICE_PROC(GetDeviceQueue2);
+    LOAD_DEVICE_PROC(QueueSubmit);
+    LOAD_DEVICE_PROC(QueueSubmit2);
     LOAD_DEVICE_PROC(CreateSwapchainKHR);
     LOAD_DEVICE_PROC(DestroySwapchainKHR);
     LOAD_DEVICE_PROC(QueuePresentKHR);
     LOAD_DEVICE_PROC(AcquireNextImageKHR);
+    LOAD_DEVICE_PROC(AcquireNextImage2KHR);
 
 #undef LOAD_DEVICE_PROC
 
+    if (!data->dispatch.QueueSubmit2) {
+        data->dispatch.QueueSubmit2 = (PFN_vkQueueSubmit2)fpGetDeviceProcAddr(*pDevice, "vkQueueSubmit2KHR");
+    }
+
     // Store GPU name and notify daemon
     VkPhysicalDeviceProperties props;
     inst_data->dispatch.GetPhysicalDeviceProperties(physicalDevice, &props);
@@ -288,45 +420,40 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
     // Check for present timing extension support
     data->present_timing_supported = false;
     data->present_timing_type = PRESENT_TIMING_NONE;
-    bool has_ext_present_timing = false;
-    bool has_google_display_timing = false;
-
-    uint32_t ext_count = 0;
-    if (inst_data->dispatch.EnumerateDeviceExtensionProperties) {
-        inst_data->dispatch.EnumerateDeviceExtensionProperties(physicalDevice, NULL, &ext_count, NULL);
-        if (ext_count > 0) {
-            VkExtensionProperties* exts = malloc(ext_count * sizeof(VkExtensionProperties));
-            if (exts) {
-                inst_data->dispatch.EnumerateDeviceExtensionProperties(physicalDevice, NULL, &ext_count, exts);
-                for (uint32_t i = 0; i < ext_count; i++) {
-                    if (strcmp(exts[i].extensionName, "VK_EXT_present_timing") == 0) {
-                        has_ext_present_timing = true;
-                    }
-                    if (strcmp(exts[i].extensionName, "VK_GOOGLE_display_timing") == 0) {
-                        has_google_display_timing = true;
-                    }
-                }
-                free(exts);
-            }
+    data->google_display_timing_enabled = google_display_timing_enabled;
+
+    // Load present timing functions for the extensions enabled above. The EXT
+    // path is preferred - it reports per-stage times and calibrated domains.
+    if (use_ext_timing) {
+#define LOAD_EXT_PROC(name) \
+        data->dispatch.name = (PFN_vk##name)fpGetDeviceProcAddr(*pDevice, "vk" #name)
+
+        LOAD_EXT_PROC(GetPastPresentationTimingEXT);
+        LOAD_EXT_PROC(SetSwapchainPresentTimingQueueSizeEXT);
+        LOAD_EXT_PROC(GetSwapchainTimeDomainPropertiesEXT);
+        LOAD_EXT_PROC(GetSwapchainTimingPropertiesEXT);
+        LOAD_EXT_PROC(GetCalibratedTimestampsKHR);
+        if (!data->dispatch.GetCalibratedTimestampsKHR) {
+            data->dispatch.GetCalibratedTimestampsKHR =
+                (PFN_vkGetCalibratedTimestampsKHR)fpGetDeviceProcAddr(*pDevice, "vkGetCalibratedTimestampsEXT");
         }
-    }
 
-    // Load present timing functions if extension is enabled by the application
-    // Note: We can't enable extensions ourselves - application must request them
-    // But we can load the functions if they're available
-    if (has_ext_present_timing) {
-        data->dispatch.GetPastPresentationTimingEXT =
-            (PFN_vkGetPastPresentationTimingEXT)fpGetDeviceProcAddr(*pDevice, "vkGetPastPresentationTimingEXT");
-        if (data->dispatch.GetPastPresentationTimingEXT) {
+#undef LOAD_EXT_PROC
+
+        if (data->dispatch.GetPastPresentationTimingEXT &&
+            data->dispatch.SetSwapchainPresentTimingQueueSizeEXT &&
+            data->dispatch.GetSwapchainTimeDomainPropertiesEXT) {
             data->present_timing_supported = true;
             data->present_timing_type = PRESENT_TIMING_EXT;
             fprintf(stderr, "[CapFrameX Layer] VK_EXT_present_timing extension active\n");
         }
     }
 
-    if (!data->present_timing_supported && has_google_display_timing) {
+    if (!data->present_timing_supported && google_display_timing_enabled) {
         data->dispatch.GetPastPresentationTimingGOOGLE =
             (PFN_vkGetPastPresentationTimingGOOGLE)fpGetDeviceProcAddr(*pDevice, "vkGetPastPresentationTimingGOOGLE");
+        data->dispatch.GetRefreshCycleDurationGOOGLE =
+            (PFN_vkGetRefreshCycleDurationGOOGLE)fpGetDeviceProcAddr(*pDevice, "vkGetRefreshCycleDurationGOOGLE");
         if (data->dispatch.GetPastPresentationTimingGOOGLE) {
             data->present_timing_supported = true;
             data->present_timing_type = PRESENT_TIMING_GOOGLE;
@@ -334,13 +461,23 @@ static VKAPI_ATTR VkResult VKAPI_CALL layer_CreateDevice(
         }
     }
 
-    if (!data->present_timing_supported) {
+    if (capture && !data->present_timing_supported) {
         fprintf(stderr, "[CapFrameX Layer] No present timing extension available - using CPU timestamps\n");
     }
 
     // Update IPC with GPU info and send updated hello
-    ipc_client_set_gpu_name(inst_data->gpu_name);
-    ipc_client_send_hello(inst_data->gpu_name, data->present_timing_supported);
+    if (capture) {
+        ipc_client_set_gpu_name(inst_data->gpu_name);
+        ipc_client_send_hello(inst_data->gpu_name, data->present_timing_supported);
+    }
+
+    // Submit hooks cost every submit, so they are opt-in on top of full capture
+    if (layer_initial_capture_tier() == CAPTURE_TIER_FULL && gpu_timing_requested()) {
+        data->gpu_timing = gpu_timing_create(data, fpGetDeviceProcAddr, fpSetDeviceLoaderData);
+        if (!data->gpu_timing) {
+            fprintf(stderr, "[CapFrameX Layer] GPU timing unavailable on this device\n");
+        }
+    }
 
     layer_store_device_data(*pDevice, data);
 
@@ -359,11 +496,75 @@ static VKAPI_ATTR void VKAPI_CALL layer_DestroyDevice(
     DeviceData* data = layer_get_device_data(device);
     if (data) {
         swapchain_cleanup_device(data);
+        gpu_timing_destroy(data->gpu_timing);
         data->dispatch.DestroyDevice(device, pAllocator);
         layer_remove_device_data(device);
     }
 }
 
+static VKAPI_ATTR void VKAPI_CALL layer_GetDeviceQueue(
+    VkDevice device,
+    uint32_t queueFamilyIndex,
+    uint32_t queueIndex,
+    VkQueue* pQueue)
+{
+    DeviceData* data = layer_get_device_data(device);
+    if (!data) {
+        *pQueue = VK_NULL_HANDLE;
+        return;
+    }
+
+    data->dispatch.GetDeviceQueue(device, queueFamilyIndex, queueIndex, pQueue);
+    gpu_timing_register_queue(data->gpu_timing, *pQueue, queueFamilyIndex);
+}
+
+static VKAPI_ATTR void VKAPI_CALL layer_GetDeviceQueue2(
+    VkDevice device,
+    const VkDeviceQueueInfo2* pQueueInfo,
+    VkQueue* pQueue)
+{
+    DeviceData* data = layer_get_device_data(device);
+    if (!data || !data->dispatch.GetDeviceQueue2) {
+        *pQueue = VK_NULL_HANDLE;
+        return;
+    }
+
+    data->dispatch.GetDeviceQueue2(device, pQueueInfo, pQueue);
+    gpu_timing_register_queue(data->gpu_timing, *pQueue, pQueueInfo->queueFamilyIndex);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL layer_QueueSubmit(
+    VkQueue queue,
+    uint32_t submitCount,
+    const VkSubmitInfo* pSubmits,
+    VkFence fence)
+{
+    DeviceData* data = layer_get_queue_device_data(queue);
+    if (!data) {
+        return VK_ERROR_DEVICE_LOST;
+    }
+    if (layer_capture_tier() != CAPTURE_TIER_FULL) {
+        return data->dispatch.QueueSubmit(queue, submitCount, pSubmits, fence);
+    }
+    return gpu_timing_queue_submit(data, queue, submitCount, pSubmits, fence);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL layer_QueueSubmit2(
+    VkQueue queue,
+    uint32_t submitCount,
+    const VkSubmitInfo2* pSubmits,
+    VkFence fence)
+{
+    DeviceData* data = layer_get_queue_device_data(queue);
+    if (!data || !data->dispatch.QueueSubmit2) {
+        return VK_ERROR_DEVICE_LOST;
+    }
+    if (layer_capture_tier() != CAPTURE_TIER_FULL) {
+        return data->dispatch.QueueSubmit2(queue, submitCount, pSubmits, fence);
+    }
+    return gpu_timing_queue_submit2(data, queue, submitCount, pSubmits, fence);
+}
+
 // Layer entry points
 
 VK_LAYER_EXPORT VKAPI_ATTR VkResult VKAPI_CALL vkNegotiateLoaderLayerInterfaceVersion(
@@ -405,12 +606,23 @@ VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL layer_GetInstanceProcAd
         return (PFN_vkVoidFunction)layer_GetDeviceProcAddr;
     if (strcmp(pName, "vkDestroyDevice") == 0)
         return (PFN_vkVoidFunction)layer_DestroyDevice;
-    if (strcmp(pName, "vkCreateSwapchainKHR") == 0)
-        return (PFN_vkVoidFunction)layer_CreateSwapchainKHR;
-    if (strcmp(pName, "vkDestroySwapchainKHR") == 0)
-        return (PFN_vkVoidFunction)layer_DestroySwapchainKHR;
-    if (strcmp(pName, "vkQueuePresentKHR") == 0)
-        return (PFN_vkVoidFunction)layer_QueuePresentKHR;
+
+    // With capture off everything else goes straight to the next layer
+    if (layer_initial_capture_tier() != CAPTURE_TIER_OFF) {
+        if (strcmp(pName, "vkCreateSwapchainKHR") == 0)
+            return (PFN_vkVoidFunction)layer_CreateSwapchainKHR;
+        if (strcmp(pName, "vkDestroySwapchainKHR") == 0)
+            return (PFN_vkVoidFunction)layer_DestroySwapchainKHR;
+        if (strcmp(pName, "vkQueuePresentKHR") == 0)
+            return (PFN_vkVoidFunction)layer_QueuePresentKHR;
+        if (strcmp(pName, "vkAcquireNextImageKHR") == 0)
+            return (PFN_vkVoidFunction)layer_AcquireNextImageKHR;
+        if (strcmp(pName, "vkAcquireNextImage2KHR") == 0)
+            return (PFN_vkVoidFunction)layer_AcquireNextImage2KHR;
+    }
+
+    // Queue and submit hooks depend on the device (GPU timing on, next layer
+    // exposes the function), so only layer_GetDeviceProcAddr hands them out
 
     // Pass through to next layer
     InstanceData* data = layer_get_instance_data(instance);
@@ -429,14 +641,37 @@ VK_LAYER_EXPORT VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL layer_GetDeviceProcAddr
         return (PFN_vkVoidFunction)layer_GetDeviceProcAddr;
     if (strcmp(pName, "vkDestroyDevice") == 0)
         return (PFN_vkVoidFunction)layer_DestroyDevice;
-    if (strcmp(pName, "vkCreateSwapchainKHR") == 0)
-        return (PFN_vkVoidFunction)layer_CreateSwapchainKHR;
-    if (strcmp(pName, "vkDestroySwapchainKHR") == 0)
-        return (PFN_vkVoidFunction)layer_DestroySwapchainKHR;
-    if (strcmp(pName, "vkQueuePresentKHR") == 0)
-        return (PFN_vkVoidFunction)layer_QueuePresentKHR;
+
+    // With capture off the application calls the next layer's
+    // vkQueuePresentKHR (and everything else) directly
+    if (layer_initial_capture_tier() != CAPTURE_TIER_OFF) {
+        if (strcmp(pName, "vkCreateSwapchainKHR") == 0)
+            return (PFN_vkVoidFunction)layer_CreateSwapchainKHR;
+        if (strcmp(pName, "vkDestroySwapchainKHR") == 0)
+            return (PFN_vkVoidFunction)layer_DestroySwapchainKHR;
+        if (strcmp(pName, "vkQueuePresentKHR") == 0)
+            return (PFN_vkVoidFunction)layer_QueuePresentKHR;
+        if (strcmp(pName, "vkAcquireNextImageKHR") == 0)
+            return (PFN_vkVoidFunction)layer_AcquireNextImageKHR;
+        if (strcmp(pName, "vkAcquireNextImage2KHR") == 0)
+            return (PFN_vkVoidFunction)layer_AcquireNextImage2KHR;
+    }
 
     DeviceData* data = layer_get_device_data(device);
+
+    // Queue and submit hooks only cost time when GPU timing is on
+    if (data && data->gpu_timing) {
+        if (strcmp(pName, "vkGetDeviceQueue") == 0)
+            return (PFN_vkVoidFunction)layer_GetDeviceQueue;
+        if (strcmp(pName, "vkGetDeviceQueue2") == 0 && data->dispatch.GetDeviceQueue2)
+            return (PFN_vkVoidFunction)layer_GetDeviceQueue2;
+        if (strcmp(pName, "vkQueueSubmit") == 0)
+            return (PFN_vkVoidFunction)layer_QueueSubmit;
+        if ((strcmp(pName, "vkQueueSubmit2") == 0 || strcmp(pName, "vkQueueSubmit2KHR") == 0) &&
+            data->dispatch.QueueSubmit2)
+            return (PFN_vkVoidFunction)layer_QueueSubmit2;
+    }
+
     if (data) {
         return data->dispatch.GetDeviceProcAddr(device, pName);
     }
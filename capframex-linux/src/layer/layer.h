@@ -6,6 +6,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../daemon/common.h"
+#include "capture_tier.h"
+
 #define LAYER_NAME "VK_LAYER_capframex_capture"
 #define LAYER_DESCRIPTION "CapFrameX Frametime Capture Layer"
 #define LAYER_VERSION 1
@@ -23,6 +26,8 @@ typedef struct {
     PFN_vkGetPhysicalDeviceProperties GetPhysicalDeviceProperties;
     PFN_vkEnumerateDeviceExtensionProperties EnumerateDeviceExtensionProperties;
     PFN_vkGetPhysicalDeviceQueueFamilyProperties GetPhysicalDeviceQueueFamilyProperties;
+    PFN_vkGetPhysicalDeviceFeatures2 GetPhysicalDeviceFeatures2;
+    PFN_vkGetPhysicalDeviceSurfaceCapabilities2KHR GetPhysicalDeviceSurfaceCapabilities2KHR;
 } InstanceDispatch;
 
 // Device dispatch table
@@ -30,14 +35,24 @@ typedef struct {
     PFN_vkGetDeviceProcAddr GetDeviceProcAddr;
     PFN_vkDestroyDevice DestroyDevice;
     PFN_vkGetDeviceQueue GetDeviceQueue;
+    PFN_vkGetDeviceQueue2 GetDeviceQueue2;
+    PFN_vkQueueSubmit QueueSubmit;
+    PFN_vkQueueSubmit2 QueueSubmit2;
     PFN_vkCreateSwapchainKHR CreateSwapchainKHR;
     PFN_vkDestroySwapchainKHR DestroySwapchainKHR;
     PFN_vkQueuePresentKHR QueuePresentKHR;
     PFN_vkAcquireNextImageKHR AcquireNextImageKHR;
+    PFN_vkAcquireNextImage2KHR AcquireNextImage2KHR;
     // VK_GOOGLE_display_timing (simpler API, widely supported)
     PFN_vkGetPastPresentationTimingGOOGLE GetPastPresentationTimingGOOGLE;
+    PFN_vkGetRefreshCycleDurationGOOGLE GetRefreshCycleDurationGOOGLE;
     // VK_EXT_present_timing (newer standardized extension)
     PFN_vkGetPastPresentationTimingEXT GetPastPresentationTimingEXT;
+    PFN_vkSetSwapchainPresentTimingQueueSizeEXT SetSwapchainPresentTimingQueueSizeEXT;
+    PFN_vkGetSwapchainTimeDomainPropertiesEXT GetSwapchainTimeDomainPropertiesEXT;
+    PFN_vkGetSwapchainTimingPropertiesEXT GetSwapchainTimingPropertiesEXT;  // Optional, for the refresh duration
+    // VK_KHR/EXT_calibrated_timestamps (maps present timing domains to CLOCK_MONOTONIC)
+    PFN_vkGetCalibratedTimestampsKHR GetCalibratedTimestampsKHR;
 } DeviceDispatch;
 
 // Per-instance data
@@ -55,24 +70,31 @@ typedef enum {
     PRESENT_TIMING_EXT = 2,     // VK_EXT_present_timing
 } PresentTimingType;
 
+typedef struct GpuTimingDevice GpuTimingDevice;
+
 // Per-device data
 typedef struct {
     VkDevice device;
+    VkPhysicalDevice physical_device;
     DeviceDispatch dispatch;
     InstanceData* instance_data;
     VkQueue present_queue;
     uint32_t present_queue_family;
     bool present_timing_supported;  // Any present timing extension available
     PresentTimingType present_timing_type;  // Which extension is active
+    bool google_display_timing_enabled;     // VK_GOOGLE_display_timing enabled on the device
+    GpuTimingDevice* gpu_timing;            // Injected GPU timestamps, NULL unless requested and loaded as full
 } DeviceData;
 
 // Layer initialization/cleanup
 void layer_init(void);
 void layer_cleanup(void);
 
-// Get dispatch tables
+// Get dispatch tables (lock-free, keyed by loader dispatch pointer)
 InstanceData* layer_get_instance_data(VkInstance instance);
+InstanceData* layer_get_physical_device_instance_data(VkPhysicalDevice physical_device);
 DeviceData* layer_get_device_data(VkDevice device);
+DeviceData* layer_get_queue_device_data(VkQueue queue);
 
 // Store dispatch tables
 void layer_store_instance_data(VkInstance instance, InstanceData* data);
@@ -82,4 +104,14 @@ void layer_store_device_data(VkDevice device, DeviceData* data);
 void layer_remove_instance_data(VkInstance instance);
 void layer_remove_device_data(VkDevice device);
 
+// Find a structure in a pNext chain, NULL if absent
+static inline const void* layer_find_in_chain(const void* pNext, VkStructureType type) {
+    for (const VkBaseInStructure* s = pNext; s; s = s->pNext) {
+        if (s->sType == type) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
 #endif // CAPFRAMEX_LAYER_H
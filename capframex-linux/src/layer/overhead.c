@@ -0,0 +1,92 @@
+#include "overhead.h"
+
+#include <stdatomic.h>
+
+// Linear sub-buckets per power of two
+#define OVERHEAD_SUB_BITS 3
+#define OVERHEAD_SUB_COUNT (1u << OVERHEAD_SUB_BITS)
+
+// Values are clamped to 2^32-1 ns (~4.3 s)
+#define OVERHEAD_MAX_BITS 32
+#define OVERHEAD_BUCKET_COUNT ((OVERHEAD_MAX_BITS - OVERHEAD_SUB_BITS + 1) * OVERHEAD_SUB_COUNT)
+
+static _Atomic uint64_t buckets[OVERHEAD_BUCKET_COUNT];
+static _Atomic uint64_t total_ns = 0;
+static _Atomic uint32_t max_ns = 0;
+
+// Values below OVERHEAD_SUB_COUNT map 1:1, above that the top
+// OVERHEAD_SUB_BITS bits below the leading one select the sub-bucket
+static uint32_t bucket_index(uint32_t value) {
+    if (value < OVERHEAD_SUB_COUNT) {
+        return value;
+    }
+    uint32_t msb = 31u - (uint32_t)__builtin_clz(value);
+    uint32_t shift = msb - OVERHEAD_SUB_BITS;
+    return (shift + 1) * OVERHEAD_SUB_COUNT + ((value >> shift) & (OVERHEAD_SUB_COUNT - 1));
+}
+
+// Largest value that falls into a bucket
+static uint32_t bucket_upper_bound(uint32_t index) {
+    if (index < OVERHEAD_SUB_COUNT) {
+        return index;
+    }
+    uint32_t shift = index / OVERHEAD_SUB_COUNT - 1;
+    uint64_t lower = (uint64_t)(OVERHEAD_SUB_COUNT + index % OVERHEAD_SUB_COUNT) << shift;
+    uint64_t upper = lower + (1ull << shift) - 1;
+    return upper > UINT32_MAX ? UINT32_MAX : (uint32_t)upper;
+}
+
+void overhead_record(uint64_t overhead_ns) {
+    uint32_t value = overhead_ns > UINT32_MAX ? UINT32_MAX : (uint32_t)overhead_ns;
+
+    atomic_fetch_add_explicit(&buckets[bucket_index(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_ns, value, memory_order_relaxed);
+
+    uint32_t current = atomic_load_explicit(&max_ns, memory_order_relaxed);
+    while (value > current &&
+           !atomic_compare_exchange_weak_explicit(&max_ns, &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+bool overhead_get_stats(OverheadStats* out) {
+    // Buckets are read one by one while presents keep recording; the
+    // snapshot may be a few samples off, which doesn't matter here
+    uint64_t counts[OVERHEAD_BUCKET_COUNT];
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < OVERHEAD_BUCKET_COUNT; i++) {
+        counts[i] = atomic_load_explicit(&buckets[i], memory_order_relaxed);
+        count += counts[i];
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    uint32_t max = atomic_load_explicit(&max_ns, memory_order_relaxed);
+    const uint64_t ranks[4] = {
+        (count * 500 + 999) / 1000,
+        (count * 900 + 999) / 1000,
+        (count * 990 + 999) / 1000,
+        (count * 999 + 999) / 1000
+    };
+    uint32_t percentiles[4] = { 0 };
+
+    uint64_t seen = 0;
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < OVERHEAD_BUCKET_COUNT && next < 4; i++) {
+        seen += counts[i];
+        while (next < 4 && seen >= ranks[next]) {
+            uint32_t bound = bucket_upper_bound(i);
+            percentiles[next++] = bound < max ? bound : max;
+        }
+    }
+
+    out->sample_count = count;
+    out->p50_ns = percentiles[0];
+    out->p90_ns = percentiles[1];
+    out->p99_ns = percentiles[2];
+    out->p999_ns = percentiles[3];
+    out->max_ns = max;
+    out->mean_ns = (uint32_t)(atomic_load_explicit(&total_ns, memory_order_relaxed) / count);
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef CAPFRAMEX_OVERHEAD_H
+#define CAPFRAMEX_OVERHEAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Time the layer adds to each vkQueuePresentKHR (everything but the driver
+// call), kept in a per-process log-linear histogram: 8 linear buckets per
+// power of two, so a percentile is off by at most 12.5%. Recording is a few
+// relaxed atomic adds, safe from any thread.
+
+// Overhead percentiles since the layer was loaded
+typedef struct {
+    uint64_t sample_count;
+    uint32_t p50_ns;
+    uint32_t p90_ns;
+    uint32_t p99_ns;
+    uint32_t p999_ns;
+    uint32_t max_ns;
+    uint32_t mean_ns;
+} OverheadStats;
+
+// Add one present's overhead
+void overhead_record(uint64_t overhead_ns);
+
+// Summarize the histogram, false if nothing was recorded yet
+bool overhead_get_stats(OverheadStats* out);
+
+#endif // CAPFRAMEX_OVERHEAD_H
@@ -1,81 +1,151 @@
 #include "swapchain.h"
 #include "timing.h"
 #include "ipc_client.h"
+#include "handle_map.h"
+#include "gpu_timing.h"
+#include "overhead.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <pthread.h>
+#include <stdatomic.h>
 #include <unistd.h>
+#include <time.h>
+
+// Swapchains by handle (see handle_map.h). SwapchainData is heap allocated
+// and only touched by the thread presenting/destroying that swapchain, which
+// Vulkan requires the application to externally synchronize.
+static HandleMap swapchain_map = HANDLE_MAP_INITIALIZER;
+
+// Swapchain ids are never reused within the process, so frames of a
+// recreated swapchain can't be mistaken for the old one's
+static _Atomic uint32_t next_swapchain_id = 1;
+
+// Non-dispatchable handles are pointers on 64-bit and uint64_t on 32-bit
+#if defined(__LP64__)
+#define SWAPCHAIN_KEY(sc) ((uint64_t)(uintptr_t)(sc))
+#else
+#define SWAPCHAIN_KEY(sc) ((uint64_t)(sc))
+#endif
+
+// Record frames in present order. With wait_for_display/wait_for_gpu, stops
+// at the first frame still waiting for display timing/GPU active time unless
+// it has waited PRESENT_MAX_PENDING presents.
+static void record_ready_frames(SwapchainData* sc, bool wait_for_display, bool wait_for_gpu) {
+    while (sc->next_record_frame <= sc->frame_count) {
+        PresentHistoryEntry* entry = &sc->history[sc->next_record_frame % PRESENT_HISTORY_SIZE];
+
+        bool pending = (wait_for_display && !entry->resolved) || (wait_for_gpu && entry->gpu_pending);
+        if (pending && sc->frame_count - entry->times.frame_number < PRESENT_MAX_PENDING) {
+            break;
+        }
+
+        timing_record_frame(sc->timing, &entry->times);
+
+        sc->next_record_frame++;
+    }
+}
 
-static SwapchainData swapchain_list[MAX_SWAPCHAINS];
-static int swapchain_count = 0;
-static pthread_mutex_t swapchain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void free_swapchain(SwapchainData* sc) {
+    // Flush frames still waiting for display timing
+    record_ready_frames(sc, false, false);
+    timing_context_destroy(sc->timing);
+    free(sc);
+}
 
 void swapchain_init_device(DeviceData* device_data) {
     (void)device_data;
     // Per-device initialization if needed
 }
 
+typedef struct {
+    VkDevice device;
+    uint64_t* keys;
+    uint32_t count;
+    uint32_t capacity;
+} DeviceSwapchainKeys;
+
+static void collect_device_swapchain(uint64_t key, void* value, void* ctx) {
+    DeviceSwapchainKeys* collected = ctx;
+    SwapchainData* sc = value;
+    if (sc->device != collected->device) return;
+
+    if (collected->count == collected->capacity) {
+        uint32_t capacity = collected->capacity ? collected->capacity * 2 : 8;
+        uint64_t* keys = realloc(collected->keys, capacity * sizeof(uint64_t));
+        if (!keys) return;
+        collected->keys = keys;
+        collected->capacity = capacity;
+    }
+    collected->keys[collected->count++] = key;
+}
+
 void swapchain_cleanup_device(DeviceData* device_data) {
-    pthread_mutex_lock(&swapchain_mutex);
-    for (int i = swapchain_count - 1; i >= 0; i--) {
-        if (swapchain_list[i].device == device_data->device) {
-            for (int j = i; j < swapchain_count - 1; j++) {
-                swapchain_list[j] = swapchain_list[j + 1];
-            }
-            swapchain_count--;
-        }
+    // Swapchains the application leaked before destroying the device
+    DeviceSwapchainKeys collected = { .device = device_data->device };
+    handle_map_for_each(&swapchain_map, collect_device_swapchain, &collected);
+
+    for (uint32_t i = 0; i < collected.count; i++) {
+        SwapchainData* sc = handle_map_remove(&swapchain_map, collected.keys[i]);
+        if (sc) free_swapchain(sc);
     }
-    pthread_mutex_unlock(&swapchain_mutex);
+    free(collected.keys);
 }
 
 SwapchainData* swapchain_get_data(VkSwapchainKHR swapchain) {
-    pthread_mutex_lock(&swapchain_mutex);
-    for (int i = 0; i < swapchain_count; i++) {
-        if (swapchain_list[i].swapchain == swapchain) {
-            pthread_mutex_unlock(&swapchain_mutex);
-            return &swapchain_list[i];
-        }
+    return handle_map_get(&swapchain_map, SWAPCHAIN_KEY(swapchain));
+}
+
+typedef struct {
+    SwapchainData* found;
+} ActiveSwapchainSearch;
+
+static void find_active_swapchain(uint64_t key, void* value, void* ctx) {
+    (void)key;
+    ActiveSwapchainSearch* search = ctx;
+    SwapchainData* sc = value;
+    fprintf(stderr, "[CapFrameX Layer] DEBUG: swapchain %p: active=%d, width=%u, height=%u\n",
+            (void*)sc, sc->active, sc->width, sc->height);
+    if (!search->found && sc->active && sc->width > 0) {
+        search->found = sc;
     }
-    pthread_mutex_unlock(&swapchain_mutex);
-    return NULL;
 }
 
 bool swapchain_get_active_info(uint32_t* width, uint32_t* height,
                                 uint32_t* format, uint32_t* image_count) {
-    pthread_mutex_lock(&swapchain_mutex);
-    fprintf(stderr, "[CapFrameX Layer] DEBUG: swapchain_get_active_info called, swapchain_count=%d\n", swapchain_count);
-    for (int i = 0; i < swapchain_count; i++) {
-        fprintf(stderr, "[CapFrameX Layer] DEBUG: swapchain[%d]: active=%d, width=%u, height=%u\n",
-                i, swapchain_list[i].active, swapchain_list[i].width, swapchain_list[i].height);
-        if (swapchain_list[i].active && swapchain_list[i].width > 0) {
-            *width = swapchain_list[i].width;
-            *height = swapchain_list[i].height;
-            *format = (uint32_t)swapchain_list[i].format;
-            *image_count = swapchain_list[i].image_count;
-            fprintf(stderr, "[CapFrameX Layer] DEBUG: Found active swapchain: %ux%u\n", *width, *height);
-            pthread_mutex_unlock(&swapchain_mutex);
-            return true;
-        }
+    fprintf(stderr, "[CapFrameX Layer] DEBUG: swapchain_get_active_info called, swapchain_count=%u\n",
+            handle_map_count(&swapchain_map));
+
+    ActiveSwapchainSearch search = { NULL };
+    handle_map_for_each(&swapchain_map, find_active_swapchain, &search);
+
+    if (search.found) {
+        *width = search.found->width;
+        *height = search.found->height;
+        *format = (uint32_t)search.found->format;
+        *image_count = search.found->image_count;
+        fprintf(stderr, "[CapFrameX Layer] DEBUG: Found active swapchain: %ux%u\n", *width, *height);
+        return true;
     }
     fprintf(stderr, "[CapFrameX Layer] DEBUG: No active swapchain found\n");
-    pthread_mutex_unlock(&swapchain_mutex);
     return false;
 }
 
 static SwapchainData* add_swapchain(VkDevice device, VkSwapchainKHR swapchain,
                                      const VkSwapchainCreateInfoKHR* info) {
-    pthread_mutex_lock(&swapchain_mutex);
-
-    if (swapchain_count >= MAX_SWAPCHAINS) {
-        pthread_mutex_unlock(&swapchain_mutex);
-        fprintf(stderr, "[CapFrameX Layer] Max swapchains reached\n");
+    SwapchainData* data = calloc(1, sizeof(SwapchainData));
+    if (!data) {
+        fprintf(stderr, "[CapFrameX Layer] Out of memory tracking swapchain\n");
         return NULL;
     }
 
-    SwapchainData* data = &swapchain_list[swapchain_count];
-    memset(data, 0, sizeof(SwapchainData));
+    data->id = atomic_fetch_add(&next_swapchain_id, 1);
+    data->timing = timing_context_create(data->id);
+    if (!data->timing) {
+        fprintf(stderr, "[CapFrameX Layer] Out of memory tracking swapchain\n");
+        free(data);
+        return NULL;
+    }
 
     data->swapchain = swapchain;
     data->device = device;
@@ -84,35 +154,199 @@ static SwapchainData* add_swapchain(VkDevice device, VkSwapchainKHR swapchain,
     data->format = info->imageFormat;
     data->image_count = info->minImageCount;
     data->frame_count = 0;
+    data->next_record_frame = 1;  // Frame numbers start at 1
     data->active = true;
+    data->capture_generation = layer_capture_generation();
 
-    swapchain_count++;
-
-    pthread_mutex_unlock(&swapchain_mutex);
+    if (!handle_map_put(&swapchain_map, SWAPCHAIN_KEY(swapchain), data)) {
+        fprintf(stderr, "[CapFrameX Layer] Out of memory tracking swapchain\n");
+        timing_context_destroy(data->timing);
+        free(data);
+        return NULL;
+    }
 
-    fprintf(stderr, "[CapFrameX Layer] Swapchain created: %ux%u\n",
-            data->width, data->height);
+    fprintf(stderr, "[CapFrameX Layer] Swapchain %u created: %ux%u\n",
+            data->id, data->width, data->height);
 
     return data;
 }
 
 static void remove_swapchain(VkSwapchainKHR swapchain) {
-    pthread_mutex_lock(&swapchain_mutex);
+    SwapchainData* data = handle_map_remove(&swapchain_map, SWAPCHAIN_KEY(swapchain));
+    if (data) {
+        fprintf(stderr, "[CapFrameX Layer] Swapchain destroyed after %lu frames\n",
+                (unsigned long)data->frame_count);
+        free_swapchain(data);
+    }
+}
 
-    for (int i = 0; i < swapchain_count; i++) {
-        if (swapchain_list[i].swapchain == swapchain) {
-            fprintf(stderr, "[CapFrameX Layer] Swapchain destroyed after %lu frames\n",
-                    (unsigned long)swapchain_list[i].frame_count);
+// Offset from a swapchain time domain to CLOCK_MONOTONIC
+static bool calibrate_time_domain(DeviceData* dev_data, SwapchainData* sc, uint64_t now_ns) {
+    switch (sc->time_domain) {
+    case VK_TIME_DOMAIN_CLOCK_MONOTONIC_KHR:
+        sc->time_domain_offset_ns = 0;
+        break;
+
+    case VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_KHR: {
+        // Both clocks are readable here - bracket a MONOTONIC read with RAW reads
+        struct timespec raw_before, mono, raw_after;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &raw_before);
+        clock_gettime(CLOCK_MONOTONIC, &mono);
+        clock_gettime(CLOCK_MONOTONIC_RAW, &raw_after);
+        uint64_t raw_ns = ((uint64_t)raw_before.tv_sec * 1000000000ULL + (uint64_t)raw_before.tv_nsec +
+                           (uint64_t)raw_after.tv_sec * 1000000000ULL + (uint64_t)raw_after.tv_nsec) / 2;
+        uint64_t mono_ns = (uint64_t)mono.tv_sec * 1000000000ULL + (uint64_t)mono.tv_nsec;
+        sc->time_domain_offset_ns = (int64_t)(mono_ns - raw_ns);
+        break;
+    }
 
-            for (int j = i; j < swapchain_count - 1; j++) {
-                swapchain_list[j] = swapchain_list[j + 1];
-            }
-            swapchain_count--;
+    case VK_TIME_DOMAIN_SWAPCHAIN_LOCAL_EXT: {
+        if (!dev_data->dispatch.GetCalibratedTimestampsKHR) {
+            return false;
+        }
+        VkSwapchainCalibratedTimestampInfoEXT swapchain_info = {
+            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CALIBRATED_TIMESTAMP_INFO_EXT,
+            .swapchain = sc->swapchain,
+            .timeDomainId = sc->time_domain_id
+        };
+        VkCalibratedTimestampInfoKHR infos[2] = {
+            { .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_KHR,
+              .pNext = &swapchain_info, .timeDomain = sc->time_domain },
+            { .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_KHR,
+              .timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_KHR },
+        };
+        uint64_t timestamps[2];
+        uint64_t max_deviation;
+        if (dev_data->dispatch.GetCalibratedTimestampsKHR(dev_data->device, 2, infos,
+                                                          timestamps, &max_deviation) != VK_SUCCESS) {
+            return false;
+        }
+        sc->time_domain_offset_ns = (int64_t)(timestamps[1] - timestamps[0]);
+        break;
+    }
+
+    default:
+        return false;
+    }
+
+    sc->last_calibration_ns = now_ns;
+    return true;
+}
+
+// Pick the time domain results are reported in, preferring CLOCK_MONOTONIC
+// (our own timestamps) so no calibration is needed
+static bool select_time_domain(DeviceData* dev_data, SwapchainData* sc) {
+    VkTimeDomainKHR domains[PRESENT_TIME_DOMAIN_MAX];
+    uint64_t domain_ids[PRESENT_TIME_DOMAIN_MAX];
+    VkSwapchainTimeDomainPropertiesEXT props = {
+        .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_TIME_DOMAIN_PROPERTIES_EXT,
+        .timeDomainCount = PRESENT_TIME_DOMAIN_MAX,
+        .pTimeDomains = domains,
+        .pTimeDomainIds = domain_ids
+    };
+    uint64_t counter = 0;
+    VkResult result = dev_data->dispatch.GetSwapchainTimeDomainPropertiesEXT(
+        dev_data->device, sc->swapchain, &props, &counter);
+    if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+        return false;
+    }
+
+    int best = -1;
+    int best_rank = 0;
+    for (uint32_t i = 0; i < props.timeDomainCount && i < PRESENT_TIME_DOMAIN_MAX; i++) {
+        int rank = 0;
+        switch (domains[i]) {
+        case VK_TIME_DOMAIN_CLOCK_MONOTONIC_KHR:     rank = 3; break;
+        case VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_KHR: rank = 2; break;
+        case VK_TIME_DOMAIN_SWAPCHAIN_LOCAL_EXT:
+            rank = dev_data->dispatch.GetCalibratedTimestampsKHR ? 1 : 0;
+            break;
+        default:
+            // PRESENT_STAGE_LOCAL has one clock per stage - not worth calibrating
             break;
         }
+        if (rank > best_rank) {
+            best = (int)i;
+            best_rank = rank;
+        }
+    }
+
+    sc->time_domains_counter = counter;
+    if (best < 0) {
+        return false;
+    }
+
+    sc->time_domain = domains[best];
+    sc->time_domain_id = domain_ids[best];
+    return calibrate_time_domain(dev_data, sc, timing_get_timestamp());
+}
+
+// Present stages to query: queue completion (render complete) plus the
+// earliest display stage the surface reports
+static VkPresentStageFlagsEXT query_present_stages(DeviceData* dev_data, VkSurfaceKHR surface) {
+    // Every implementation supports QUEUE_OPERATIONS_END
+    VkPresentStageFlagsEXT stages = VK_PRESENT_STAGE_QUEUE_OPERATIONS_END_BIT_EXT;
+
+    InstanceData* inst_data = dev_data->instance_data;
+    if (!inst_data || !inst_data->dispatch.GetPhysicalDeviceSurfaceCapabilities2KHR) {
+        return stages;
+    }
+
+    VkPresentTimingSurfaceCapabilitiesEXT timing_caps = {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_TIMING_SURFACE_CAPABILITIES_EXT
+    };
+    VkSurfaceCapabilities2KHR caps = {
+        .sType = VK_STRUCTURE_TYPE_SURFACE_CAPABILITIES_2_KHR,
+        .pNext = &timing_caps
+    };
+    VkPhysicalDeviceSurfaceInfo2KHR surface_info = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SURFACE_INFO_2_KHR,
+        .surface = surface
+    };
+    if (inst_data->dispatch.GetPhysicalDeviceSurfaceCapabilities2KHR(
+            dev_data->physical_device, &surface_info, &caps) != VK_SUCCESS ||
+        !timing_caps.presentTimingSupported) {
+        return 0;
     }
 
-    pthread_mutex_unlock(&swapchain_mutex);
+    if (timing_caps.presentStageQueries & VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_OUT_BIT_EXT) {
+        stages |= VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_OUT_BIT_EXT;
+    } else if (timing_caps.presentStageQueries & VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_VISIBLE_BIT_EXT) {
+        stages |= VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_VISIBLE_BIT_EXT;
+    }
+    return stages & (timing_caps.presentStageQueries | VK_PRESENT_STAGE_QUEUE_OPERATIONS_END_BIT_EXT);
+}
+
+// Fixed refresh cycle of the swapchain's display (VK_EXT_present_timing).
+// Stays 0 if the driver doesn't know it yet, the properties counter triggers
+// a retry. With a variable refresh rate refreshDuration is only the shortest
+// cycle and refreshInterval differs from it, so it stays 0 then as well.
+static void update_refresh_duration_ext(DeviceData* dev_data, SwapchainData* sc) {
+    if (!dev_data->dispatch.GetSwapchainTimingPropertiesEXT) {
+        return;
+    }
+    VkSwapchainTimingPropertiesEXT props = { .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_TIMING_PROPERTIES_EXT };
+    uint64_t counter = 0;
+    if (dev_data->dispatch.GetSwapchainTimingPropertiesEXT(dev_data->device, sc->swapchain,
+                                                           &props, &counter) == VK_SUCCESS) {
+        sc->refresh_duration_ns = props.refreshInterval == props.refreshDuration ? props.refreshDuration : 0;
+    }
+}
+
+// Set up VK_EXT_present_timing on a swapchain the layer created with
+// VK_SWAPCHAIN_CREATE_PRESENT_TIMING_BIT_EXT
+static bool init_present_timing_ext(DeviceData* dev_data, SwapchainData* sc,
+                                    VkPresentStageFlagsEXT stages) {
+    if (dev_data->dispatch.SetSwapchainPresentTimingQueueSizeEXT(
+            dev_data->device, sc->swapchain, PRESENT_TIMING_QUEUE_SIZE) != VK_SUCCESS) {
+        return false;
+    }
+    if (!select_time_domain(dev_data, sc)) {
+        return false;
+    }
+    sc->present_stage_queries = stages;
+    update_refresh_duration_ext(dev_data, sc);
+    return true;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL layer_CreateSwapchainKHR(
@@ -129,11 +363,50 @@ VKAPI_ATTR VkResult VKAPI_CALL layer_CreateSwapchainKHR(
     fprintf(stderr, "[CapFrameX Layer] CreateSwapchainKHR called: %ux%u\n",
             pCreateInfo->imageExtent.width, pCreateInfo->imageExtent.height);
 
-    VkResult result = dev_data->dispatch.CreateSwapchainKHR(device, pCreateInfo,
+    // VK_EXT_present_timing is opt-in per swapchain. If the app opted in
+    // itself it owns the results queue, so leave the swapchain alone.
+    VkSwapchainCreateInfoKHR create_info = *pCreateInfo;
+    VkPresentStageFlagsEXT stages = 0;
+    if (dev_data->present_timing_type == PRESENT_TIMING_EXT &&
+        !(pCreateInfo->flags & VK_SWAPCHAIN_CREATE_PRESENT_TIMING_BIT_EXT)) {
+        stages = query_present_stages(dev_data, pCreateInfo->surface);
+        if (stages) {
+            create_info.flags |= VK_SWAPCHAIN_CREATE_PRESENT_TIMING_BIT_EXT |
+                                 VK_SWAPCHAIN_CREATE_PRESENT_ID_2_BIT_KHR;
+        }
+    }
+
+    VkResult result = dev_data->dispatch.CreateSwapchainKHR(device, &create_info,
                                                              pAllocator, pSwapchain);
+    if (result != VK_SUCCESS && stages) {
+        // Don't let our flags break swapchain creation - retry as requested
+        stages = 0;
+        result = dev_data->dispatch.CreateSwapchainKHR(device, pCreateInfo, pAllocator, pSwapchain);
+    }
+
     if (result == VK_SUCCESS) {
         fprintf(stderr, "[CapFrameX Layer] Swapchain created successfully\n");
-        add_swapchain(device, *pSwapchain, pCreateInfo);
+        SwapchainData* sc = add_swapchain(device, *pSwapchain, pCreateInfo);
+
+        if (sc && stages) {
+            if (init_present_timing_ext(dev_data, sc, stages)) {
+                sc->timing_type = PRESENT_TIMING_EXT;
+            } else {
+                fprintf(stderr, "[CapFrameX Layer] VK_EXT_present_timing unavailable on swapchain, using CPU timing\n");
+            }
+        } else if (sc && dev_data->present_timing_type == PRESENT_TIMING_GOOGLE) {
+            sc->timing_type = PRESENT_TIMING_GOOGLE;
+            // Only FIFO presents wait for the refresh grid. The reported cycle
+            // is the shortest one with VRR as well; classify_display stops
+            // counting repeats once display times show no fixed grid.
+            VkRefreshCycleDurationGOOGLE refresh = { 0 };
+            if ((pCreateInfo->presentMode == VK_PRESENT_MODE_FIFO_KHR ||
+                 pCreateInfo->presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR) &&
+                dev_data->dispatch.GetRefreshCycleDurationGOOGLE &&
+                dev_data->dispatch.GetRefreshCycleDurationGOOGLE(device, *pSwapchain, &refresh) == VK_SUCCESS) {
+                sc->refresh_duration_ns = refresh.refreshDuration;
+            }
+        }
 
         // Notify daemon of new swapchain
         ipc_client_send_swapchain_created(
@@ -164,101 +437,441 @@ VKAPI_ATTR void VKAPI_CALL layer_DestroySwapchainKHR(
     }
 }
 
-// Internal version without locking (caller must hold mutex)
-static SwapchainData* swapchain_get_data_unlocked(VkSwapchainKHR swapchain) {
-    for (int i = 0; i < swapchain_count; i++) {
-        if (swapchain_list[i].swapchain == swapchain) {
-            return &swapchain_list[i];
+// Remember when an image was acquired; its present attributes the time to
+// the frame (CPU waiting in acquire vs. working until present)
+static void record_acquire(VkSwapchainKHR swapchain, uint64_t start_ns, uint64_t end_ns,
+                           VkResult result, const uint32_t* pImageIndex) {
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        return;
+    }
+
+    SwapchainData* sc = swapchain_get_data(swapchain);
+    if (sc && *pImageIndex < SWAPCHAIN_MAX_TRACKED_IMAGES) {
+        sc->acquires[*pImageIndex].start_ns = start_ns;
+        sc->acquires[*pImageIndex].end_ns = end_ns;
+    }
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL layer_AcquireNextImageKHR(
+    VkDevice device,
+    VkSwapchainKHR swapchain,
+    uint64_t timeout,
+    VkSemaphore semaphore,
+    VkFence fence,
+    uint32_t* pImageIndex)
+{
+    DeviceData* dev_data = layer_get_device_data(device);
+    if (!dev_data || !dev_data->dispatch.AcquireNextImageKHR) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (layer_capture_tier() == CAPTURE_TIER_OFF) {
+        return dev_data->dispatch.AcquireNextImageKHR(device, swapchain, timeout,
+                                                      semaphore, fence, pImageIndex);
+    }
+
+    uint64_t start = timing_get_timestamp();
+    VkResult result = dev_data->dispatch.AcquireNextImageKHR(device, swapchain, timeout,
+                                                              semaphore, fence, pImageIndex);
+    record_acquire(swapchain, start, timing_get_timestamp(), result, pImageIndex);
+
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL layer_AcquireNextImage2KHR(
+    VkDevice device,
+    const VkAcquireNextImageInfoKHR* pAcquireInfo,
+    uint32_t* pImageIndex)
+{
+    DeviceData* dev_data = layer_get_device_data(device);
+    if (!dev_data || !dev_data->dispatch.AcquireNextImage2KHR) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (layer_capture_tier() == CAPTURE_TIER_OFF) {
+        return dev_data->dispatch.AcquireNextImage2KHR(device, pAcquireInfo, pImageIndex);
+    }
+
+    uint64_t start = timing_get_timestamp();
+    VkResult result = dev_data->dispatch.AcquireNextImage2KHR(device, pAcquireInfo, pImageIndex);
+    record_acquire(pAcquireInfo->swapchain, start, timing_get_timestamp(), result, pImageIndex);
+
+    return result;
+}
+
+// Most presents name one swapchain; present ID injection and the lookup
+// cache cover this many
+#define PRESENT_SWAPCHAIN_CACHE 8
+
+// A late frame shown further than refresh / this from a whole number of
+// refresh cycles after the previous one means the display has no fixed grid
+#define REFRESH_GRID_TOLERANCE_DIVISOR 10
+
+// Classify a frame the display reported. Earlier presents that expected a
+// report but have none were replaced before reaching the screen.
+static void classify_display(SwapchainData* sc, uint64_t frame, uint64_t displayed_ns) {
+    for (uint64_t skipped = sc->next_record_frame; skipped < frame; skipped++) {
+        PresentHistoryEntry* entry = &sc->history[skipped % PRESENT_HISTORY_SIZE];
+        if (entry->timing_expected && !entry->resolved) {
+            entry->resolved = true;
+            entry->times.display_state = FRAME_DISPLAY_DROPPED;
         }
     }
-    return NULL;
+
+    if (displayed_ns == 0) {
+        return;  // Reported without a usable display time
+    }
+
+    // Whole refreshes since the previous frame went up; each one past the
+    // first showed the previous frame again. Only a fixed refresh rate has
+    // such a grid: with VRR the display waits for the next frame instead, so
+    // a late frame off the grid turns classification off for the swapchain.
+    PresentHistoryEntry* entry = &sc->history[frame % PRESENT_HISTORY_SIZE];
+    entry->times.display_state = FRAME_DISPLAY_DISPLAYED;
+    if (sc->refresh_duration_ns > 0 && !sc->variable_refresh &&
+        sc->last_displayed_ns > 0 && displayed_ns > sc->last_displayed_ns) {
+        uint64_t delta = displayed_ns - sc->last_displayed_ns;
+        uint64_t refreshes = (delta + sc->refresh_duration_ns / 2) / sc->refresh_duration_ns;
+        if (refreshes > 1) {
+            uint64_t grid_ns = refreshes * sc->refresh_duration_ns;
+            uint64_t off_grid = delta > grid_ns ? delta - grid_ns : grid_ns - delta;
+            if (off_grid > sc->refresh_duration_ns / REFRESH_GRID_TOLERANCE_DIVISOR) {
+                sc->variable_refresh = true;
+            } else {
+                entry->times.display_state = FRAME_DISPLAY_REPEATED;
+                entry->times.missed_vblanks = (uint32_t)(refreshes - 1);
+            }
+        }
+    }
+    sc->last_displayed_ns = displayed_ns;
+}
+
+// Attach a display timing record to the pending present it belongs to.
+// Records for frames that already aged out are dropped.
+static void resolve_present_google(SwapchainData* sc, const VkPastPresentationTimingGOOGLE* timing) {
+    for (uint64_t frame = sc->next_record_frame; frame <= sc->frame_count; frame++) {
+        PresentHistoryEntry* entry = &sc->history[frame % PRESENT_HISTORY_SIZE];
+        if (entry->resolved || entry->present_id != timing->presentID) {
+            continue;
+        }
+
+        entry->resolved = true;
+        entry->times.actual_present_time_ns = timing->actualPresentTime;
+        if (timing->earliestPresentTime > entry->times.pre_present_ns) {
+            entry->times.ms_until_render_complete =
+                (float)(timing->earliestPresentTime - entry->times.pre_present_ns) / 1000000.0f;
+        }
+        if (timing->actualPresentTime > entry->times.pre_present_ns) {
+            entry->times.ms_until_displayed =
+                (float)(timing->actualPresentTime - entry->times.pre_present_ns) / 1000000.0f;
+        }
+        classify_display(sc, frame, timing->actualPresentTime);
+        return;
+    }
+}
+
+// Consume every completed present the driver has for this swapchain
+static void drain_past_timings_google(DeviceData* dev_data, SwapchainData* sc) {
+    for (;;) {
+        uint32_t count = PAST_TIMING_BATCH_SIZE;
+        VkResult result = dev_data->dispatch.GetPastPresentationTimingGOOGLE(
+            dev_data->device, sc->swapchain, &count, sc->past_timings);
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+            return;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            resolve_present_google(sc, &sc->past_timings[i]);
+        }
+
+        if (result != VK_INCOMPLETE) {
+            return;
+        }
+    }
+}
+
+// Monotonic time of a present stage, 0 if it wasn't reported or can't be
+// converted
+static uint64_t present_stage_time(const SwapchainData* sc, const VkPastPresentationTimingEXT* timing,
+                                   VkPresentStageFlagsEXT stages) {
+    if (timing->timeDomainId != sc->time_domain_id) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < timing->presentStageCount && i < PRESENT_STAGE_COUNT; i++) {
+        if ((timing->pPresentStages[i].stage & stages) && timing->pPresentStages[i].time != 0) {
+            return (uint64_t)((int64_t)timing->pPresentStages[i].time + sc->time_domain_offset_ns);
+        }
+    }
+    return 0;
+}
+
+static void resolve_present_ext(SwapchainData* sc, const VkPastPresentationTimingEXT* timing) {
+    for (uint64_t frame = sc->next_record_frame; frame <= sc->frame_count; frame++) {
+        PresentHistoryEntry* entry = &sc->history[frame % PRESENT_HISTORY_SIZE];
+        if (entry->resolved || entry->present_id != timing->presentId) {
+            continue;
+        }
+
+        entry->resolved = true;
+        uint64_t render_complete_ns = present_stage_time(sc, timing,
+            VK_PRESENT_STAGE_QUEUE_OPERATIONS_END_BIT_EXT);
+        uint64_t displayed_ns = present_stage_time(sc, timing,
+            VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_OUT_BIT_EXT | VK_PRESENT_STAGE_IMAGE_FIRST_PIXEL_VISIBLE_BIT_EXT);
+
+        entry->times.actual_present_time_ns = displayed_ns;
+        if (render_complete_ns > entry->times.pre_present_ns) {
+            entry->times.ms_until_render_complete =
+                (float)(render_complete_ns - entry->times.pre_present_ns) / 1000000.0f;
+        }
+        if (displayed_ns > entry->times.pre_present_ns) {
+            entry->times.ms_until_displayed =
+                (float)(displayed_ns - entry->times.pre_present_ns) / 1000000.0f;
+        }
+        classify_display(sc, frame, displayed_ns);
+        return;
+    }
+}
+
+// Attach finished GPU measurements to frames not yet recorded
+static void collect_gpu_timings(DeviceData* dev_data, SwapchainData* sc) {
+    GpuFrameResult results[GPU_TIMING_FRAMES];
+    uint32_t count = gpu_timing_collect(dev_data->gpu_timing, sc->id, results, GPU_TIMING_FRAMES);
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t frame = results[i].frame_number;
+        if (frame < sc->next_record_frame || frame > sc->frame_count) {
+            continue;
+        }
+        PresentHistoryEntry* entry = &sc->history[frame % PRESENT_HISTORY_SIZE];
+        entry->times.gpu_active_ms = results[i].gpu_active_ms;
+        entry->gpu_pending = false;
+    }
 }
 
-// Track if we need to send swapchain info
-// Set when disconnected or reconnected, cleared after successful send
-static bool pending_swapchain_send = false;
-static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Consume every completed present from the swapchain's results queue
+static void drain_past_timings_ext(DeviceData* dev_data, SwapchainData* sc) {
+    uint64_t now = timing_get_timestamp();
+    if (sc->time_domain != VK_TIME_DOMAIN_CLOCK_MONOTONIC_KHR &&
+        now - sc->last_calibration_ns > PRESENT_TIMING_CALIBRATION_INTERVAL_NS) {
+        calibrate_time_domain(dev_data, sc, now);
+    }
+
+    VkPastPresentationTimingInfoEXT info = {
+        .sType = VK_STRUCTURE_TYPE_PAST_PRESENTATION_TIMING_INFO_EXT,
+        .swapchain = sc->swapchain
+    };
+
+    for (;;) {
+        for (uint32_t i = 0; i < PAST_TIMING_BATCH_SIZE; i++) {
+            sc->past_timings_ext[i] = (VkPastPresentationTimingEXT){
+                .sType = VK_STRUCTURE_TYPE_PAST_PRESENTATION_TIMING_EXT,
+                .presentStageCount = PRESENT_STAGE_COUNT,
+                .pPresentStages = sc->past_stages_ext[i]
+            };
+        }
+        VkPastPresentationTimingPropertiesEXT props = {
+            .sType = VK_STRUCTURE_TYPE_PAST_PRESENTATION_TIMING_PROPERTIES_EXT,
+            .presentationTimingCount = PAST_TIMING_BATCH_SIZE,
+            .pPresentationTimings = sc->past_timings_ext
+        };
+        VkResult result = dev_data->dispatch.GetPastPresentationTimingEXT(dev_data->device, &info, &props);
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+            return;
+        }
+
+        // The swapchain switched time domains (e.g. display change)
+        if (props.timeDomainsCounter != sc->time_domains_counter && !select_time_domain(dev_data, sc)) {
+            sc->time_domain_id = UINT64_MAX;  // Results can't be converted until a domain is usable again
+        }
+        if (props.timingPropertiesCounter != sc->timing_properties_counter) {
+            sc->timing_properties_counter = props.timingPropertiesCounter;
+            update_refresh_duration_ext(dev_data, sc);
+        }
+
+        for (uint32_t i = 0; i < props.presentationTimingCount && i < PAST_TIMING_BATCH_SIZE; i++) {
+            if (sc->timing_requests_pending > 0) {
+                sc->timing_requests_pending--;
+            }
+            resolve_present_ext(sc, &sc->past_timings_ext[i]);
+        }
+
+        if (result != VK_INCOMPLETE) {
+            return;
+        }
+    }
+}
+
+// The capture tier changed since this swapchain's last present. Presents in
+// between may have gone unrecorded, so the gap isn't reported as a frametime.
+static void restart_capture(DeviceData* dev_data, SwapchainData* sc, uint32_t generation,
+                            bool close_gpu_frame) {
+    // Frames still waiting for display timing or GPU results go out as they are
+    record_ready_frames(sc, false, false);
+    timing_reset_baseline(sc->timing);
+    memset(sc->acquires, 0, sizeof(sc->acquires));
+    sc->last_displayed_ns = 0;
+
+    // Submits timed before the tier was lowered belong to no recorded frame;
+    // frame 0 is never collected
+    if (close_gpu_frame) {
+        gpu_timing_end_frame(dev_data->gpu_timing, sc->id, 0);
+    }
+
+    sc->capture_generation = generation;
+}
+
+// Daemon connection the hello and swapchain info were last sent on
+// (ipc_client_connection_generation), 0 = none yet
+static _Atomic uint32_t announced_connection = 0;
 
 VKAPI_ATTR VkResult VKAPI_CALL layer_QueuePresentKHR(
     VkQueue queue,
     const VkPresentInfoKHR* pPresentInfo)
 {
-    // Try to reconnect to daemon if not connected (handles game started before daemon)
-    if (!ipc_client_is_connected()) {
-        // Always mark pending when disconnected - we need to send info when we reconnect
-        pthread_mutex_lock(&pending_mutex);
-        pending_swapchain_send = true;
-        pthread_mutex_unlock(&pending_mutex);
-
-        ipc_client_try_reconnect();
+    // Queues share their device's dispatch key
+    DeviceData* dev_data = layer_get_queue_device_data(queue);
+
+    // Capture switched off at runtime: straight through, no timestamps
+    CaptureTier tier = layer_capture_tier();
+    if (tier == CAPTURE_TIER_OFF) {
+        if (dev_data && dev_data->dispatch.QueuePresentKHR) {
+            return dev_data->dispatch.QueuePresentKHR(queue, pPresentInfo);
+        }
+        return VK_SUCCESS;
     }
+    uint32_t generation = layer_capture_generation();
 
-    // Check if we need to send swapchain info (with proper locking)
-    pthread_mutex_lock(&pending_mutex);
-    bool should_send = pending_swapchain_send;
-    pthread_mutex_unlock(&pending_mutex);
+    // Everything outside the driver call counts as layer overhead
+    uint64_t enter_time = timing_get_timestamp();
 
-    // Try to send swapchain info if pending and connected
-    bool is_connected = ipc_client_is_connected();
+    // The IPC thread connects in the background (also to a daemon started
+    // after the game); announce this process once per new connection
+    uint32_t connection = ipc_client_connection_generation();
+    bool should_send = connection != 0 &&
+                       connection != atomic_load_explicit(&announced_connection, memory_order_relaxed);
+
+    bool is_connected = should_send && ipc_client_is_connected();
     if (should_send) {
-        ipc_debug_log("pending_send=1, connected=%d, swapchainCount=%u",
-                      is_connected, pPresentInfo->swapchainCount);
+        ipc_debug_log("announce pending, connection=%u, connected=%d, swapchainCount=%u",
+                      connection, is_connected, pPresentInfo->swapchainCount);
+    }
+
+    // Look up the presented swapchains once - they serve the pending send, the
+    // present ID injection and the timing below
+    SwapchainData* sc_cache[PRESENT_SWAPCHAIN_CACHE];
+    uint32_t cached_count = pPresentInfo->swapchainCount < PRESENT_SWAPCHAIN_CACHE ?
+                            pPresentInfo->swapchainCount : PRESENT_SWAPCHAIN_CACHE;
+    for (uint32_t i = 0; i < cached_count; i++) {
+        sc_cache[i] = swapchain_get_data(pPresentInfo->pSwapchains[i]);
     }
+    SwapchainData* first_sc = cached_count > 0 ? sc_cache[0] : NULL;
 
     if (should_send && is_connected && pPresentInfo->swapchainCount > 0) {
-        pthread_mutex_lock(&swapchain_mutex);
-        SwapchainData* sc = swapchain_get_data_unlocked(pPresentInfo->pSwapchains[0]);
+        SwapchainData* sc = first_sc;
         ipc_debug_log("Swapchain lookup: sc=%p, w=%u, h=%u",
                       (void*)sc, sc ? sc->width : 0, sc ? sc->height : 0);
         if (sc && sc->width > 0 && sc->height > 0) {
-            DeviceData* tmp_dev = layer_get_device_data(sc->device);
-            if (tmp_dev && tmp_dev->instance_data) {
-                // Cache swapchain info before releasing lock
-                uint32_t width = sc->width;
-                uint32_t height = sc->height;
-                uint32_t format = (uint32_t)sc->format;
-                uint32_t image_count = sc->image_count;
-                const char* gpu_name = tmp_dev->instance_data->gpu_name;
-
-                bool present_timing = tmp_dev->present_timing_supported;
-                pthread_mutex_unlock(&swapchain_mutex);
+            if (dev_data && dev_data->instance_data) {
+                const char* gpu_name = dev_data->instance_data->gpu_name;
 
                 // Send GPU info if not already sent
                 if (gpu_name && gpu_name[0] != '\0') {
-                    ipc_client_send_hello(gpu_name, present_timing);
+                    ipc_client_send_hello(gpu_name, dev_data->present_timing_supported);
                 }
                 // Send swapchain info
-                ipc_client_send_swapchain_created(width, height, format, image_count);
+                ipc_client_send_swapchain_created(sc->width, sc->height, (uint32_t)sc->format,
+                                                  sc->image_count);
 
-                ipc_debug_log("SENT swapchain: %ux%u, clearing pending flag", width, height);
+                ipc_debug_log("SENT swapchain: %ux%u on connection %u", sc->width, sc->height, connection);
 
-                // Clear pending flag with proper locking
-                pthread_mutex_lock(&pending_mutex);
-                pending_swapchain_send = false;
-                pthread_mutex_unlock(&pending_mutex);
-
-                pthread_mutex_lock(&swapchain_mutex);
+                atomic_store_explicit(&announced_connection, connection, memory_order_relaxed);
             } else {
-                ipc_debug_log("NO DEVICE DATA: tmp_dev=%p, instance=%p",
-                              (void*)tmp_dev, tmp_dev ? (void*)tmp_dev->instance_data : NULL);
+                ipc_debug_log("NO DEVICE DATA: dev=%p, instance=%p",
+                              (void*)dev_data, dev_data ? (void*)dev_data->instance_data : NULL);
             }
         } else {
             ipc_debug_log("INVALID SC: sc=%p, w=%u, h=%u",
                           (void*)sc, sc ? sc->width : 0, sc ? sc->height : 0);
         }
-        pthread_mutex_unlock(&swapchain_mutex);
     }
 
-    // Find device data from queue (simplified - we check all devices)
-    DeviceData* dev_data = NULL;
-    pthread_mutex_lock(&swapchain_mutex);
-    if (pPresentInfo->swapchainCount > 0) {
-        SwapchainData* sc = swapchain_get_data_unlocked(pPresentInfo->pSwapchains[0]);
-        if (sc) {
-            dev_data = layer_get_device_data(sc->device);
+    // Present timing only in the full tier
+    bool google_timing = dev_data && tier == CAPTURE_TIER_FULL &&
+                         dev_data->present_timing_type == PRESENT_TIMING_GOOGLE &&
+                         dev_data->dispatch.GetPastPresentationTimingGOOGLE;
+    bool ext_timing = dev_data && tier == CAPTURE_TIER_FULL &&
+                      dev_data->present_timing_type == PRESENT_TIMING_EXT;
+
+    // Without present IDs from the app, tag each present with its frame number
+    // so display timings can be matched back to the exact frame
+    VkPresentInfoKHR present_info = *pPresentInfo;
+    VkPresentTimesInfoGOOGLE times_info;
+    VkPresentTimeGOOGLE present_times[PRESENT_SWAPCHAIN_CACHE];
+    const VkPresentTimesInfoGOOGLE* app_times =
+        layer_find_in_chain(pPresentInfo->pNext, VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE);
+
+    bool google_ids = google_timing && (app_times || pPresentInfo->swapchainCount <= PRESENT_SWAPCHAIN_CACHE);
+    if (google_timing && !app_times && pPresentInfo->swapchainCount <= PRESENT_SWAPCHAIN_CACHE) {
+        for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
+            present_times[i].presentID = sc_cache[i] ? (uint32_t)(sc_cache[i]->frame_count + 1) : 0;
+            present_times[i].desiredPresentTime = 0;
         }
+        times_info.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+        times_info.pNext = pPresentInfo->pNext;
+        times_info.swapchainCount = pPresentInfo->swapchainCount;
+        times_info.pTimes = present_times;
+        present_info.pNext = &times_info;
     }
-    pthread_mutex_unlock(&swapchain_mutex);
+
+    // VK_EXT_present_timing: request stage timings for our swapchains while
+    // their results queue has room, identified by VkPresentId2KHR
+    VkPresentId2KHR present_id2;
+    uint64_t present_ids[PRESENT_SWAPCHAIN_CACHE];
+    VkPresentTimingsInfoEXT timings_info;
+    VkPresentTimingInfoEXT timing_infos[PRESENT_SWAPCHAIN_CACHE];
+    bool timing_requested[PRESENT_SWAPCHAIN_CACHE] = { false };
+    const VkPresentId2KHR* app_ids =
+        layer_find_in_chain(pPresentInfo->pNext, VK_STRUCTURE_TYPE_PRESENT_ID_2_KHR);
+
+    if (ext_timing && pPresentInfo->swapchainCount <= PRESENT_SWAPCHAIN_CACHE &&
+        !layer_find_in_chain(pPresentInfo->pNext, VK_STRUCTURE_TYPE_PRESENT_TIMINGS_INFO_EXT)) {
+        bool any_requested = false;
+        for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
+            SwapchainData* sc = sc_cache[i];
+            timing_infos[i] = (VkPresentTimingInfoEXT){ .sType = VK_STRUCTURE_TYPE_PRESENT_TIMING_INFO_EXT };
+            present_ids[i] = 0;
+            if (!sc || sc->timing_type != PRESENT_TIMING_EXT) {
+                continue;
+            }
+
+            present_ids[i] = sc->frame_count + 1;
+            if (sc->timing_requests_pending < PRESENT_TIMING_QUEUE_SIZE) {
+                timing_infos[i].timeDomainId = sc->time_domain_id;
+                timing_infos[i].presentStageQueries = sc->present_stage_queries;
+                timing_requested[i] = true;
+                any_requested = true;
+            }
+        }
+
+        if (any_requested) {
+            const void* next = pPresentInfo->pNext;
+            if (!app_ids) {
+                present_id2.sType = VK_STRUCTURE_TYPE_PRESENT_ID_2_KHR;
+                present_id2.pNext = next;
+                present_id2.swapchainCount = pPresentInfo->swapchainCount;
+                present_id2.pPresentIds = present_ids;
+                next = &present_id2;
+            }
+            timings_info.sType = VK_STRUCTURE_TYPE_PRESENT_TIMINGS_INFO_EXT;
+            timings_info.pNext = next;
+            timings_info.swapchainCount = pPresentInfo->swapchainCount;
+            timings_info.pTimingInfos = timing_infos;
+            present_info.pNext = &timings_info;
+        }
+    }
+
+    // Frame cap: hold the present until the first swapchain's next deadline
+    uint64_t limiter_wait_ns = 0;
+    uint64_t limiter_error_ns = 0;
+    bool limited = first_sc && frame_limiter_wait(&first_sc->limiter, &limiter_wait_ns, &limiter_error_ns);
 
     // Record frametime before present
     uint64_t pre_present_time = timing_get_timestamp();
@@ -266,76 +879,93 @@ VKAPI_ATTR VkResult VKAPI_CALL layer_QueuePresentKHR(
     // Call the real QueuePresentKHR
     VkResult result = VK_SUCCESS;
     if (dev_data && dev_data->dispatch.QueuePresentKHR) {
-        result = dev_data->dispatch.QueuePresentKHR(queue, pPresentInfo);
+        result = dev_data->dispatch.QueuePresentKHR(queue, &present_info);
     }
 
     // Record frametime after present
     uint64_t post_present_time = timing_get_timestamp();
 
+    bool gpu_timing = dev_data && dev_data->gpu_timing && tier == CAPTURE_TIER_FULL;
+    bool presented = result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+
     // Update frame data for each presented swapchain
-    pthread_mutex_lock(&swapchain_mutex);
     for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
-        SwapchainData* sc_data = swapchain_get_data_unlocked(pPresentInfo->pSwapchains[i]);
-        if (sc_data) {
-            // Store pre_present_time in ring buffer for future timing lookups
-            // Use frame_count as our internal present ID
-            sc_data->present_timestamps[sc_data->frame_count % PRESENT_HISTORY_SIZE] = pre_present_time;
-
-            // Query actual present timing from extension if available
-            uint64_t actual_present_time_ns = 0;
-            float ms_until_render_complete = 0.0f;
-            float ms_until_displayed = 0.0f;
-
-            if (dev_data && dev_data->present_timing_supported) {
-                if (dev_data->present_timing_type == PRESENT_TIMING_GOOGLE &&
-                    dev_data->dispatch.GetPastPresentationTimingGOOGLE) {
-                    // VK_GOOGLE_display_timing - returns timing for PAST frames
-                    uint32_t count = 0;
-                    VkResult timing_result = dev_data->dispatch.GetPastPresentationTimingGOOGLE(
-                        dev_data->device, sc_data->swapchain, &count, NULL);
-
-                    if (timing_result == VK_SUCCESS && count > 0) {
-                        VkPastPresentationTimingGOOGLE* timings = malloc(count * sizeof(VkPastPresentationTimingGOOGLE));
-                        if (timings) {
-                            timing_result = dev_data->dispatch.GetPastPresentationTimingGOOGLE(
-                                dev_data->device, sc_data->swapchain, &count, timings);
-
-                            if (timing_result == VK_SUCCESS && count > 0) {
-                                VkPastPresentationTimingGOOGLE* latest = &timings[count - 1];
-                                actual_present_time_ns = latest->actualPresentTime;
-
-                                // Initialize first_present_id on first timing data
-                                if (!sc_data->present_id_initialized) {
-                                    sc_data->first_present_id = latest->presentID;
-                                    sc_data->present_id_initialized = true;
-                                }
-
-                                // Normalize presentID to index into our ring buffer
-                                uint32_t normalized_id = latest->presentID - sc_data->first_present_id;
-                                uint32_t history_idx = normalized_id % PRESENT_HISTORY_SIZE;
-                                uint64_t frame_pre_present_time = sc_data->present_timestamps[history_idx];
-
-                                if (frame_pre_present_time > 0) {
-                                    if (latest->earliestPresentTime > 0) {
-                                        ms_until_render_complete = (float)(latest->earliestPresentTime - frame_pre_present_time) / 1000000.0f;
-                                    }
-                                    if (latest->actualPresentTime > 0) {
-                                        ms_until_displayed = (float)(latest->actualPresentTime - frame_pre_present_time) / 1000000.0f;
-                                    }
-                                }
-                            }
-                            free(timings);
-                        }
-                    }
-                }
+        SwapchainData* sc_data = i < cached_count ? sc_cache[i] : swapchain_get_data(pPresentInfo->pSwapchains[i]);
+        if (!sc_data) {
+            continue;
+        }
+
+        if (sc_data->capture_generation != generation) {
+            restart_capture(dev_data, sc_data, generation, i == 0 && gpu_timing);
+        }
+
+        sc_data->frame_count++;
+
+        PresentHistoryEntry* entry = &sc_data->history[sc_data->frame_count % PRESENT_HISTORY_SIZE];
+        memset(entry, 0, sizeof(*entry));
+        entry->times.frame_number = sc_data->frame_count;
+        entry->times.pre_present_ns = pre_present_time;
+        entry->times.post_present_ns = post_present_time;
+        if (i == 0 && limited) {
+            entry->times.limiter_wait_ns = limiter_wait_ns;
+            entry->times.limiter_error_ms = (float)limiter_error_ns / 1000000.0f;
+        }
+
+        // Each acquire is attributed to one present only
+        uint32_t image_index = pPresentInfo->pImageIndices[i];
+        if (image_index < SWAPCHAIN_MAX_TRACKED_IMAGES) {
+            ImageAcquire* acquire = &sc_data->acquires[image_index];
+            entry->times.acquire_start_ns = acquire->start_ns;
+            entry->times.acquire_end_ns = acquire->end_ns;
+            memset(acquire, 0, sizeof(*acquire));
+        }
+        if (sc_data->timing_type == PRESENT_TIMING_EXT) {
+            if (app_ids && app_ids->pPresentIds && i < app_ids->swapchainCount) {
+                entry->present_id = app_ids->pPresentIds[i];
+            } else {
+                entry->present_id = sc_data->frame_count;
+            }
+            // A failed present never reaches the results queue
+            if (i < PRESENT_SWAPCHAIN_CACHE && timing_requested[i] && presented) {
+                sc_data->timing_requests_pending++;
+                entry->timing_expected = true;
+            }
+        } else {
+            if (app_times && app_times->pTimes && i < app_times->swapchainCount) {
+                entry->present_id = app_times->pTimes[i].presentID;
+            } else {
+                entry->present_id = sc_data->frame_count;
             }
+            entry->timing_expected = google_ids && presented &&
+                                     sc_data->timing_type == PRESENT_TIMING_GOOGLE;
+        }
 
-            sc_data->frame_count++;
-            timing_record_frame(sc_data->frame_count, pre_present_time, post_present_time,
-                                actual_present_time_ns, ms_until_render_complete, ms_until_displayed);
+        // Display timings arrive a few presents later; frames are recorded
+        // once resolved (or aged out) so each gets its own timing
+        bool wait_for_timing = false;
+        if (sc_data->timing_type == PRESENT_TIMING_EXT && ext_timing) {
+            drain_past_timings_ext(dev_data, sc_data);
+            wait_for_timing = true;
+        } else if (sc_data->timing_type == PRESENT_TIMING_GOOGLE && google_timing) {
+            drain_past_timings_google(dev_data, sc_data);
+            wait_for_timing = true;
         }
+
+        // GPU work submitted since the previous present belongs to the first
+        // presented swapchain's frame
+        if (gpu_timing) {
+            if (i == 0) {
+                entry->gpu_pending = gpu_timing_end_frame(dev_data->gpu_timing, sc_data->id,
+                                                          sc_data->frame_count);
+            }
+            collect_gpu_timings(dev_data, sc_data);
+        }
+
+        record_ready_frames(sc_data, wait_for_timing, gpu_timing);
     }
-    pthread_mutex_unlock(&swapchain_mutex);
+
+    overhead_record((pre_present_time - enter_time - limiter_wait_ns) +
+                    (timing_get_timestamp() - post_present_time));
 
     return result;
 }
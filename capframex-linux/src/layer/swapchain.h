@@ -2,28 +2,96 @@
 #define CAPFRAMEX_SWAPCHAIN_H
 
 #include "layer.h"
+#include "timing.h"
+#include "frame_limiter.h"
 
-// Maximum number of tracked swapchains per device
-#define MAX_SWAPCHAINS 8
+// Presents awaiting display timing, indexed by frame number
+#define PRESENT_HISTORY_SIZE 32
 
-// Ring buffer size for tracking present timestamps (for matching timing data)
-#define PRESENT_HISTORY_SIZE 16
+// A frame is recorded without display timing once this many newer presents
+// exist (display timing normally arrives 2-3 presents later)
+#define PRESENT_MAX_PENDING 16
+
+// Past presentation timings fetched per vkGetPastPresentationTiming*() call
+#define PAST_TIMING_BATCH_SIZE 16
+
+// VK_EXT_present_timing: results queue size requested per swapchain. Presents
+// only ask for timing while fewer requests than this are outstanding, since a
+// full queue fails the present.
+#define PRESENT_TIMING_QUEUE_SIZE PRESENT_HISTORY_SIZE
+
+// Present stages reported per VK_EXT_present_timing result (one per stage bit)
+#define PRESENT_STAGE_COUNT 4
+
+// Time domains considered per swapchain
+#define PRESENT_TIME_DOMAIN_MAX 8
+
+// Non-CLOCK_MONOTONIC time domains are recalibrated this often (1s)
+#define PRESENT_TIMING_CALIBRATION_INTERVAL_NS 1000000000ULL
+
+// Acquires tracked per image index (larger indices aren't timed)
+#define SWAPCHAIN_MAX_TRACKED_IMAGES 16
+
+// A present waiting for its display timing
+typedef struct {
+    PresentTimestamps times;
+    uint64_t present_id;          // ID passed in VkPresentTimesInfoGOOGLE/VkPresentId2KHR (ours or the app's)
+    bool resolved;                // Display timing received (or known never to come)
+    bool timing_expected;         // Display timing was requested, so a missing report means dropped
+    bool gpu_pending;             // GPU active time still being measured
+} PresentHistoryEntry;
+
+// Last acquire of a swapchain image, consumed by the present of that image
+typedef struct {
+    uint64_t start_ns;
+    uint64_t end_ns;
+} ImageAcquire;
 
 // Swapchain data
 typedef struct {
     VkSwapchainKHR swapchain;
     VkDevice device;
+    uint32_t id;                  // Process-unique, tags this swapchain's frames
+    TimingContext* timing;        // Frametimes of this swapchain only
     uint32_t width;
     uint32_t height;
     VkFormat format;
     uint32_t image_count;
     uint64_t frame_count;
     bool active;
+    uint32_t capture_generation;  // layer_capture_generation() at the last present
+    FrameLimiter limiter;         // Frame cap schedule (see frame_limiter.h)
 
-    // Ring buffer for tracking present timestamps by presentID
-    uint64_t present_timestamps[PRESENT_HISTORY_SIZE];
-    uint32_t first_present_id;     // First presentID from driver (for normalization)
-    bool present_id_initialized;   // Whether first_present_id has been set
+    ImageAcquire acquires[SWAPCHAIN_MAX_TRACKED_IMAGES];
+
+    // Presents not yet recorded: frames next_record_frame..frame_count
+    PresentHistoryEntry history[PRESENT_HISTORY_SIZE];
+    uint64_t next_record_frame;
+
+    // Display timing source. NONE when the layer couldn't enable timing on this
+    // swapchain or the app reads VK_EXT_present_timing results itself.
+    PresentTimingType timing_type;
+
+    // Display state classification. Timings are reported in present order,
+    // so a report skips exactly the presents that never reached the display.
+    uint64_t refresh_duration_ns;        // Fixed display refresh cycle, 0 if unknown or variable
+    bool variable_refresh;               // A late frame landed between refresh cycles: VRR, no repeats
+    uint64_t last_displayed_ns;          // Display time of the latest displayed frame
+    uint64_t timing_properties_counter;  // VK_EXT_present_timing: refresh duration re-read when this changes
+
+    // Preallocated buffers for draining past presentation timings
+    VkPastPresentationTimingGOOGLE past_timings[PAST_TIMING_BATCH_SIZE];
+    VkPastPresentationTimingEXT past_timings_ext[PAST_TIMING_BATCH_SIZE];
+    VkPresentStageTimeEXT past_stages_ext[PAST_TIMING_BATCH_SIZE][PRESENT_STAGE_COUNT];
+
+    // VK_EXT_present_timing state
+    VkPresentStageFlagsEXT present_stage_queries;
+    uint32_t timing_requests_pending;   // Presents with queries not yet reported
+    VkTimeDomainKHR time_domain;
+    uint64_t time_domain_id;
+    uint64_t time_domains_counter;      // Re-select the domain when this changes
+    int64_t time_domain_offset_ns;      // CLOCK_MONOTONIC minus time_domain
+    uint64_t last_calibration_ns;
 } SwapchainData;
 
 // Initialize swapchain tracking for a device
@@ -32,7 +100,7 @@ void swapchain_init_device(DeviceData* device_data);
 // Cleanup swapchain tracking for a device
 void swapchain_cleanup_device(DeviceData* device_data);
 
-// Get swapchain data
+// Get swapchain data (lock-free)
 SwapchainData* swapchain_get_data(VkSwapchainKHR swapchain);
 
 // Get active swapchain info for IPC reporting
@@ -52,6 +120,19 @@ VKAPI_ATTR void VKAPI_CALL layer_DestroySwapchainKHR(
     VkSwapchainKHR swapchain,
     const VkAllocationCallbacks* pAllocator);
 
+VKAPI_ATTR VkResult VKAPI_CALL layer_AcquireNextImageKHR(
+    VkDevice device,
+    VkSwapchainKHR swapchain,
+    uint64_t timeout,
+    VkSemaphore semaphore,
+    VkFence fence,
+    uint32_t* pImageIndex);
+
+VKAPI_ATTR VkResult VKAPI_CALL layer_AcquireNextImage2KHR(
+    VkDevice device,
+    const VkAcquireNextImageInfoKHR* pAcquireInfo,
+    uint32_t* pImageIndex);
+
 VKAPI_ATTR VkResult VKAPI_CALL layer_QueuePresentKHR(
     VkQueue queue,
     const VkPresentInfoKHR* pPresentInfo);
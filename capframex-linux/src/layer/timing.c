@@ -5,27 +5,45 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <pthread.h>
-
-static FrameTimingData frame_buffer[FRAME_BUFFER_SIZE];
-static uint32_t buffer_head = 0;
-static uint32_t buffer_count = 0;
-static uint64_t last_frame_time = 0;
-static uint64_t last_actual_present_time = 0;  // For calculating actual frametime delta
-static pthread_mutex_t timing_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-void timing_init(void) {
-    pthread_mutex_lock(&timing_mutex);
-    memset(frame_buffer, 0, sizeof(frame_buffer));
-    buffer_head = 0;
-    buffer_count = 0;
-    last_frame_time = 0;
-    last_actual_present_time = 0;
-    pthread_mutex_unlock(&timing_mutex);
+#include <stdatomic.h>
+
+// Ring buffer slot. seq is odd while the producer is writing the slot and
+// (index + 1) * 2 once frame `index` is fully written, so readers can detect
+// torn or overwritten slots without taking a lock.
+typedef struct {
+    _Atomic uint64_t seq;
+    FrameTimingData data;
+} FrameSlot;
+
+struct TimingContext {
+    uint32_t swapchain_id;
+
+    // Total number of frames ever written (index of the next slot to fill).
+    // Only the producer (present thread) stores to it.
+    _Atomic uint64_t write_index;
+    // Frames with an index below this were cleared and are invisible to readers
+    _Atomic uint64_t read_floor;
+    // Set by timing_clear_buffer(), consumed by the producer on its next frame
+    atomic_bool reset_requested;
+
+    // Producer-private state (only touched from timing_record_frame)
+    uint64_t last_frame_time;
+    uint64_t last_actual_present_time;  // For calculating actual frametime delta
+
+    FrameSlot frame_buffer[FRAME_BUFFER_SIZE];
+};
+
+TimingContext* timing_context_create(uint32_t swapchain_id) {
+    TimingContext* ctx = calloc(1, sizeof(TimingContext));
+    if (!ctx) {
+        return NULL;
+    }
+    ctx->swapchain_id = swapchain_id;
+    return ctx;
 }
 
-void timing_cleanup(void) {
-    timing_clear_buffer();
+void timing_context_destroy(TimingContext* ctx) {
+    free(ctx);
 }
 
 uint64_t timing_get_timestamp(void) {
@@ -36,141 +54,172 @@ uint64_t timing_get_timestamp(void) {
     return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
-void timing_record_frame(uint64_t frame_number, uint64_t pre_present_ns, uint64_t post_present_ns,
-                         uint64_t actual_present_time_ns, float ms_until_render_complete,
-                         float ms_until_displayed) {
-    pthread_mutex_lock(&timing_mutex);
+// Copy frame `index` out of the ring. Returns false if the slot is being
+// written or has already been overwritten by a newer frame.
+static bool read_slot(TimingContext* ctx, uint64_t index, FrameTimingData* out) {
+    const FrameSlot* slot = &ctx->frame_buffer[index % FRAME_BUFFER_SIZE];
+    uint64_t expected = (index + 1) * 2;
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != expected) {
+        return false;
+    }
+
+    memcpy(out, &slot->data, sizeof(*out));
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == expected;
+}
 
-    FrameTimingData* frame = &frame_buffer[buffer_head];
+// Range of frame indices currently visible to readers: [*first, *end)
+static void visible_range(TimingContext* ctx, uint64_t* first, uint64_t* end) {
+    uint64_t head = atomic_load_explicit(&ctx->write_index, memory_order_acquire);
+    uint64_t floor = atomic_load_explicit(&ctx->read_floor, memory_order_acquire);
+    uint64_t oldest = (head > FRAME_BUFFER_SIZE) ? head - FRAME_BUFFER_SIZE : 0;
 
-    frame->frame_number = frame_number;
-    frame->timestamp_ns = pre_present_ns;
+    *first = (floor > oldest) ? floor : oldest;
+    *end = head;
+}
+
+void timing_record_frame(TimingContext* ctx, const PresentTimestamps* present) {
+    if (atomic_exchange_explicit(&ctx->reset_requested, false, memory_order_acquire)) {
+        ctx->last_frame_time = 0;
+        ctx->last_actual_present_time = 0;
+    }
+
+    uint64_t pre_present_ns = present->pre_present_ns;
+    uint64_t actual_present_time_ns = present->actual_present_time_ns;
+    FrameTimingData frame;
+
+    frame.frame_number = present->frame_number;
+    frame.swapchain_id = ctx->swapchain_id;
+    frame.timestamp_ns = pre_present_ns;
 
     // Calculate CPU sampled frametime (time since last frame)
-    if (last_frame_time > 0) {
-        frame->frametime_ms = (float)(pre_present_ns - last_frame_time) / 1000000.0f;
+    if (ctx->last_frame_time > 0) {
+        frame.frametime_ms = (float)(pre_present_ns - ctx->last_frame_time) / 1000000.0f;
     } else {
-        frame->frametime_ms = 0.0f;
+        frame.frametime_ms = 0.0f;
     }
 
     // Time spent in the present call itself
-    frame->present_time_ms = (float)(post_present_ns - pre_present_ns) / 1000000.0f;
+    frame.present_time_ms = (float)(present->post_present_ns - pre_present_ns) / 1000000.0f;
+
+    // CPU busy/wait split: blocked in acquire vs. working until present.
+    // Time held back by the frame limiter is neither.
+    frame.acquire_time_ns = present->acquire_start_ns;
+    if (present->acquire_start_ns > 0 && present->acquire_end_ns >= present->acquire_start_ns &&
+        pre_present_ns >= present->acquire_end_ns + present->limiter_wait_ns) {
+        frame.acquire_wait_ms = (float)(present->acquire_end_ns - present->acquire_start_ns) / 1000000.0f;
+        frame.acquire_to_present_ms =
+            (float)(pre_present_ns - present->limiter_wait_ns - present->acquire_end_ns) / 1000000.0f;
+    } else {
+        frame.acquire_wait_ms = 0.0f;
+        frame.acquire_to_present_ms = 0.0f;
+    }
 
     // Handle actual present timing from extension
-    frame->actual_present_time_ns = actual_present_time_ns;
-    frame->ms_until_render_complete = ms_until_render_complete;
-    frame->ms_until_displayed = ms_until_displayed;
-    if (actual_present_time_ns > 0 && last_actual_present_time > 0) {
+    frame.actual_present_time_ns = actual_present_time_ns;
+    frame.ms_until_render_complete = present->ms_until_render_complete;
+    frame.ms_until_displayed = present->ms_until_displayed;
+    frame.gpu_active_ms = present->gpu_active_ms;
+    frame.limiter_error_ms = present->limiter_error_ms;
+    frame.display_state = present->display_state;
+    frame.missed_vblanks = present->missed_vblanks;
+    if (actual_present_time_ns > 0 && ctx->last_actual_present_time > 0) {
         // Calculate frametime from actual present times (actualDuration)
-        frame->actual_frametime_ms = (float)(actual_present_time_ns - last_actual_present_time) / 1000000.0f;
+        frame.actual_frametime_ms = (float)(actual_present_time_ns - ctx->last_actual_present_time) / 1000000.0f;
     } else {
-        frame->actual_frametime_ms = 0.0f;
+        frame.actual_frametime_ms = 0.0f;
     }
 
-    last_frame_time = pre_present_ns;
+    ctx->last_frame_time = pre_present_ns;
     if (actual_present_time_ns > 0) {
-        last_actual_present_time = actual_present_time_ns;
+        ctx->last_actual_present_time = actual_present_time_ns;
     }
 
-    // Advance ring buffer
-    buffer_head = (buffer_head + 1) % FRAME_BUFFER_SIZE;
-    if (buffer_count < FRAME_BUFFER_SIZE) {
-        buffer_count++;
-    }
+    // Publish into the ring: mark the slot as in-progress, write, then
+    // stamp it with the frame's sequence number and advance the head.
+    uint64_t index = atomic_load_explicit(&ctx->write_index, memory_order_relaxed);
+    FrameSlot* slot = &ctx->frame_buffer[index % FRAME_BUFFER_SIZE];
 
-    pthread_mutex_unlock(&timing_mutex);
+    atomic_store_explicit(&slot->seq, index * 2 + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->data = frame;
+    atomic_store_explicit(&slot->seq, (index + 1) * 2, memory_order_release);
+    atomic_store_explicit(&ctx->write_index, index + 1, memory_order_release);
 
     // Always send frame data to daemon (continuous streaming)
-    ipc_client_send_frame_data(frame);
+    ipc_client_send_frame_data(&frame);
 }
 
-const FrameTimingData* timing_get_frame_buffer(void) {
-    return frame_buffer;
+uint32_t timing_get_frame_count(TimingContext* ctx) {
+    uint64_t first, end;
+    visible_range(ctx, &first, &end);
+    return (uint32_t)(end - first);
 }
 
-uint32_t timing_get_frame_count(void) {
-    pthread_mutex_lock(&timing_mutex);
-    uint32_t count = buffer_count;
-    pthread_mutex_unlock(&timing_mutex);
-    return count;
-}
-
-bool timing_get_latest_frame(FrameTimingData* out) {
-    pthread_mutex_lock(&timing_mutex);
+bool timing_get_latest_frame(TimingContext* ctx, FrameTimingData* out) {
+    uint64_t first, end;
+    visible_range(ctx, &first, &end);
 
-    if (buffer_count == 0) {
-        pthread_mutex_unlock(&timing_mutex);
-        return false;
+    // Walk back past a slot that is being overwritten right now
+    for (uint64_t index = end; index > first; index--) {
+        if (read_slot(ctx, index - 1, out)) {
+            return true;
+        }
     }
-
-    uint32_t latest_idx = (buffer_head == 0) ? FRAME_BUFFER_SIZE - 1 : buffer_head - 1;
-    *out = frame_buffer[latest_idx];
-
-    pthread_mutex_unlock(&timing_mutex);
-    return true;
+    return false;
 }
 
-uint32_t timing_get_frames_since(uint64_t since_frame, FrameTimingData* out, uint32_t max_frames) {
-    pthread_mutex_lock(&timing_mutex);
+uint32_t timing_get_frames_since(TimingContext* ctx, uint64_t since_frame,
+                                 FrameTimingData* out, uint32_t max_frames) {
+    uint64_t first, end;
+    visible_range(ctx, &first, &end);
 
     uint32_t copied = 0;
-    uint32_t start_idx;
-
-    if (buffer_count < FRAME_BUFFER_SIZE) {
-        start_idx = 0;
-    } else {
-        start_idx = buffer_head;  // Oldest frame in a full buffer
-    }
-
-    for (uint32_t i = 0; i < buffer_count && copied < max_frames; i++) {
-        uint32_t idx = (start_idx + i) % FRAME_BUFFER_SIZE;
-        if (frame_buffer[idx].frame_number > since_frame) {
-            out[copied++] = frame_buffer[idx];
+    for (uint64_t index = first; index < end && copied < max_frames; index++) {
+        if (read_slot(ctx, index, &out[copied]) && out[copied].frame_number > since_frame) {
+            copied++;
         }
     }
 
-    pthread_mutex_unlock(&timing_mutex);
     return copied;
 }
 
-void timing_clear_buffer(void) {
-    pthread_mutex_lock(&timing_mutex);
-    memset(frame_buffer, 0, sizeof(frame_buffer));
-    buffer_head = 0;
-    buffer_count = 0;
-    last_frame_time = 0;
-    last_actual_present_time = 0;
-    pthread_mutex_unlock(&timing_mutex);
+void timing_clear_buffer(TimingContext* ctx) {
+    // Hide everything written so far; the producer resets its deltas lazily
+    atomic_store_explicit(&ctx->read_floor,
+                          atomic_load_explicit(&ctx->write_index, memory_order_acquire),
+                          memory_order_release);
+    atomic_store_explicit(&ctx->reset_requested, true, memory_order_release);
 }
 
-float timing_get_average_frametime(uint32_t num_frames) {
-    pthread_mutex_lock(&timing_mutex);
+void timing_reset_baseline(TimingContext* ctx) {
+    ctx->last_frame_time = 0;
+    ctx->last_actual_present_time = 0;
+}
 
-    if (buffer_count == 0) {
-        pthread_mutex_unlock(&timing_mutex);
-        return 0.0f;
-    }
+float timing_get_average_frametime(TimingContext* ctx, uint32_t num_frames) {
+    uint64_t first, end;
+    visible_range(ctx, &first, &end);
 
-    uint32_t count = (num_frames < buffer_count) ? num_frames : buffer_count;
     float sum = 0.0f;
     uint32_t valid_count = 0;
+    FrameTimingData frame;
 
     // Start from the most recent frame
-    for (uint32_t i = 0; i < count; i++) {
-        uint32_t idx = (buffer_head - 1 - i + FRAME_BUFFER_SIZE) % FRAME_BUFFER_SIZE;
-        if (frame_buffer[idx].frametime_ms > 0.0f) {
-            sum += frame_buffer[idx].frametime_ms;
+    for (uint64_t index = end; index > first && num_frames > 0; index--, num_frames--) {
+        if (read_slot(ctx, index - 1, &frame) && frame.frametime_ms > 0.0f) {
+            sum += frame.frametime_ms;
             valid_count++;
         }
     }
 
-    pthread_mutex_unlock(&timing_mutex);
-
     return (valid_count > 0) ? sum / valid_count : 0.0f;
 }
 
-float timing_get_current_fps(void) {
-    float avg_frametime = timing_get_average_frametime(60);  // Average over ~1 second at 60fps
+float timing_get_current_fps(TimingContext* ctx) {
+    float avg_frametime = timing_get_average_frametime(ctx, 60);  // Average over ~1 second at 60fps
     if (avg_frametime <= 0.0f) {
         return 0.0f;
     }
@@ -14,45 +14,79 @@ typedef struct {
     float ms_until_render_complete;   // Time until render complete (0 if not available)
     float ms_until_displayed;         // Time until displayed (0 if not available)
     float actual_frametime_ms;    // Frametime from actual present timing (0 if not available)
+    uint32_t swapchain_id;        // Process-unique id of the presenting swapchain
+    uint64_t acquire_time_ns;     // When the presented image was acquired (0 if not seen)
+    float acquire_wait_ms;        // Time blocked inside vkAcquireNextImageKHR
+    float acquire_to_present_ms;  // CPU time from acquire returning to present
+    float gpu_active_ms;          // GPU busy with this frame's submits (0 unless GPU timing is on)
+    float limiter_error_ms;       // Frame limiter's release past its deadline (0 if uncapped)
+    uint32_t display_state;       // FrameDisplayState
+    uint32_t missed_vblanks;      // Refreshes the previous frame was repeated before this one
 } FrameTimingData;
 
-// Ring buffer size (~60 seconds at 144fps)
+// Raw timestamps of one present, turned into FrameTimingData by
+// timing_record_frame()
+typedef struct {
+    uint64_t frame_number;
+    uint64_t acquire_start_ns;        // vkAcquireNextImageKHR called (0 if not seen)
+    uint64_t acquire_end_ns;          // vkAcquireNextImageKHR returned
+    uint64_t pre_present_ns;
+    uint64_t post_present_ns;
+    uint64_t actual_present_time_ns;  // From the present timing extension (0 if not available)
+    float ms_until_render_complete;
+    float ms_until_displayed;
+    float gpu_active_ms;              // From injected GPU timestamps (0 if not measured)
+    uint64_t limiter_wait_ns;         // Held back by the frame limiter before pre_present_ns
+    float limiter_error_ms;           // Limiter release past its deadline (0 if uncapped)
+    uint32_t display_state;           // FrameDisplayState, from the display timing
+    uint32_t missed_vblanks;
+} PresentTimestamps;
+
+// Ring buffer size per swapchain (~60 seconds at 144fps)
 #define FRAME_BUFFER_SIZE 8640
 
-// Initialize timing system
-void timing_init(void);
+// Frametime state, frame ring and statistics of one swapchain. Frametimes are
+// deltas between presents of the same swapchain, so multi-window and
+// multi-viewport apps don't interleave.
+typedef struct TimingContext TimingContext;
 
-// Cleanup timing system
-void timing_cleanup(void);
+// Create a context for a swapchain, NULL if out of memory
+TimingContext* timing_context_create(uint32_t swapchain_id);
+
+// Free a context. No reader or producer may still use it.
+void timing_context_destroy(TimingContext* ctx);
 
 // Get current timestamp in nanoseconds
 uint64_t timing_get_timestamp(void);
 
 // Record a frame timing (with optional actual present time from extension)
-void timing_record_frame(uint64_t frame_number, uint64_t pre_present_ns, uint64_t post_present_ns,
-                         uint64_t actual_present_time_ns, float ms_until_render_complete,
-                         float ms_until_displayed);
-
-// Get the frame buffer for reading (returns pointer to ring buffer)
-const FrameTimingData* timing_get_frame_buffer(void);
+// Single producer per context: must not be called concurrently for the same
+// context (Vulkan externally synchronizes presents to a swapchain). Readers
+// never block it.
+void timing_record_frame(TimingContext* ctx, const PresentTimestamps* present);
 
 // Get number of frames currently in buffer
-uint32_t timing_get_frame_count(void);
+uint32_t timing_get_frame_count(TimingContext* ctx);
 
 // Get the most recent frame data
-bool timing_get_latest_frame(FrameTimingData* out);
+bool timing_get_latest_frame(TimingContext* ctx, FrameTimingData* out);
 
 // Get frames since a given frame number
 // Returns number of frames copied, up to max_frames
-uint32_t timing_get_frames_since(uint64_t since_frame, FrameTimingData* out, uint32_t max_frames);
+uint32_t timing_get_frames_since(TimingContext* ctx, uint64_t since_frame,
+                                 FrameTimingData* out, uint32_t max_frames);
 
 // Clear the frame buffer
-void timing_clear_buffer(void);
+void timing_clear_buffer(TimingContext* ctx);
+
+// Start frametimes over with the next frame, e.g. after presents went
+// unrecorded. Producer only.
+void timing_reset_baseline(TimingContext* ctx);
 
 // Get average frametime over the last N frames
-float timing_get_average_frametime(uint32_t num_frames);
+float timing_get_average_frametime(TimingContext* ctx, uint32_t num_frames);
 
 // Get current FPS (based on recent frames)
-float timing_get_current_fps(void);
+float timing_get_current_fps(TimingContext* ctx);
 
 #endif // CAPFRAMEX_TIMING_H
@@ -0,0 +1,110 @@
+#include "capframex_pids.h"
+#include "pid_list.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The public header mirrors common.h so users need nothing else
+_Static_assert(sizeof(CapFrameXPid) == sizeof(SharedPidEntry), "CapFrameXPid layout");
+_Static_assert(offsetof(CapFrameXPid, flags) == offsetof(SharedPidEntry, flags), "CapFrameXPid layout");
+_Static_assert(CAPFRAMEX_PID_DETECTED == SHARED_PID_DETECTED, "CAPFRAMEX_PID_DETECTED");
+_Static_assert(CAPFRAMEX_PID_LAYER == SHARED_PID_LAYER, "CAPFRAMEX_PID_LAYER");
+
+struct CapFrameXPids {
+    char shm_name[64];
+    int fd;
+    const SharedPidList* list;
+    SharedPidEntry snapshot[MAX_TRACKED_PROCESSES];
+};
+
+static void detach(CapFrameXPids* pids) {
+    if (pids->list) {
+        munmap((void*)pids->list, sizeof(SharedPidList));
+        pids->list = NULL;
+    }
+    if (pids->fd >= 0) {
+        close(pids->fd);
+        pids->fd = -1;
+    }
+}
+
+// Map the list if not mapped yet, or again if the daemon unlinked it (it
+// restarted or exited). Returns false while there is no list to read.
+static bool attach(CapFrameXPids* pids) {
+    struct stat st;
+    if (pids->fd >= 0) {
+        if (fstat(pids->fd, &st) == 0 && st.st_nlink > 0) {
+            return true;
+        }
+        detach(pids);
+    }
+
+    int fd = shm_open(pids->shm_name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SharedPidList)) {
+        close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(NULL, sizeof(SharedPidList), PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    const SharedPidList* list = mapped;
+    if (list->magic != SHARED_PID_LIST_MAGIC) {
+        // Written by an incompatible daemon
+        munmap(mapped, sizeof(SharedPidList));
+        close(fd);
+        return false;
+    }
+
+    pids->fd = fd;
+    pids->list = list;
+    return true;
+}
+
+CapFrameXPids* capframex_pids_open(const char* shm_name) {
+    CapFrameXPids* pids = calloc(1, sizeof(*pids));
+    if (!pids) {
+        return NULL;
+    }
+    strncpy(pids->shm_name, shm_name ? shm_name : CAPFRAMEX_SHM_NAME, sizeof(pids->shm_name) - 1);
+    pids->fd = -1;
+    return pids;
+}
+
+void capframex_pids_close(CapFrameXPids* pids) {
+    if (!pids) return;
+    detach(pids);
+    free(pids);
+}
+
+int capframex_pids_read(CapFrameXPids* pids, CapFrameXPid* out, int max, uint32_t* version) {
+    if (!pids || !attach(pids)) {
+        return -1;
+    }
+    return pid_list_read(pids->list, (SharedPidEntry*)out, max, version);
+}
+
+uint32_t capframex_pids_lookup(CapFrameXPids* pids, pid_t pid) {
+    if (!pids || !attach(pids)) {
+        return 0;
+    }
+
+    int count = pid_list_read(pids->list, pids->snapshot, MAX_TRACKED_PROCESSES, NULL);
+    for (int i = 0; i < count; i++) {
+        if (pids->snapshot[i].pid == pid) {
+            return pids->snapshot[i].flags;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef CAPFRAMEX_PIDS_H
+#define CAPFRAMEX_PIDS_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// Reader for the CapFrameX daemon's shared PID list: which processes it
+// detected as games and which have a capture layer connected. Reading is a
+// copy out of shared memory, no socket or daemon round trip, so overlays can
+// poll it every frame.
+//
+//   CapFrameXPids* pids = capframex_pids_open(NULL);
+//   uint32_t flags = capframex_pids_lookup(pids, getpid());
+//   if (flags & CAPFRAMEX_PID_LAYER) { /* being captured */ }
+//   capframex_pids_close(pids);
+//
+// Link with -lcapframex_pids. Not thread safe per handle; open one per thread.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPFRAMEX_PID_DETECTED (1u << 0)  // Found by the daemon's game detection
+#define CAPFRAMEX_PID_LAYER    (1u << 1)  // A capture layer is connected from this process
+
+typedef struct {
+    pid_t pid;
+    uint32_t flags;  // CAPFRAMEX_PID_* flags
+} CapFrameXPid;
+
+typedef struct CapFrameXPids CapFrameXPids;
+
+// Create a reader for the list (shm_name NULL = the daemon's). The list is
+// mapped on first read and mapped again when a restarted daemon replaces it,
+// so a reader can be opened before the daemon runs. NULL only if out of memory.
+CapFrameXPids* capframex_pids_open(const char* shm_name);
+
+void capframex_pids_close(CapFrameXPids* pids);
+
+// Copy a consistent snapshot of up to max entries. Returns the number copied,
+// or -1 if there is no list (daemon not running) or it was being rewritten on
+// every attempt.
+// *version (optional) changes whenever the list does.
+int capframex_pids_read(CapFrameXPids* pids, CapFrameXPid* out, int max, uint32_t* version);
+
+// Flags of one process, 0 if it is not listed
+uint32_t capframex_pids_lookup(CapFrameXPids* pids, pid_t pid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPFRAMEX_PIDS_H
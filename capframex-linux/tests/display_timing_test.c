@@ -0,0 +1,324 @@
+// Test for the daemon's display timing tracker.
+//
+// By default vblanks come from a fake source: a pipe carrying
+// (crtc, sequence, timestamp) records that the tracker thread reads like DRM
+// events. The test checks interval stats, gap detection, present-to-vblank
+// correlation (also as answered to MSG_DISPLAY_VBLANKS), pausing while no
+// client holds the tracker and that lock-free readers never see a torn
+// sample while the ring wraps. With --device it instead tracks a real card
+// node (e.g. vkms) for a second and prints what it measured.
+
+#define _GNU_SOURCE
+#include "display_timing.h"
+#include "drm_events.h"
+#include "test_check.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERIOD_60HZ_NS 16666667ULL
+#define PERIOD_144HZ_NS 6944444ULL
+#define BASE_NS 1000000000ULL
+#define STRESS_VBLANKS 50000
+
+// ============================================================================
+// Fake source
+// ============================================================================
+
+typedef struct {
+    uint32_t crtc_index;
+    uint32_t sequence;
+    uint64_t timestamp_ns;
+} FakeVblank;
+
+static int fake_write_fd = -1;
+static atomic_int fake_idle_calls = 0;
+
+static int fake_dispatch(DisplayTimingSource* source) {
+    FakeVblank events[64];
+    ssize_t len = read(source->fd, events, sizeof(events));
+    if (len < 0) {
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    }
+    if (len == 0) {
+        return -1;  // Writer closed
+    }
+    for (size_t i = 0; i < (size_t)len / sizeof(FakeVblank); i++) {
+        display_timing_record(events[i].crtc_index, events[i].sequence, events[i].timestamp_ns);
+    }
+    return 0;
+}
+
+// Called when tracking resumes, where a DRM source arms its CRTCs again
+static void fake_idle(DisplayTimingSource* source) {
+    (void)source;
+    atomic_fetch_add(&fake_idle_calls, 1);
+}
+
+static void fake_destroy(DisplayTimingSource* source) {
+    close(source->fd);
+    free(source);
+}
+
+static bool start_fake_source(uint32_t crtc_count) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+
+    DisplayTimingSource* source = calloc(1, sizeof(DisplayTimingSource));
+    source->fd = fds[0];
+    source->crtc_count = crtc_count;
+    for (uint32_t i = 0; i < crtc_count; i++) {
+        source->crtc_ids[i] = 100 + i;
+    }
+    source->dispatch = fake_dispatch;
+    source->idle = fake_idle;
+    source->destroy = fake_destroy;
+
+    fake_write_fd = fds[1];
+    return display_timing_start(source) == 0;
+}
+
+static void send_vblank(uint32_t crtc_index, uint32_t sequence, uint64_t timestamp_ns) {
+    FakeVblank event = { crtc_index, sequence, timestamp_ns };
+    if (write(fake_write_fd, &event, sizeof(event)) != (ssize_t)sizeof(event)) {
+        perror("write");
+        exit(1);
+    }
+}
+
+// Wait until the tracker thread has recorded a sequence number on a CRTC
+static bool wait_for_sequence(uint32_t crtc_index, uint32_t sequence) {
+    for (int i = 0; i < 2000; i++) {
+        DisplayTimingSample latest;
+        if (display_timing_get_latest(crtc_index, &latest) && latest.sequence == sequence) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void test_stats_and_correlation(void) {
+    // CRTC 0: 60 Hz with vblank 50 missing, CRTC 1: 144 Hz
+    for (uint32_t seq = 1; seq <= 100; seq++) {
+        if (seq != 50) send_vblank(0, seq, BASE_NS + seq * PERIOD_60HZ_NS);
+    }
+    for (uint32_t seq = 1; seq <= 200; seq++) {
+        send_vblank(1, seq, BASE_NS + seq * PERIOD_144HZ_NS);
+    }
+    CHECK(wait_for_sequence(0, 100) && wait_for_sequence(1, 200), "vblanks not recorded");
+
+    DisplayTimingStats stats[DISPLAY_TIMING_MAX_CRTCS];
+    uint32_t count = display_timing_get_stats(stats, DISPLAY_TIMING_MAX_CRTCS);
+    CHECK(count == 3, "stats for %u CRTCs", count);
+
+    CHECK(stats[0].crtc_id == 100, "crtc_id %u", stats[0].crtc_id);
+    CHECK(stats[0].sample_count == 98, "60 Hz intervals %u", stats[0].sample_count);
+    CHECK(stats[0].missed_vblanks == 1, "60 Hz missed %u", stats[0].missed_vblanks);
+    CHECK(fabsf(stats[0].avg_ms_between_vblanks - 16.667f) < 0.01f, "60 Hz avg %.4f",
+          stats[0].avg_ms_between_vblanks);
+    CHECK(fabsf(stats[0].max_ms_between_vblanks - 16.667f) < 0.01f, "60 Hz max %.4f (gap not excluded)",
+          stats[0].max_ms_between_vblanks);
+    CHECK(stats[0].latest_sequence == 100, "60 Hz latest %u", stats[0].latest_sequence);
+
+    CHECK(stats[1].missed_vblanks == 0, "144 Hz missed %u", stats[1].missed_vblanks);
+    CHECK(fabsf(stats[1].avg_ms_between_vblanks - 6.944f) < 0.01f, "144 Hz avg %.4f",
+          stats[1].avg_ms_between_vblanks);
+
+    // A present 1 ms after vblank 10 lands on vblank 11
+    DisplayTimingSample vblank;
+    CHECK(display_timing_next_vblank(0, BASE_NS + 10 * PERIOD_60HZ_NS + 1000000, &vblank) &&
+          vblank.sequence == 11 && vblank.timestamp_ns == BASE_NS + 11 * PERIOD_60HZ_NS,
+          "present after vblank 10 mapped to %u", vblank.sequence);
+
+    // ... and one exactly on a vblank to that vblank
+    CHECK(display_timing_next_vblank(0, BASE_NS + 20 * PERIOD_60HZ_NS, &vblank) &&
+          vblank.sequence == 20, "present on vblank 20 mapped to %u", vblank.sequence);
+
+    // The missing vblank 50 is interpolated
+    CHECK(display_timing_next_vblank(0, BASE_NS + 49 * PERIOD_60HZ_NS + 1000000, &vblank) &&
+          vblank.sequence == 50 && vblank.missed == 0,
+          "present after vblank 49 mapped to %u", vblank.sequence);
+
+    // Outside the recorded range
+    CHECK(!display_timing_next_vblank(0, BASE_NS + 101 * PERIOD_60HZ_NS, &vblank),
+          "present after the latest vblank mapped");
+    CHECK(!display_timing_next_vblank(0, BASE_NS, &vblank), "present before the oldest vblank mapped");
+
+    // The same lookups answered for an app (MSG_DISPLAY_VBLANKS)
+    DisplayVblankRequest request = { .crtc_id = 100, .count = 3 };
+    request.present_ns[0] = BASE_NS + 10 * PERIOD_60HZ_NS + 1000000;
+    request.present_ns[1] = BASE_NS + 49 * PERIOD_60HZ_NS + 1000000;
+    request.present_ns[2] = BASE_NS + 101 * PERIOD_60HZ_NS;
+    DisplayVblankReply reply;
+    uint32_t size = display_timing_match_vblanks(&request, &reply);
+    CHECK(reply.crtc_id == 100 && reply.count == 3, "reply for CRTC %u has %u matches",
+          reply.crtc_id, reply.count);
+    CHECK(size == offsetof(DisplayVblankReply, matches) + 3 * sizeof(DisplayVblankMatch),
+          "reply size %u", size);
+    CHECK(reply.matches[0].present_ns == request.present_ns[0] && reply.matches[0].sequence == 11 &&
+          reply.matches[0].vblank_ns == BASE_NS + 11 * PERIOD_60HZ_NS,
+          "first present matched vblank %u", reply.matches[0].sequence);
+    CHECK(reply.matches[1].sequence == 50, "second present matched vblank %u", reply.matches[1].sequence);
+    CHECK(reply.matches[2].vblank_ns == 0, "present after the latest vblank matched %u",
+          reply.matches[2].sequence);
+
+    request.crtc_id = 999;
+    size = display_timing_match_vblanks(&request, &reply);
+    CHECK(reply.count == 0 && size == offsetof(DisplayVblankReply, matches),
+          "unknown CRTC answered with %u matches", reply.count);
+}
+
+static void test_pause_and_resume(void) {
+    CHECK(!display_timing_wanted(), "tracking wanted without a client");
+
+    // A client asking for display timing resumes tracking
+    display_timing_hold(7);
+    CHECK(display_timing_wanted(), "tracking not wanted after hold");
+    for (int i = 0; i < 2000 && atomic_load(&fake_idle_calls) == 0; i++) {
+        usleep(1000);
+    }
+    CHECK(atomic_load(&fake_idle_calls) == 1, "source not re-armed on resume (%d calls)",
+          atomic_load(&fake_idle_calls));
+
+    // CRTC 0 continues at vblank 110: the paused vblanks 101-109 are
+    // neither missed nor part of an interval
+    for (uint32_t seq = 110; seq <= 120; seq++) {
+        send_vblank(0, seq, BASE_NS + seq * PERIOD_60HZ_NS);
+    }
+    CHECK(wait_for_sequence(0, 120), "vblanks after resume not recorded");
+
+    DisplayTimingStats stats[DISPLAY_TIMING_MAX_CRTCS];
+    display_timing_get_stats(stats, DISPLAY_TIMING_MAX_CRTCS);
+    CHECK(stats[0].sample_count == 10, "intervals since resume %u", stats[0].sample_count);
+    CHECK(stats[0].missed_vblanks == 0, "paused vblanks counted as missed: %u", stats[0].missed_vblanks);
+
+    DisplayTimingSample vblank;
+    CHECK(!display_timing_next_vblank(0, BASE_NS + 105 * PERIOD_60HZ_NS, &vblank),
+          "present during the pause mapped to %u", vblank.sequence);
+    CHECK(display_timing_next_vblank(0, BASE_NS + 112 * PERIOD_60HZ_NS + 1000000, &vblank) &&
+          vblank.sequence == 113, "present after vblank 112 mapped to %u", vblank.sequence);
+
+    // Tracking lasts while any client holds it; a second hold is a no-op
+    display_timing_hold(8);
+    display_timing_hold(8);
+    display_timing_release(7);
+    CHECK(display_timing_wanted(), "tracking paused while another client holds it");
+    display_timing_release(8);
+    CHECK(!display_timing_wanted(), "tracking wanted after the last client left");
+}
+
+static atomic_bool stress_done = false;
+static atomic_ulong stress_reads = 0;
+static atomic_ulong stress_torn = 0;
+
+// Every sample of CRTC 2 satisfies timestamp == BASE + sequence * period
+static void* stress_reader(void* arg) {
+    (void)arg;
+    while (!atomic_load(&stress_done)) {
+        DisplayTimingSample latest;
+        if (display_timing_get_latest(2, &latest) &&
+            latest.timestamp_ns != BASE_NS + latest.sequence * PERIOD_144HZ_NS) {
+            atomic_fetch_add(&stress_torn, 1);
+        }
+
+        DisplayTimingStats stats[DISPLAY_TIMING_MAX_CRTCS];
+        uint32_t count = display_timing_get_stats(stats, DISPLAY_TIMING_MAX_CRTCS);
+        if (count == 3 && stats[2].sample_count > 0 &&
+            (stats[2].missed_vblanks != 0 || fabsf(stats[2].avg_ms_between_vblanks - 6.944f) > 0.01f)) {
+            atomic_fetch_add(&stress_torn, 1);
+        }
+        atomic_fetch_add(&stress_reads, 1);
+    }
+    return NULL;
+}
+
+static void test_concurrent_readers(void) {
+    pthread_t readers[2];
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&readers[i], NULL, stress_reader, NULL);
+    }
+
+    for (uint32_t seq = 1; seq <= STRESS_VBLANKS; seq++) {
+        send_vblank(2, seq, BASE_NS + seq * PERIOD_144HZ_NS);
+    }
+    CHECK(wait_for_sequence(2, STRESS_VBLANKS), "stress vblanks not recorded");
+
+    atomic_store(&stress_done, true);
+    for (int i = 0; i < 2; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    CHECK(atomic_load(&stress_torn) == 0, "%lu inconsistent reads of %lu",
+          atomic_load(&stress_torn), atomic_load(&stress_reads));
+    printf("stress: %u vblanks, %lu reads, %lu inconsistent\n", STRESS_VBLANKS,
+           atomic_load(&stress_reads), atomic_load(&stress_torn));
+}
+
+static int run_device(const char* device) {
+    DisplayTimingSource* source = drm_events_open(device);
+    if (!source || display_timing_start(source) != 0) {
+        fprintf(stderr, "No display timing on %s\n", device);
+        return 1;
+    }
+
+    display_timing_hold(0);
+    sleep(1);
+
+    DisplayTimingStats stats[DISPLAY_TIMING_MAX_CRTCS];
+    uint32_t count = display_timing_get_stats(stats, DISPLAY_TIMING_MAX_CRTCS);
+    for (uint32_t i = 0; i < count; i++) {
+        printf("CRTC %u: %u intervals, avg %.3f ms (min %.3f, max %.3f), %u missed, latest #%u\n",
+               stats[i].crtc_id, stats[i].sample_count, stats[i].avg_ms_between_vblanks,
+               stats[i].min_ms_between_vblanks, stats[i].max_ms_between_vblanks,
+               stats[i].missed_vblanks, stats[i].latest_sequence);
+    }
+
+    display_timing_stop();
+    return count > 0 && stats[0].sample_count > 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"device", required_argument, 0, 'd'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "d:", long_options, NULL)) != -1) {
+        if (opt == 'd') {
+            return run_device(optarg);
+        }
+        fprintf(stderr, "Usage: %s [--device /dev/dri/cardN]\n", argv[0]);
+        return 2;
+    }
+
+    if (!start_fake_source(3)) {
+        fprintf(stderr, "Failed to start the fake source\n");
+        return 1;
+    }
+
+    test_stats_and_correlation();
+    test_pause_and_resume();
+    test_concurrent_readers();
+
+    display_timing_stop();
+    close(fake_write_fd);
+
+    printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,727 @@
+// Headless benchmark for the capture layer.
+//
+// Loads libcapframex_layer.so, negotiates with it like the Vulkan loader does
+// and chains it to a stub "next layer" that implements just enough of the
+// instance, device and swapchain API. Each thread then drives its own
+// swapchain through the layer's vkAcquireNextImageKHR/vkQueuePresentKHR and
+// the harness reports the cost per present, heap allocations per present and
+// mutex lock/contention counts.
+//
+// Allocations and locks are counted by interposing malloc and
+// pthread_mutex_lock in this executable (linked with -rdynamic), so calls
+// made from the layer resolve here first. glibc only.
+
+#define _GNU_SOURCE
+#include <vulkan/vulkan.h>
+#include <vulkan/vk_layer.h>
+
+#include "common.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_WARMUP_PRESENTS 1000
+#define BENCH_IMAGE_COUNT 3
+
+// Presents a stub swapchain reports display timing for, newest last
+#define STUB_TIMING_HISTORY 64
+// Display timing becomes available this many presents later
+#define STUB_TIMING_LAG 2
+
+// ============================================================================
+// Allocation and lock counting
+// ============================================================================
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+static atomic_bool counting = false;
+static atomic_ulong alloc_count = 0;
+static atomic_ulong lock_count = 0;
+static atomic_ulong contended_count = 0;
+
+static int (*real_mutex_lock)(pthread_mutex_t* mutex);
+
+static inline void count_alloc(void) {
+    if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    }
+}
+
+void* malloc(size_t size) {
+    count_alloc();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    count_alloc();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    count_alloc();
+    return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    count_alloc();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    count_alloc();
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    if (!atomic_load_explicit(&counting, memory_order_relaxed)) {
+        return real_mutex_lock(mutex);
+    }
+
+    atomic_fetch_add_explicit(&lock_count, 1, memory_order_relaxed);
+    if (pthread_mutex_trylock(mutex) == 0) {
+        return 0;
+    }
+    atomic_fetch_add_explicit(&contended_count, 1, memory_order_relaxed);
+    return real_mutex_lock(mutex);
+}
+
+// ============================================================================
+// Stub next layer
+// ============================================================================
+
+// Dispatchable handles start with the loader's dispatch pointer, which the
+// layer uses as its lookup key. Physical devices share the instance's,
+// queues the device's.
+typedef struct {
+    void* loader_data;
+} StubDispatchable;
+
+typedef struct {
+    uint64_t present_ids[STUB_TIMING_HISTORY];
+    uint64_t present_times[STUB_TIMING_HISTORY];
+    uint64_t present_count;
+    uint64_t reported_count;
+    uint32_t next_image;
+} StubSwapchain;
+
+static int instance_dispatch_tag;
+static int device_dispatch_tag;
+static StubDispatchable stub_instance = { &instance_dispatch_tag };
+static StubDispatchable stub_physical_device = { &instance_dispatch_tag };
+static StubDispatchable stub_device = { &device_dispatch_tag };
+static StubDispatchable stub_queues[BENCH_MAX_THREADS];
+static StubSwapchain stub_swapchains[BENCH_MAX_THREADS];
+static atomic_uint stub_swapchain_count = 0;
+
+static bool stub_google_display_timing = false;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_CreateInstance(
+    const VkInstanceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkInstance* pInstance) {
+    (void)pCreateInfo;
+    (void)pAllocator;
+    *pInstance = (VkInstance)&stub_instance;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_DestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator) {
+    (void)instance;
+    (void)pAllocator;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_EnumeratePhysicalDevices(
+    VkInstance instance, uint32_t* pCount, VkPhysicalDevice* pDevices) {
+    (void)instance;
+    if (pDevices && *pCount > 0) {
+        pDevices[0] = (VkPhysicalDevice)&stub_physical_device;
+    }
+    *pCount = 1;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_GetPhysicalDeviceProperties(
+    VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties) {
+    (void)physicalDevice;
+    memset(pProperties, 0, sizeof(*pProperties));
+    snprintf(pProperties->deviceName, sizeof(pProperties->deviceName), "CapFrameX Bench Stub");
+    pProperties->limits.timestampPeriod = 1.0f;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_GetPhysicalDeviceQueueFamilyProperties(
+    VkPhysicalDevice physicalDevice, uint32_t* pCount, VkQueueFamilyProperties* pProperties) {
+    (void)physicalDevice;
+    if (pProperties && *pCount > 0) {
+        memset(pProperties, 0, sizeof(*pProperties));
+        pProperties[0].queueFlags = VK_QUEUE_GRAPHICS_BIT;
+        pProperties[0].queueCount = BENCH_MAX_THREADS;
+        pProperties[0].timestampValidBits = 64;
+    }
+    *pCount = 1;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_EnumerateDeviceExtensionProperties(
+    VkPhysicalDevice physicalDevice, const char* pLayerName, uint32_t* pCount, VkExtensionProperties* pProperties) {
+    (void)physicalDevice;
+    (void)pLayerName;
+    uint32_t available = stub_google_display_timing ? 2 : 1;
+    if (!pProperties) {
+        *pCount = available;
+        return VK_SUCCESS;
+    }
+
+    uint32_t count = *pCount < available ? *pCount : available;
+    const char* names[2] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME };
+    for (uint32_t i = 0; i < count; i++) {
+        memset(&pProperties[i], 0, sizeof(pProperties[i]));
+        snprintf(pProperties[i].extensionName, sizeof(pProperties[i].extensionName), "%s", names[i]);
+        pProperties[i].specVersion = 1;
+    }
+    *pCount = count;
+    return count < available ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_CreateDevice(
+    VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo,
+    const VkAllocationCallbacks* pAllocator, VkDevice* pDevice) {
+    (void)physicalDevice;
+    (void)pCreateInfo;
+    (void)pAllocator;
+    *pDevice = (VkDevice)&stub_device;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_DestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator) {
+    (void)device;
+    (void)pAllocator;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_GetDeviceQueue(
+    VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue) {
+    (void)device;
+    (void)queueFamilyIndex;
+    stub_queues[queueIndex].loader_data = &device_dispatch_tag;
+    *pQueue = (VkQueue)&stub_queues[queueIndex];
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_CreateSwapchainKHR(
+    VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo,
+    const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain) {
+    (void)device;
+    (void)pCreateInfo;
+    (void)pAllocator;
+    uint32_t index = atomic_fetch_add(&stub_swapchain_count, 1);
+    if (index >= BENCH_MAX_THREADS) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    memset(&stub_swapchains[index], 0, sizeof(StubSwapchain));
+    *pSwapchain = (VkSwapchainKHR)(uintptr_t)&stub_swapchains[index];
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL stub_DestroySwapchainKHR(
+    VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator) {
+    (void)device;
+    (void)swapchain;
+    (void)pAllocator;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_AcquireNextImageKHR(
+    VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout,
+    VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex) {
+    (void)device;
+    (void)timeout;
+    (void)semaphore;
+    (void)fence;
+    StubSwapchain* sc = (StubSwapchain*)(uintptr_t)swapchain;
+    *pImageIndex = sc->next_image;
+    sc->next_image = (sc->next_image + 1) % BENCH_IMAGE_COUNT;
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR* pPresentInfo) {
+    (void)queue;
+
+    const VkPresentTimesInfoGOOGLE* times = NULL;
+    for (const VkBaseInStructure* s = pPresentInfo->pNext; s; s = s->pNext) {
+        if (s->sType == VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE) {
+            times = (const VkPresentTimesInfoGOOGLE*)s;
+        }
+    }
+
+    uint64_t now = bench_now_ns();
+    for (uint32_t i = 0; i < pPresentInfo->swapchainCount; i++) {
+        StubSwapchain* sc = (StubSwapchain*)(uintptr_t)pPresentInfo->pSwapchains[i];
+        uint32_t slot = sc->present_count % STUB_TIMING_HISTORY;
+        sc->present_ids[slot] = (times && i < times->swapchainCount) ? times->pTimes[i].presentID : 0;
+        sc->present_times[slot] = now;
+        sc->present_count++;
+    }
+    return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_GetPastPresentationTimingGOOGLE(
+    VkDevice device, VkSwapchainKHR swapchain, uint32_t* pCount, VkPastPresentationTimingGOOGLE* pTimings) {
+    (void)device;
+    StubSwapchain* sc = (StubSwapchain*)(uintptr_t)swapchain;
+
+    uint64_t ready = sc->present_count > STUB_TIMING_LAG ? sc->present_count - STUB_TIMING_LAG : 0;
+    if (ready - sc->reported_count > STUB_TIMING_HISTORY) {
+        sc->reported_count = ready - STUB_TIMING_HISTORY;
+    }
+    uint32_t available = (uint32_t)(ready - sc->reported_count);
+    if (!pTimings) {
+        *pCount = available;
+        return VK_SUCCESS;
+    }
+
+    uint32_t count = *pCount < available ? *pCount : available;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t slot = (sc->reported_count + i) % STUB_TIMING_HISTORY;
+        pTimings[i] = (VkPastPresentationTimingGOOGLE){
+            .presentID = (uint32_t)sc->present_ids[slot],
+            .desiredPresentTime = 0,
+            .actualPresentTime = sc->present_times[slot] + 1000000,
+            .earliestPresentTime = sc->present_times[slot] + 1000000,
+            .presentMargin = 0
+        };
+    }
+    sc->reported_count += count;
+    *pCount = count;
+    return count < available ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stub_GetDeviceProcAddr(VkDevice device, const char* pName);
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stub_GetInstanceProcAddr(VkInstance instance, const char* pName) {
+#define STUB_PROC(name) \
+    if (strcmp(pName, "vk" #name) == 0) return (PFN_vkVoidFunction)stub_##name
+
+    STUB_PROC(GetInstanceProcAddr);
+    STUB_PROC(CreateInstance);
+    STUB_PROC(DestroyInstance);
+    STUB_PROC(EnumeratePhysicalDevices);
+    STUB_PROC(GetPhysicalDeviceProperties);
+    STUB_PROC(GetPhysicalDeviceQueueFamilyProperties);
+    STUB_PROC(EnumerateDeviceExtensionProperties);
+    STUB_PROC(CreateDevice);
+
+#undef STUB_PROC
+
+    return instance ? stub_GetDeviceProcAddr((VkDevice)&stub_device, pName) : NULL;
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stub_GetDeviceProcAddr(VkDevice device, const char* pName) {
+    (void)device;
+
+#define STUB_PROC(name) \
+    if (strcmp(pName, "vk" #name) == 0) return (PFN_vkVoidFunction)stub_##name
+
+    STUB_PROC(GetDeviceProcAddr);
+    STUB_PROC(DestroyDevice);
+    STUB_PROC(GetDeviceQueue);
+    STUB_PROC(CreateSwapchainKHR);
+    STUB_PROC(DestroySwapchainKHR);
+    STUB_PROC(AcquireNextImageKHR);
+    STUB_PROC(QueuePresentKHR);
+    if (stub_google_display_timing) {
+        STUB_PROC(GetPastPresentationTimingGOOGLE);
+    }
+
+#undef STUB_PROC
+
+    return NULL;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL stub_SetDeviceLoaderData(VkDevice device, void* object) {
+    (void)device;
+    ((StubDispatchable*)object)->loader_data = &device_dispatch_tag;
+    return VK_SUCCESS;
+}
+
+// ============================================================================
+// Daemon sink
+// ============================================================================
+
+// Accepts the layer's connection and discards everything it sends, so the
+// streaming path is measured without a real daemon
+static int sink_listen_fd = -1;
+
+static void* sink_thread_func(void* arg) {
+    (void)arg;
+    int fd = accept(sink_listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    char buffer[65536];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
+    }
+    close(fd);
+    return NULL;
+}
+
+static bool start_sink(const char* dir, pthread_t* thread) {
+    // Same path the layer derives from HOME (see ipc_client.c)
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+#if CAPFRAMEX_SOCKET_USE_HOME
+    snprintf(path, sizeof(path), "%s/.config", dir);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/.config/capframex", dir);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/.config/capframex/%s", dir, CAPFRAMEX_SOCKET_NAME);
+#else
+    snprintf(path, sizeof(path), "%s/%s", dir, CAPFRAMEX_SOCKET_NAME);
+#endif
+    unlink(path);
+
+    sink_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sink_listen_fd < 0) {
+        return false;
+    }
+
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    if (bind(sink_listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(sink_listen_fd, 1) < 0) {
+        fprintf(stderr, "layer_bench: can't listen on %s: %s\n", path, strerror(errno));
+        close(sink_listen_fd);
+        return false;
+    }
+
+    return pthread_create(thread, NULL, sink_thread_func, NULL) == 0;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+typedef struct {
+    PFN_vkAcquireNextImageKHR AcquireNextImageKHR;
+    PFN_vkQueuePresentKHR QueuePresentKHR;
+    VkDevice device;
+    VkQueue queue;
+    VkSwapchainKHR swapchain;
+    uint64_t presents;
+    pthread_barrier_t* start_barrier;
+    uint64_t elapsed_ns;
+} BenchThread;
+
+static void present_loop(BenchThread* t, uint64_t count) {
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t image_index = 0;
+        t->AcquireNextImageKHR(t->device, t->swapchain, UINT64_MAX, VK_NULL_HANDLE, VK_NULL_HANDLE, &image_index);
+
+        VkPresentInfoKHR present_info = {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .swapchainCount = 1,
+            .pSwapchains = &t->swapchain,
+            .pImageIndices = &image_index
+        };
+        t->QueuePresentKHR(t->queue, &present_info);
+    }
+}
+
+static void* bench_thread_func(void* arg) {
+    BenchThread* t = arg;
+
+    present_loop(t, BENCH_WARMUP_PRESENTS);
+    pthread_barrier_wait(t->start_barrier);
+
+    uint64_t start = bench_now_ns();
+    present_loop(t, t->presents);
+    t->elapsed_ns = bench_now_ns() - start;
+    return NULL;
+}
+
+// Run one round of presents on every thread, returns the slowest thread's time
+static uint64_t run_round(BenchThread* threads, uint32_t thread_count, bool count_calls) {
+    pthread_t handles[BENCH_MAX_THREADS];
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, thread_count + 1);
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        threads[i].start_barrier = &barrier;
+        pthread_create(&handles[i], NULL, bench_thread_func, &threads[i]);
+    }
+
+    // Warm-up done everywhere - start counting
+    pthread_barrier_wait(&barrier);
+    atomic_store(&counting, count_calls);
+
+    uint64_t slowest = 0;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        pthread_join(handles[i], NULL);
+        if (threads[i].elapsed_ns > slowest) {
+            slowest = threads[i].elapsed_ns;
+        }
+    }
+
+    atomic_store(&counting, false);
+    pthread_barrier_destroy(&barrier);
+    return slowest;
+}
+
+static void print_usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [options] <path/to/libcapframex_layer.so>\n"
+            "  -n, --presents N      presents per thread (default 1000000)\n"
+            "  -t, --threads N       presenting threads, one swapchain each (default 1)\n"
+            "  -g, --display-timing  advertise VK_GOOGLE_display_timing in the stub\n"
+            "  -d, --daemon-sink     stream frames to a socket that discards them\n"
+            "      --max-ns N        fail if the layer adds more than N ns per present\n"
+            "      --max-allocs N    fail if there are more than N allocations per present\n",
+            argv0);
+}
+
+int main(int argc, char** argv) {
+    uint64_t presents = 1000000;
+    uint32_t thread_count = 1;
+    bool daemon_sink = false;
+    double max_ns = -1.0;
+    double max_allocs = -1.0;
+
+    static const struct option options[] = {
+        { "presents", required_argument, NULL, 'n' },
+        { "threads", required_argument, NULL, 't' },
+        { "display-timing", no_argument, NULL, 'g' },
+        { "daemon-sink", no_argument, NULL, 'd' },
+        { "max-ns", required_argument, NULL, 'N' },
+        { "max-allocs", required_argument, NULL, 'A' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:t:gdh", options, NULL)) != -1) {
+        switch (opt) {
+            case 'n': presents = strtoull(optarg, NULL, 10); break;
+            case 't': thread_count = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'g': stub_google_display_timing = true; break;
+            case 'd': daemon_sink = true; break;
+            case 'N': max_ns = strtod(optarg, NULL); break;
+            case 'A': max_allocs = strtod(optarg, NULL); break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || presents == 0 || thread_count == 0 || thread_count > BENCH_MAX_THREADS) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // Object to function pointer casts via memcpy keep -Wpedantic quiet
+    void* sym = dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    memcpy(&real_mutex_lock, &sym, sizeof(sym));
+    if (!real_mutex_lock) {
+        fprintf(stderr, "layer_bench: can't resolve pthread_mutex_lock\n");
+        return 1;
+    }
+
+    // Keep the layer away from a real daemon: it finds the socket via HOME
+    char home[] = "/tmp/capframex-bench-XXXXXX";
+    if (!mkdtemp(home)) {
+        fprintf(stderr, "layer_bench: mkdtemp failed: %s\n", strerror(errno));
+        return 1;
+    }
+    setenv("HOME", home, 1);
+    setenv("XDG_RUNTIME_DIR", home, 1);
+
+    pthread_t sink_thread;
+    if (daemon_sink && !start_sink(home, &sink_thread)) {
+        return 1;
+    }
+
+    void* layer = dlopen(argv[optind], RTLD_NOW | RTLD_LOCAL);
+    if (!layer) {
+        fprintf(stderr, "layer_bench: %s\n", dlerror());
+        return 1;
+    }
+
+    PFN_vkNegotiateLoaderLayerInterfaceVersion negotiate;
+    sym = dlsym(layer, "vkNegotiateLoaderLayerInterfaceVersion");
+    memcpy(&negotiate, &sym, sizeof(sym));
+    VkNegotiateLayerInterface interface = {
+        .sType = LAYER_NEGOTIATE_INTERFACE_STRUCT,
+        .loaderLayerInterfaceVersion = 2
+    };
+    if (!negotiate || negotiate(&interface) != VK_SUCCESS) {
+        fprintf(stderr, "layer_bench: layer interface negotiation failed\n");
+        return 1;
+    }
+
+    // Instance
+    VkLayerInstanceLink instance_link = { .pfnNextGetInstanceProcAddr = stub_GetInstanceProcAddr };
+    VkLayerInstanceCreateInfo instance_chain = {
+        .sType = VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO,
+        .function = VK_LAYER_LINK_INFO,
+        .u.pLayerInfo = &instance_link
+    };
+    VkInstanceCreateInfo instance_info = {
+        .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext = &instance_chain
+    };
+    PFN_vkCreateInstance layer_CreateInstance =
+        (PFN_vkCreateInstance)interface.pfnGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+    VkInstance instance;
+    uint64_t create_start = bench_now_ns();
+    if (!layer_CreateInstance || layer_CreateInstance(&instance_info, NULL, &instance) != VK_SUCCESS) {
+        fprintf(stderr, "layer_bench: vkCreateInstance failed\n");
+        return 1;
+    }
+    uint64_t create_instance_ns = bench_now_ns() - create_start;
+
+    // Device
+    VkLayerDeviceLink device_link = {
+        .pfnNextGetInstanceProcAddr = stub_GetInstanceProcAddr,
+        .pfnNextGetDeviceProcAddr = stub_GetDeviceProcAddr
+    };
+    VkLayerDeviceCreateInfo loader_data_info = {
+        .sType = VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,
+        .function = VK_LOADER_DATA_CALLBACK,
+        .u.pfnSetDeviceLoaderData = stub_SetDeviceLoaderData
+    };
+    VkLayerDeviceCreateInfo device_chain = {
+        .sType = VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO,
+        .pNext = &loader_data_info,
+        .function = VK_LAYER_LINK_INFO,
+        .u.pLayerInfo = &device_link
+    };
+    const char* device_exts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    VkDeviceCreateInfo device_info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = &device_chain,
+        .enabledExtensionCount = 1,
+        .ppEnabledExtensionNames = device_exts
+    };
+    PFN_vkCreateDevice layer_CreateDevice =
+        (PFN_vkCreateDevice)interface.pfnGetInstanceProcAddr(instance, "vkCreateDevice");
+    VkDevice device;
+    if (!layer_CreateDevice ||
+        layer_CreateDevice((VkPhysicalDevice)&stub_physical_device, &device_info, NULL, &device) != VK_SUCCESS) {
+        fprintf(stderr, "layer_bench: vkCreateDevice failed\n");
+        return 1;
+    }
+
+    PFN_vkGetDeviceQueue GetDeviceQueue =
+        (PFN_vkGetDeviceQueue)interface.pfnGetDeviceProcAddr(device, "vkGetDeviceQueue");
+    PFN_vkCreateSwapchainKHR CreateSwapchainKHR =
+        (PFN_vkCreateSwapchainKHR)interface.pfnGetDeviceProcAddr(device, "vkCreateSwapchainKHR");
+    PFN_vkDestroySwapchainKHR DestroySwapchainKHR =
+        (PFN_vkDestroySwapchainKHR)interface.pfnGetDeviceProcAddr(device, "vkDestroySwapchainKHR");
+    PFN_vkDestroyDevice DestroyDevice =
+        (PFN_vkDestroyDevice)interface.pfnGetDeviceProcAddr(device, "vkDestroyDevice");
+    PFN_vkDestroyInstance DestroyInstance =
+        (PFN_vkDestroyInstance)interface.pfnGetInstanceProcAddr(instance, "vkDestroyInstance");
+
+    // One queue and swapchain per thread, driven through the layer and,
+    // for the baseline, straight through the stub
+    BenchThread layer_threads[BENCH_MAX_THREADS];
+    BenchThread stub_threads[BENCH_MAX_THREADS];
+    for (uint32_t i = 0; i < thread_count; i++) {
+        VkQueue queue;
+        GetDeviceQueue(device, 0, i, &queue);
+
+        VkSwapchainCreateInfoKHR swapchain_info = {
+            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .minImageCount = BENCH_IMAGE_COUNT,
+            .imageFormat = VK_FORMAT_B8G8R8A8_UNORM,
+            .imageExtent = { 1920, 1080 },
+            .imageArrayLayers = 1,
+            .presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR
+        };
+        VkSwapchainKHR swapchain;
+        if (CreateSwapchainKHR(device, &swapchain_info, NULL, &swapchain) != VK_SUCCESS) {
+            fprintf(stderr, "layer_bench: vkCreateSwapchainKHR failed\n");
+            return 1;
+        }
+
+        layer_threads[i] = (BenchThread){
+            .AcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)
+                interface.pfnGetDeviceProcAddr(device, "vkAcquireNextImageKHR"),
+            .QueuePresentKHR = (PFN_vkQueuePresentKHR)
+                interface.pfnGetDeviceProcAddr(device, "vkQueuePresentKHR"),
+            .device = device,
+            .queue = queue,
+            .swapchain = swapchain,
+            .presents = presents
+        };
+        stub_threads[i] = layer_threads[i];
+        stub_threads[i].AcquireNextImageKHR = stub_AcquireNextImageKHR;
+        stub_threads[i].QueuePresentKHR = stub_QueuePresentKHR;
+    }
+
+    uint64_t stub_ns = run_round(stub_threads, thread_count, false);
+    uint64_t layer_ns = run_round(layer_threads, thread_count, true);
+
+    uint64_t total_presents = presents * thread_count;
+    double stub_per_present = (double)stub_ns / (double)presents;
+    double layer_per_present = (double)layer_ns / (double)presents;
+    double overhead = layer_per_present - stub_per_present;
+    double allocs_per_present = (double)atomic_load(&alloc_count) / (double)total_presents;
+
+    printf("presents:            %llu (%u thread%s, display timing %s, daemon %s)\n",
+           (unsigned long long)total_presents, thread_count, thread_count == 1 ? "" : "s",
+           stub_google_display_timing ? "on" : "off", daemon_sink ? "sink" : "none");
+    printf("ns/present:          %.1f (stub %.1f, layer overhead %.1f)\n",
+           layer_per_present, stub_per_present, overhead);
+    printf("allocations/present: %.4f (%lu total)\n", allocs_per_present, atomic_load(&alloc_count));
+    printf("mutex locks/present: %.4f (%lu total, %lu contended)\n",
+           (double)atomic_load(&lock_count) / (double)total_presents,
+           atomic_load(&lock_count), atomic_load(&contended_count));
+    printf("vkCreateInstance:    %.1f us (layer init included)\n", (double)create_instance_ns / 1000.0);
+
+    for (uint32_t i = 0; i < thread_count; i++) {
+        DestroySwapchainKHR(device, layer_threads[i].swapchain, NULL);
+    }
+    DestroyDevice(device, NULL);
+    DestroyInstance(instance, NULL);
+
+    if (daemon_sink) {
+        shutdown(sink_listen_fd, SHUT_RDWR);
+        close(sink_listen_fd);
+    }
+
+    int status = 0;
+    if (max_ns >= 0.0 && overhead > max_ns) {
+        fprintf(stderr, "layer_bench: %.1f ns/present overhead exceeds %.1f\n", overhead, max_ns);
+        status = 1;
+    }
+    if (max_allocs >= 0.0 && allocs_per_present > max_allocs) {
+        fprintf(stderr, "layer_bench: %.4f allocations/present exceeds %.4f\n", allocs_per_present, max_allocs);
+        status = 1;
+    }
+    return status;
+}
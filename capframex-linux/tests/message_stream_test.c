@@ -0,0 +1,155 @@
+// Test for the IPC message stream decoder.
+//
+// A stream of messages with varied payload sizes is fed to the decoder cut
+// at every possible position, then in random-sized reads, and the messages
+// it dispatches must match what was encoded byte for byte. Oversized
+// messages must be reported as a corrupt stream.
+
+#define _GNU_SOURCE
+#include "message_stream.h"
+#include "test_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESSAGE_COUNT 200
+
+static char* stream_data;
+static size_t stream_size;
+static size_t message_offsets[MESSAGE_COUNT];
+
+typedef struct {
+    size_t received;
+    size_t mismatched;
+} Decoded;
+
+// Message i has type i and a payload of bytes (i + j) & 0xff. Sizes cover
+// empty payloads, frame batches and one message near the limit.
+static uint32_t payload_size_of(size_t i) {
+    if (i == MESSAGE_COUNT / 2) return MESSAGE_STREAM_MAX_MESSAGE - sizeof(MessageHeader);
+    return (uint32_t)((i * 37) % 700);
+}
+
+static void build_stream(void) {
+    stream_size = 0;
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        stream_size += sizeof(MessageHeader) + payload_size_of(i);
+    }
+    stream_data = malloc(stream_size);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        MessageHeader header = { .type = (uint32_t)i, .payload_size = payload_size_of(i),
+                                 .timestamp = i * 1000 };
+        message_offsets[i] = offset;
+        memcpy(stream_data + offset, &header, sizeof(header));
+        offset += sizeof(header);
+        for (uint32_t j = 0; j < header.payload_size; j++) {
+            stream_data[offset++] = (char)((i + j) & 0xff);
+        }
+    }
+}
+
+static void on_message(void* context, char* message, size_t len) {
+    Decoded* decoded = context;
+    size_t i = decoded->received++;
+    if (i >= MESSAGE_COUNT) {
+        decoded->mismatched++;
+        return;
+    }
+    size_t expected = sizeof(MessageHeader) + payload_size_of(i);
+    if (len != expected || memcmp(message, stream_data + message_offsets[i], len) != 0) {
+        decoded->mismatched++;
+    }
+}
+
+// Feed the stream as reads of the given sizes (the last one takes the rest)
+static Decoded feed_in_reads(MessageStream* stream, const size_t* cuts, size_t cut_count) {
+    Decoded decoded = {0};
+    size_t offset = 0;
+    for (size_t c = 0; c <= cut_count && offset < stream_size; c++) {
+        size_t len = c < cut_count ? cuts[c] : stream_size - offset;
+        if (len > stream_size - offset) len = stream_size - offset;
+        CHECK(message_stream_feed(stream, stream_data + offset, len, on_message, &decoded),
+              "feed rejected a valid stream at %zu", offset);
+        offset += len;
+    }
+    return decoded;
+}
+
+static void test_every_split(void) {
+    MessageStream stream;
+    message_stream_init(&stream);
+
+    // One cut anywhere in the first few messages, plus a single huge read
+    size_t bad = 0;
+    for (size_t cut = 0; cut <= message_offsets[8]; cut++) {
+        Decoded decoded = feed_in_reads(&stream, &cut, 1);
+        if (decoded.received != MESSAGE_COUNT || decoded.mismatched != 0) bad++;
+        CHECK(stream.partial_len == 0, "bytes left over after cut %zu", cut);
+    }
+    CHECK(bad == 0, "%zu split positions decoded wrongly", bad);
+
+    message_stream_free(&stream);
+}
+
+static void test_random_reads(void) {
+    MessageStream stream;
+    message_stream_init(&stream);
+    srand(1234);
+
+    size_t cuts[4096];
+    for (int round = 0; round < 200; round++) {
+        // Mostly tiny reads (header cut in pieces), sometimes 64 KB ones
+        size_t count = 0;
+        for (size_t total = 0; total < stream_size && count < 4096; count++) {
+            cuts[count] = (rand() % 8 == 0) ? (size_t)(rand() % MESSAGE_STREAM_READ_SIZE) + 1
+                                             : (size_t)(rand() % 40) + 1;
+            total += cuts[count];
+        }
+        Decoded decoded = feed_in_reads(&stream, cuts, count);
+        CHECK(decoded.received == MESSAGE_COUNT && decoded.mismatched == 0,
+              "round %d: %zu messages, %zu mismatched", round, decoded.received,
+              decoded.mismatched);
+    }
+
+    message_stream_free(&stream);
+}
+
+static void test_oversized(void) {
+    MessageStream stream;
+    message_stream_init(&stream);
+    Decoded decoded = {0};
+
+    MessageHeader header = { .type = MSG_FRAMETIME_BATCH,
+                             .payload_size = MESSAGE_STREAM_MAX_MESSAGE };
+    char bytes[sizeof(header) + 8] = {0};
+    memcpy(bytes, &header, sizeof(header));
+    CHECK(!message_stream_feed(&stream, bytes, sizeof(bytes), on_message, &decoded),
+          "oversized message accepted");
+
+    // Same when only the header arrives and it is completed across reads
+    message_stream_reset(&stream);
+    CHECK(message_stream_feed(&stream, bytes, 5, on_message, &decoded), "header start rejected");
+    CHECK(!message_stream_feed(&stream, bytes + 5, sizeof(header) - 5, on_message, &decoded),
+          "oversized message accepted across reads");
+    CHECK(decoded.received == 0, "oversized message dispatched");
+
+    message_stream_free(&stream);
+}
+
+int main(void) {
+    build_stream();
+    test_every_split();
+    test_random_reads();
+    test_oversized();
+    free(stream_data);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("message stream: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Test for the daemon's per-client output queue.
+//
+// Messages go into one end of a socketpair whose other end is not read, so
+// the socket fills and the queue takes over. The test checks that frame
+// messages are dropped oldest first, superseded state messages are
+// coalesced, control messages survive, and that once the reader catches up
+// it sees an intact message stream with nothing torn.
+
+#define _GNU_SOURCE
+#include "output_queue.h"
+#include "test_check.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define UPDATE_INTERVAL 1000
+
+static OutputResult send_frame(OutputQueue* queue, int fd, uint64_t frame_number) {
+    FrameDataPoint frame = { .frame_number = frame_number, .pid = 1 };
+    MessageHeader header = { .type = MSG_FRAMETIME_DATA, .payload_size = sizeof(frame) };
+    return output_queue_send(queue, fd, &header, &frame);
+}
+
+static OutputResult send_game_update(OutputQueue* queue, int fd, int32_t pid, uint32_t width) {
+    GameDetectedPayload info = { .pid = pid, .resolution_width = width };
+    MessageHeader header = { .type = MSG_GAME_UPDATED, .payload_size = sizeof(info) };
+    return output_queue_send(queue, fd, &header, &info);
+}
+
+static OutputResult send_pong(OutputQueue* queue, int fd) {
+    MessageHeader header = { .type = MSG_PONG, .payload_size = 0 };
+    return output_queue_send(queue, fd, &header, NULL);
+}
+
+// Read len bytes, flushing the queue whenever the socket runs dry
+static void read_exact(OutputQueue* queue, int writer, int reader, void* buffer, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = recv(reader, (char*)buffer + done, len - done, 0);
+        if (n > 0) {
+            done += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN && !output_queue_empty(queue) &&
+            output_queue_flush(queue, writer) != OUTPUT_ERROR) {
+            continue;
+        }
+        CHECK(0, "stream ended after %zu of %zu bytes", done, len);
+        memset(buffer, 0, len);
+        return;
+    }
+}
+
+static MessageHeader read_message(OutputQueue* queue, int writer, int reader, char* payload) {
+    MessageHeader header;
+    read_exact(queue, writer, reader, &header, sizeof(header));
+    if (header.payload_size > 0) {
+        read_exact(queue, writer, reader, payload, header.payload_size);
+    }
+    return header;
+}
+
+static void test_backpressure(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0) {
+        CHECK(0, "socketpair: %s", strerror(errno));
+        return;
+    }
+    OutputQueue queue;
+    output_queue_init(&queue);
+
+    // A pong, then far more frames than fit with a game update every so often
+    CHECK(send_pong(&queue, sv[0]) <= OUTPUT_QUEUED, "pong");
+
+    const uint64_t frames = 3 * OUTPUT_QUEUE_SIZE / (sizeof(MessageHeader) + sizeof(FrameDataPoint));
+    for (uint64_t i = 0; i < frames; i++) {
+        CHECK(send_frame(&queue, sv[0], i) <= OUTPUT_QUEUED, "frame %llu", (unsigned long long)i);
+        if (i % UPDATE_INTERVAL == 0) {
+            CHECK(send_game_update(&queue, sv[0], 7, (uint32_t)i + 1) <= OUTPUT_QUEUED, "update");
+        }
+    }
+    const uint64_t sent_updates = (frames + UPDATE_INTERVAL - 1) / UPDATE_INTERVAL;
+    const uint32_t last_update = (uint32_t)((sent_updates - 1) * UPDATE_INTERVAL) + 1;
+
+    CHECK(!output_queue_empty(&queue), "nothing queued behind a stalled reader");
+    CHECK(queue.used <= OUTPUT_QUEUE_SIZE, "queue overran: %zu", queue.used);
+    CHECK(queue.dropped_frames > 0 && queue.dropped_frames == queue.dropped_messages,
+          "dropped %llu frames in %llu messages", (unsigned long long)queue.dropped_frames,
+          (unsigned long long)queue.dropped_messages);
+
+    // Read everything back and check the stream
+    static char payload[64 * 1024];
+    uint64_t frames_read = 0, last_frame = 0, updates = 0, pongs = 0;
+    uint32_t last_width = 0;
+    bool ordered = true, seen_frame = false;
+    while (!output_queue_empty(&queue) || frames_read + queue.dropped_frames < frames ||
+           last_width != last_update) {
+        MessageHeader header = read_message(&queue, sv[0], sv[1], payload);
+        if (header.type == MSG_FRAMETIME_DATA) {
+            FrameDataPoint frame;
+            memcpy(&frame, payload, sizeof(frame));
+            if (seen_frame && frame.frame_number <= last_frame) ordered = false;
+            seen_frame = true;
+            last_frame = frame.frame_number;
+            frames_read++;
+        } else if (header.type == MSG_GAME_UPDATED) {
+            GameDetectedPayload info;
+            memcpy(&info, payload, sizeof(info));
+            CHECK(info.pid == 7, "game update pid %d", info.pid);
+            last_width = info.resolution_width;
+            updates++;
+        } else if (header.type == MSG_PONG) {
+            pongs++;
+        } else {
+            CHECK(0, "unexpected message type %u size %u", header.type, header.payload_size);
+            break;
+        }
+    }
+
+    CHECK(ordered, "frames out of order");
+    CHECK(last_frame == frames - 1, "newest frame %llu was not delivered", (unsigned long long)last_frame);
+    CHECK(frames_read + queue.dropped_frames == frames, "read %llu + dropped %llu != %llu",
+          (unsigned long long)frames_read, (unsigned long long)queue.dropped_frames,
+          (unsigned long long)frames);
+    CHECK(pongs == 1, "pong delivered %llu times", (unsigned long long)pongs);
+    CHECK(updates + queue.coalesced_messages == sent_updates, "updates %llu + coalesced %llu != %llu",
+          (unsigned long long)updates, (unsigned long long)queue.coalesced_messages,
+          (unsigned long long)sent_updates);
+    CHECK(queue.coalesced_messages > 0, "no state message was coalesced");
+    CHECK(output_queue_empty(&queue) && queue.data == NULL, "queue not released after draining");
+
+    printf("backpressure: %llu frames sent, %llu delivered, %llu dropped, %llu coalesced\n",
+           (unsigned long long)frames, (unsigned long long)frames_read,
+           (unsigned long long)queue.dropped_frames, (unsigned long long)queue.coalesced_messages);
+
+    output_queue_free(&queue);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+// A message that does not fit even after dropping every frame is refused
+static void test_overflow(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0) {
+        CHECK(0, "socketpair: %s", strerror(errno));
+        return;
+    }
+
+    OutputQueue queue;
+    output_queue_init(&queue);
+
+    OutputResult result = OUTPUT_SENT;
+    size_t pongs = 0;
+    while (result != OUTPUT_OVERFLOW && pongs < 2 * OUTPUT_QUEUE_SIZE) {
+        result = send_pong(&queue, sv[0]);
+        pongs++;
+    }
+    CHECK(result == OUTPUT_OVERFLOW, "control messages never overflowed");
+    CHECK(queue.dropped_messages == 1 && queue.dropped_frames == 0,
+          "overflow counted %llu messages, %llu frames", (unsigned long long)queue.dropped_messages,
+          (unsigned long long)queue.dropped_frames);
+
+    // A closed peer is an error, not a backlog
+    close(sv[1]);
+    CHECK(output_queue_flush(&queue, sv[0]) == OUTPUT_ERROR, "flush to a closed peer");
+
+    output_queue_free(&queue);
+    close(sv[0]);
+}
+
+int main(void) {
+    test_backpressure();
+    test_overflow();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("output queue: all checks passed\n");
+    return 0;
+}
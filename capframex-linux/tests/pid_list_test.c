@@ -0,0 +1,160 @@
+// Test for the shared PID list seqlock and its reader library.
+//
+// A writer thread keeps replacing the list with generations whose entries
+// all encode the generation number, while the reader checks every snapshot
+// it gets is one whole generation. Then the library reads a list in a
+// test-only shm object and follows it when it is unlinked and recreated,
+// like a daemon restart.
+
+#define _GNU_SOURCE
+#include "capframex_pids.h"
+#include "pid_list.h"
+#include "test_check.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define STRESS_GENERATIONS 200000
+
+static SharedPidList stress_list;
+static atomic_bool writer_done = false;
+
+// Generation g has (g % 200) + 1 entries, pid g * 1000 + i, flags g
+static void fill_generation(uint32_t g, SharedPidEntry* entries, uint32_t* count) {
+    *count = (g % 200) + 1;
+    for (uint32_t i = 0; i < *count; i++) {
+        entries[i].pid = (pid_t)(g * 1000 + i);
+        entries[i].flags = g;
+    }
+}
+
+static void* writer_thread(void* arg) {
+    (void)arg;
+    SharedPidEntry entries[MAX_TRACKED_PROCESSES];
+    for (uint32_t g = 1; g <= STRESS_GENERATIONS; g++) {
+        uint32_t count;
+        fill_generation(g, entries, &count);
+        pid_list_write(&stress_list, entries, count);
+    }
+    atomic_store(&writer_done, true);
+    return NULL;
+}
+
+static void test_seqlock_stress(void) {
+    stress_list.magic = SHARED_PID_LIST_MAGIC;
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, writer_thread, NULL);
+
+    SharedPidEntry snapshot[MAX_TRACKED_PROCESSES];
+    uint64_t reads = 0, torn = 0, retries_exhausted = 0;
+    uint32_t last_version = 0;
+    while (!atomic_load(&writer_done)) {
+        uint32_t version;
+        int n = pid_list_read(&stress_list, snapshot, MAX_TRACKED_PROCESSES, &version);
+        if (n < 0) {
+            retries_exhausted++;
+            continue;
+        }
+        reads++;
+        CHECK((version & 1) == 0, "odd version %u returned", version);
+        CHECK(version >= last_version, "version went back %u -> %u", last_version, version);
+        last_version = version;
+        if (n == 0) continue;
+
+        uint32_t g = snapshot[0].flags;
+        bool whole = (uint32_t)n == (g % 200) + 1;
+        for (int i = 0; whole && i < n; i++) {
+            whole = snapshot[i].flags == g && snapshot[i].pid == (pid_t)(g * 1000 + (uint32_t)i);
+        }
+        if (!whole) torn++;
+    }
+    pthread_join(writer, NULL);
+
+    CHECK(torn == 0, "%llu of %llu snapshots mixed generations",
+          (unsigned long long)torn, (unsigned long long)reads);
+    CHECK(stress_list.version == 2u * STRESS_GENERATIONS, "final version %u", stress_list.version);
+    printf("seqlock: %llu snapshots, %llu torn, %llu gave up\n", (unsigned long long)reads,
+           (unsigned long long)torn, (unsigned long long)retries_exhausted);
+}
+
+// Create the list like the daemon does, with one entry
+static SharedPidList* create_list(const char* name, int* fd, pid_t pid, uint32_t flags) {
+    *fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (*fd < 0 || ftruncate(*fd, sizeof(SharedPidList)) != 0) {
+        return NULL;
+    }
+    SharedPidList* list = mmap(NULL, sizeof(SharedPidList), PROT_READ | PROT_WRITE,
+                               MAP_SHARED, *fd, 0);
+    if (list == MAP_FAILED) {
+        return NULL;
+    }
+    list->magic = SHARED_PID_LIST_MAGIC;
+    SharedPidEntry entry = { .pid = pid, .flags = flags };
+    pid_list_write(list, &entry, 1);
+    return list;
+}
+
+static void test_reader_library(void) {
+    char name[64];
+    snprintf(name, sizeof(name), "/capframex_pids_test_%d", getpid());
+
+    CapFrameXPids* pids = capframex_pids_open(name);
+    CHECK(pids != NULL, "open failed");
+    if (!pids) return;
+
+    CapFrameXPid out[4];
+    CHECK(capframex_pids_read(pids, out, 4, NULL) == -1, "read without a list should fail");
+    CHECK(capframex_pids_lookup(pids, 42) == 0, "lookup without a list should be 0");
+
+    int fd;
+    SharedPidList* list = create_list(name, &fd, 42, CAPFRAMEX_PID_DETECTED | CAPFRAMEX_PID_LAYER);
+    CHECK(list != NULL, "creating %s failed", name);
+    if (!list) {
+        capframex_pids_close(pids);
+        return;
+    }
+
+    uint32_t version = 0;
+    int n = capframex_pids_read(pids, out, 4, &version);
+    CHECK(n == 1 && out[0].pid == 42 && version == 2, "read n=%d pid=%d version=%u",
+          n, n > 0 ? out[0].pid : 0, version);
+    CHECK(capframex_pids_lookup(pids, 42) == (CAPFRAMEX_PID_DETECTED | CAPFRAMEX_PID_LAYER),
+          "lookup flags");
+    CHECK(capframex_pids_lookup(pids, 43) == 0, "unlisted pid");
+
+    // Daemon restart: the old object is unlinked, a new one takes the name
+    shm_unlink(name);
+    munmap(list, sizeof(SharedPidList));
+    close(fd);
+    CHECK(capframex_pids_lookup(pids, 42) == 0, "unlinked list still read");
+
+    list = create_list(name, &fd, 77, CAPFRAMEX_PID_LAYER);
+    CHECK(list != NULL, "recreating %s failed", name);
+    CHECK(capframex_pids_lookup(pids, 77) == CAPFRAMEX_PID_LAYER, "recreated list not followed");
+
+    capframex_pids_close(pids);
+    if (list) {
+        munmap(list, sizeof(SharedPidList));
+        close(fd);
+    }
+    shm_unlink(name);
+}
+
+int main(void) {
+    test_seqlock_stress();
+    test_reader_library();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("pid list: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef CAPFRAMEX_TEST_CHECK_H
+#define CAPFRAMEX_TEST_CHECK_H
+
+#include <stdio.h>
+
+// Failed checks so far. A test reports a failure but keeps going, so one run
+// shows every check that broke; main() turns the count into the exit code.
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+#endif // CAPFRAMEX_TEST_CHECK_H